@@ -0,0 +1,101 @@
+/*
+ * File:	arena.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "arena.h"
+
+struct ArenaBlockStruct {
+  struct ArenaBlockStruct *next;
+  size_t size; //number of bytes in data
+  size_t used; //number of bytes handed out
+  char data[];
+};
+
+typedef struct ArenaBlockStruct ArenaBlock;
+
+static ArenaBlock *arena = NULL; //most recent block first
+
+//Allocates a block with room for at least size bytes
+static ArenaBlock *newBlock(size_t size) {
+  ArenaBlock *block = (ArenaBlock *) malloc(sizeof(ArenaBlock) + size);
+
+  if(block == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+
+  return block;
+}
+
+//Returns size bytes that stay valid until lineArenaReset()
+void *lineArenaAlloc(size_t size) {
+  size = (size + 7) & ~(size_t) 7; //keep the next allocation aligned
+
+  if(arena == NULL || arena->size - arena->used < size) {
+    ArenaBlock *block = newBlock(size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+    block->next = arena;
+    arena = block;
+  }
+  arena->used += size;
+
+  return arena->data + arena->used - size;
+}
+
+//Reads fd until end of file into the arena
+//Returns the NUL terminated text and stores its length in len
+char *lineArenaRead(int fd, size_t *len) {
+  ArenaBlock *block = newBlock(ARENA_BLOCK_SIZE);
+  ssize_t n;
+
+  while(1) {
+    //Keep one byte for the terminating NUL
+    if(block->size - block->used < 2) {
+      block->size *= 2;
+      block = (ArenaBlock *) realloc(block, sizeof(ArenaBlock) + block->size);
+      if(block == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    n = read(fd, block->data + block->used, block->size - block->used - 1);
+    if(n > 0) {
+      block->used += n;
+    }
+    else if(n == 0 || errno != EINTR) {
+      break;
+    }
+  }
+  block->data[block->used] = '\0';
+  *len = block->used;
+
+  //Full blocks go behind the current one so that small allocations can still use it
+  block->used = block->size;
+  if(arena == NULL) {
+    arena = block;
+  }
+  else {
+    block->next = arena->next;
+    arena->next = block;
+  }
+
+  return block->data;
+}
+
+//Frees everything allocated since the last reset
+void lineArenaReset() {
+  while(arena != NULL) {
+    ArenaBlock *next = arena->next;
+    free(arena);
+    arena = next;
+  }
+}
@@ -0,0 +1,21 @@
+/*
+ * File:	arena.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Memory for text produced while a command line is parsed and
+		expanded, such as the output of command substitutions. The
+		tokens of the command line may point into it, so it lives
+		until the next command line is parsed.
+
+   Note:	Blocks are never moved once a token can point into them.
+		lineArenaRead() grows its block with realloc() while
+		reading and only then links it into the arena.
+*/
+
+#define ARENA_BLOCK_SIZE (64 * 1024) //initial size of a block
+
+void *lineArenaAlloc(size_t size);
+char *lineArenaRead(int fd, size_t *len);
+void lineArenaReset();
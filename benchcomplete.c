@@ -0,0 +1,120 @@
+/*
+ * File:	benchcomplete.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Benchmark Tab completion on a PATH of 10,000 executables and
+		a directory of 100,000 files, and check that files created
+		after the first completion are completed without reading
+		the directories again.
+
+   Usage:	benchcomplete [directory]
+		The files are created on the first run in "completetree".
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "complete.h"
+
+#define STR_SIZE 1024
+#define N_COMMANDS 10000
+#define N_FILES 100000
+#define N_RUNS 10000
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Creates n empty files dir/prefixNNNNNN with the given mode
+void generateFiles(char *dir, char *prefix, int n, mode_t mode) {
+  char path[STR_SIZE];
+
+  mkdir(dir, 0755);
+  for(int i = 0; i < n; i++) {
+    snprintf(path, sizeof(path), "%s/%s%06d", dir, prefix, i);
+    int fd = open(path, O_WRONLY | O_CREAT, mode);
+    if(fd < 0) {
+      perror(path);
+      exit(1);
+    }
+    close(fd);
+  }
+}
+
+//Times N_RUNS completions of word, returns microseconds per completion
+double timeCompletion(char *word, int command, int *n_matches) {
+  char suffix[STR_SIZE];
+  double start = now();
+
+  for(int i = 0; i < N_RUNS; i++) {
+    *n_matches = completeWord(word, command, suffix, sizeof(suffix));
+  }
+
+  return (now() - start) / N_RUNS * 1e6;
+}
+
+int main(int argc, char *argv[]) {
+  char *dir = argc > 1 ? argv[1] : "completetree";
+  char bin[STR_SIZE];
+  char files[STR_SIZE];
+  char path[STR_SIZE];
+  char suffix[STR_SIZE];
+  int n;
+
+  snprintf(bin, sizeof(bin), "%s/bin", dir);
+  snprintf(files, sizeof(files), "%s/files", dir);
+  mkdir(dir, 0755);
+  if(access(bin, F_OK) != 0) {
+    generateFiles(bin, "cmd", N_COMMANDS, 0755);
+  }
+  if(access(files, F_OK) != 0) {
+    generateFiles(files, "file", N_FILES, 0644);
+  }
+  if(realpath(bin, path) == NULL || chdir(files) != 0) {
+    perror(dir);
+    return 1;
+  }
+  setenv("PATH", path, 1);
+
+  double start = now();
+  completeWord("cmd", 1, suffix, sizeof(suffix));
+  completeWord("file", 0, suffix, sizeof(suffix));
+  printf("first completion, reading %d commands and %d files: %.1f ms\n", N_COMMANDS, N_FILES, (now() - start) * 1e3);
+
+  double us = timeCompletion("cmd00", 1, &n);
+  printf("command \"cmd00\":       %6.2f us (%d matches)\n", us, n);
+  us = timeCompletion("cmd004217", 1, &n);
+  printf("command \"cmd004217\":   %6.2f us (%d matches)\n", us, n);
+  us = timeCompletion("file0", 0, &n);
+  printf("file \"file0\":          %6.2f us (%d matches)\n", us, n);
+  us = timeCompletion("file099998", 0, &n);
+  printf("file \"file099998\":     %6.2f us (%d matches)\n", us, n);
+
+  //New names must be completed through the inotify events alone
+  int fd = open("newfile", O_WRONLY | O_CREAT, 0644);
+  close(fd);
+  snprintf(path, sizeof(path), "%s/newcmd", bin);
+  fd = open(path, O_WRONLY | O_CREAT, 0755);
+  close(fd);
+  int n_file = completeWord("newf", 0, suffix, sizeof(suffix));
+  int n_cmd = completeWord("newc", 1, suffix, sizeof(suffix));
+  printf("created files completed: %s\n", n_file == 1 && n_cmd == 1 ? "yes" : "no");
+  unlink("newfile");
+  unlink(path);
+  n_file = completeWord("newf", 0, suffix, sizeof(suffix));
+  n_cmd = completeWord("newc", 1, suffix, sizeof(suffix));
+  printf("deleted files forgotten: %s\n", n_file == 0 && n_cmd == 0 ? "yes" : "no");
+
+  return 0;
+}
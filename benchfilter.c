@@ -0,0 +1,160 @@
+/*
+ * File:	benchfilter.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Compare the throughput of the filters grep -F, head, wc and
+		cut run by the shell itself and of the programs, on a
+		generated text file of a given size.
+
+   Usage:	benchfilter [size in MiB]
+		Run from the directory containing main. The file is
+		/tmp/benchfilter.txt, kept for the next run. The program
+		is run by naming it with its path, e.g. /usr/bin/grep,
+		which the shell never runs itself. The output goes to a
+		pipe read by the benchmark.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define FILE_NAME "/tmp/benchfilter.txt"
+#define LINE_SIZE 1024
+
+extern char **environ;
+
+static char *lines[] = {
+  "grep -F needle " FILE_NAME,
+  "grep -Fc delta " FILE_NAME,
+  "grep -Fv a " FILE_NAME,
+  "wc -l " FILE_NAME,
+  "head -n 1000000000 " FILE_NAME,
+  "cut -d : -f 2 " FILE_NAME,
+  "cut -d : -f 3- " FILE_NAME,
+  "cat " FILE_NAME " | grep -F needle",
+  NULL
+};
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Writes a file of size bytes of lines like "4711:gamma:beta:77:delta alpha"
+void makeFile(off_t size) {
+  char *words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "iota", "kappa", "lambda", "mu"};
+  char line[LINE_SIZE];
+  struct stat buf;
+  off_t written = 0;
+
+  if(stat(FILE_NAME, &buf) == 0 && buf.st_size == size) {
+    return;
+  }
+  FILE *fp = fopen(FILE_NAME, "w");
+  if(fp == NULL) {
+    perror(FILE_NAME);
+    exit(1);
+  }
+  srand(1);
+  for(long i = 0; written < size; i++) {
+    int len = snprintf(line, sizeof(line), "%ld:%s:%s:%d:%s %s%s\n", i, words[rand() % 12], words[rand() % 12], rand() % 1000,
+                       words[rand() % 12], words[rand() % 12], rand() % 100000 == 0 ? " needle" : "");
+    if(written + len > size) {
+      len = size - written;
+      line[len - 1] = '\n';
+    }
+    fwrite(line, 1, len, fp);
+    written += len;
+  }
+  fclose(fp);
+}
+
+//Returns the path of a program found through PATH, to be freed
+char *findProgram(char *name) {
+  char path[LINE_SIZE];
+  char *dirs = strdup(getenv("PATH") != NULL ? getenv("PATH") : "/usr/bin:/bin");
+
+  for(char *dir = strtok(dirs, ":"); dir != NULL; dir = strtok(NULL, ":")) {
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if(access(path, X_OK) == 0) {
+      free(dirs);
+      return strdup(path);
+    }
+  }
+  free(dirs);
+
+  return strdup(name);
+}
+
+//Runs a command line with main, reads its output and returns the seconds it took
+double runLine(char *line, long *out_bytes) {
+  char *argv[] = {"./main", "--no-snapshot", "--no-prefetch", "-c", line, NULL};
+  posix_spawn_file_actions_t actions;
+  char buf[65536];
+  int fds[2];
+  pid_t pid;
+  ssize_t n;
+
+  if(pipe(fds) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+  double start = now();
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  close(fds[1]);
+  *out_bytes = 0;
+  while((n = read(fds[0], buf, sizeof(buf))) > 0) {
+    *out_bytes += n;
+  }
+  waitpid(pid, NULL, 0);
+  double seconds = now() - start;
+  close(fds[0]);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  long mib = argc > 1 ? atol(argv[1]) : 1024;
+  char external[LINE_SIZE];
+  long shell_out, program_out;
+
+  makeFile((off_t) mib * 1024 * 1024);
+  runLine("cat " FILE_NAME, &shell_out); //into the page cache
+  printf("%ld MiB in %s, MiB/s of input\n", mib, FILE_NAME);
+  printf("%-44s %10s %10s %8s\n", "", "shell", "program", "");
+  for(int i = 0; lines[i] != NULL; i++) {
+    //The same line with the filter named by its path
+    char *filter = strstr(lines[i], "| ") != NULL ? strstr(lines[i], "| ") + 2 : lines[i];
+    char name[32];
+    sscanf(filter, "%31s", name);
+    char *path = findProgram(name);
+    snprintf(external, sizeof(external), "%.*s%s%s", (int) (filter - lines[i]), lines[i], path, filter + strlen(name));
+    free(path);
+
+    double shell = runLine(lines[i], &shell_out);
+    double program = runLine(external, &program_out);
+    printf("%-44s %10.0f %10.0f %7.1fx%s\n", lines[i], mib / shell, mib / program, program / shell,
+           shell_out == program_out ? "" : " (output differs)");
+  }
+
+  return 0;
+}
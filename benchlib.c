@@ -0,0 +1,84 @@
+/*
+ * File:	benchlib.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Compare the command lines per second run with system() and
+		popen(), which start /bin/sh for each line, and with
+		myshRun() of libmyshell, which starts the commands itself.
+
+   Usage:	benchlib [number of runs [command line]]
+		The command line should write little, its output is
+		discarded or captured.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libmyshell.h"
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000;
+  char *line = argc > 2 ? argv[2] : "echo hello | tr a-z A-Z | wc -c";
+  char discard[1024];
+  char buf[4096];
+  MyShell *sh = myshCreate(0);
+  MyShell *capture = myshCreate(MYSH_CAPTURE);
+
+  if(sh == NULL || capture == NULL) {
+    perror("myshCreate");
+    return 1;
+  }
+  snprintf(discard, sizeof(discard), "%s > /dev/null", line);
+  printf("%d runs of \"%s\"\n", n, line);
+
+  double start = now();
+  for(int i = 0; i < n; i++) {
+    system(discard);
+  }
+  double system_rate = n / (now() - start);
+
+  start = now();
+  for(int i = 0; i < n; i++) {
+    myshRun(sh, discard);
+  }
+  double run_rate = n / (now() - start);
+
+  start = now();
+  for(int i = 0; i < n; i++) {
+    FILE *fp = popen(line, "r");
+    while(fread(buf, 1, sizeof(buf), fp) > 0) {
+    }
+    pclose(fp);
+  }
+  double popen_rate = n / (now() - start);
+
+  start = now();
+  for(int i = 0; i < n; i++) {
+    myshRun(capture, line);
+  }
+  double capture_rate = n / (now() - start);
+
+  printf("system():             %8.0f lines per second\n", system_rate);
+  printf("myshRun():            %8.0f lines per second (%+.0f%%)\n", run_rate, 100 * (run_rate / system_rate - 1));
+  printf("popen():              %8.0f lines per second\n", popen_rate);
+  printf("myshRun(), captured:  %8.0f lines per second (%+.0f%%)\n", capture_rate, 100 * (capture_rate / popen_rate - 1));
+  if(myshError(capture)[0] != '\0') {
+    printf("last error: %s\n", myshError(capture));
+  }
+  myshDestroy(sh);
+  myshDestroy(capture);
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * File:	benchppipe.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Measure the throughput of "ppipe -j N -- command" with 1, 2,
+		4 and 8 workers against the command run on its own.
+
+   Usage:	benchppipe [MiB of input [command args]]
+		Run from the directory containing main. The command is
+		"gzip -1" by default.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define INPUT_PATH "/tmp/benchppipe.txt"
+#define STR_SIZE 1024
+#define BUF_SIZE (64 * 1024)
+
+extern char **environ;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Writes a file of mib MiB of log-like lines
+void makeInput(int mib) {
+  FILE *fp = fopen(INPUT_PATH, "w");
+  long size = (long) mib * 1024 * 1024;
+  long written = 0;
+  unsigned seed = 1;
+
+  if(fp == NULL) {
+    perror(INPUT_PATH);
+    exit(1);
+  }
+  for(long i = 0; written < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    written += fprintf(fp, "%ld 2026-10-19T12:%02u:%02u host%u GET /item/%u status=%u bytes=%u\n", i, seed % 60, (seed >> 8) % 60, (seed >> 4) % 16, seed % 100000, 200 + (seed >> 12) % 4 * 100, seed % 65536);
+  }
+  fclose(fp);
+}
+
+//Runs "main -c line", reads its output and returns the seconds it took
+//The output goes to a pipe rather than /dev/null, which grep and others notice
+double timeRun(char *line) {
+  posix_spawn_file_actions_t actions;
+  char *argv[] = {"./main", "-c", line, NULL};
+  char buf[BUF_SIZE];
+  double start = now();
+  int fds[2];
+  pid_t pid;
+
+  if(pipe(fds) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  close(fds[1]);
+  while(read(fds[0], buf, sizeof(buf)) > 0) {
+  }
+  close(fds[0]);
+  waitpid(pid, NULL, 0);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return now() - start;
+}
+
+int main(int argc, char *argv[]) {
+  int mib = argc > 1 ? atoi(argv[1]) : 256;
+  char *command = argc > 2 ? argv[2] : "gzip -1";
+  char line[STR_SIZE];
+  int workers[] = {1, 2, 4, 8};
+
+  makeInput(mib);
+  printf("%d MiB through \"%s\", %ld CPUs\n", mib, command, sysconf(_SC_NPROCESSORS_ONLN));
+
+  snprintf(line, sizeof(line), "cat %s | %s", INPUT_PATH, command);
+  printf("alone:        %8.1f MiB/s\n", mib / timeRun(line));
+  for(int i = 0; i < 4; i++) {
+    snprintf(line, sizeof(line), "cat %s | ppipe -j %d -- %s", INPUT_PATH, workers[i], command);
+    printf("ppipe -j %d:   %8.1f MiB/s\n", workers[i], mib / timeRun(line));
+  }
+
+  unlink(INPUT_PATH);
+
+  return 0;
+}
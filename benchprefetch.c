@@ -0,0 +1,85 @@
+/*
+ * File:	benchprefetch.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Time a command line whose later commands start from a cold
+		page cache, with and without the prefetching of their
+		programs and libraries while the first command runs.
+
+   Usage:	benchprefetch [number of runs [command line]]
+		Run from the directory containing main, as root: the page
+		cache is dropped before each run through
+		/proc/sys/vm/drop_caches.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Writes back dirty pages and drops the page cache
+void dropCaches() {
+  sync();
+  int fd = open("/proc/sys/vm/drop_caches", O_WRONLY);
+  if(fd < 0 || write(fd, "3\n", 2) != 2) {
+    perror("/proc/sys/vm/drop_caches");
+    exit(1);
+  }
+  close(fd);
+}
+
+//Runs argv on a cold page cache and returns the seconds it took
+double timeCold(char *argv[]) {
+  posix_spawn_file_actions_t actions;
+  pid_t pid;
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+  dropCaches();
+  double start = now();
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  waitpid(pid, NULL, 0);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return now() - start;
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 5;
+  char *line = argc > 2 ? argv[2] : "sleep 0.5 ; cmake --version ; gcc --version ; git --version ; perl -e 1 ; curl --version";
+  char *off_argv[] = {"./main", "--no-prefetch", "-c", line, NULL};
+  char *on_argv[] = {"./main", "-c", line, NULL};
+  double off = 0, on = 0;
+
+  //Alternate, so that both see the same disk
+  for(int i = 0; i < n; i++) {
+    off += timeCold(off_argv);
+    on += timeCold(on_argv);
+  }
+  printf("%d cold runs of \"%s\"\n", n, line);
+  printf("no prefetch: %8.1f ms per run\n", off / n * 1e3);
+  printf("prefetch:    %8.1f ms per run\n", on / n * 1e3);
+
+  return 0;
+}
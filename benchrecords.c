@@ -0,0 +1,110 @@
+/*
+ * File:	benchrecords.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Compare pipelines of the record stages with the text
+		pipelines doing about the same with grep, cut and sort.
+
+   Usage:	benchrecords [number of records]
+		Run from the directory containing main. The text pipelines
+		are run by /bin/sh, as main takes "," for a space.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define INPUT_PATH "/tmp/benchrecords.csv"
+#define STR_SIZE 1024
+#define BUF_SIZE (64 * 1024)
+
+extern char **environ;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Runs "shell -c line", reads its output and returns the seconds it took
+//The output goes to a pipe rather than /dev/null, which grep and others notice
+double timeRun(char *shell, char *line) {
+  posix_spawn_file_actions_t actions;
+  char *argv[] = {shell, "-c", line, NULL};
+  char buf[BUF_SIZE];
+  double start = now();
+  int fds[2];
+  pid_t pid;
+
+  if(pipe(fds) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  close(fds[1]);
+  while(read(fds[0], buf, sizeof(buf)) > 0) {
+  }
+  close(fds[0]);
+  waitpid(pid, NULL, 0);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return now() - start;
+}
+
+//Writes a CSV file of n web server log records
+void makeInput(long n) {
+  FILE *fp = fopen(INPUT_PATH, "w");
+  unsigned seed = 1;
+  int statuses[] = {200, 200, 200, 304, 404, 500};
+
+  if(fp == NULL) {
+    perror(INPUT_PATH);
+    exit(1);
+  }
+  fprintf(fp, "id,host,status,bytes,path\n");
+  for(long i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    fprintf(fp, "%ld,host%u,%d,%u,/item/%u\n", i, (seed >> 16) % 64, statuses[(seed >> 8) % 6], seed % 100000, (seed >> 4) % 100000);
+  }
+  fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+  long n = argc > 1 ? atol(argv[1]) : 2000000;
+  char *records[] = {
+    "from-csv < " INPUT_PATH " | where status = 500 | select host bytes",
+    "from-csv < " INPUT_PATH " | sort-by bytes",
+    "from-csv < " INPUT_PATH " | where status = 500 | sort-by bytes | select host bytes"
+  };
+  char *text[] = {
+    "grep ,500, < " INPUT_PATH " | cut -d , -f 2,4",
+    "sort -s -t , -k 4,4n < " INPUT_PATH,
+    "grep ,500, < " INPUT_PATH " | sort -s -t , -k 4,4n | cut -d , -f 2,4"
+  };
+
+  makeInput(n);
+  printf("%ld records\n", n);
+  for(int i = 0; i < 3; i++) {
+    printf("%s\n  records: %8.3f s\n", records[i], timeRun("./main", records[i]));
+    printf("%s\n  text:    %8.3f s\n", text[i], timeRun("/bin/sh", text[i]));
+  }
+
+  unlink(INPUT_PATH);
+
+  return 0;
+}
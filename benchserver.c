@@ -0,0 +1,103 @@
+/*
+ * File:	benchserver.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Compare running short command lines with a cold "main -c"
+		against a client of a warm "main --server".
+
+   Usage:	benchserver [number of runs [command line]]
+		Run from the directory containing main and client.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SOCKET_PATH "/tmp/benchserver.sock"
+
+extern char **environ;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Runs argv n times with stdout on /dev/null and returns the seconds per run
+double timeRuns(char *argv[], int n) {
+  posix_spawn_file_actions_t actions;
+  double start = now();
+  pid_t pid;
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  for(int i = 0; i < n; i++) {
+    if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+      perror(argv[0]);
+      exit(1);
+    }
+    waitpid(pid, NULL, 0);
+  }
+  posix_spawn_file_actions_destroy(&actions);
+
+  return (now() - start) / n;
+}
+
+//Waits until the server accepts connections
+void waitForServer() {
+  struct sockaddr_un addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, SOCKET_PATH);
+  for(int i = 0; i < 1000; i++) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(connect(sock, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+      close(sock);
+      return;
+    }
+    close(sock);
+    usleep(1000);
+  }
+  fprintf(stderr, "server did not start\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000;
+  char *line = argc > 2 ? argv[2] : "true";
+  char *server_argv[] = {"./main", "--server", SOCKET_PATH, NULL};
+  char *cold_argv[] = {"./main", "-c", line, NULL};
+  char *warm_argv[] = {"./client", SOCKET_PATH, line, NULL};
+  pid_t server;
+
+  unlink(SOCKET_PATH);
+  if(posix_spawn(&server, server_argv[0], NULL, NULL, server_argv, environ) != 0) {
+    perror(server_argv[0]);
+    return 1;
+  }
+  waitForServer();
+
+  printf("%d runs of \"%s\"\n", n, line);
+  printf("main -c: %8.1f us per run\n", timeRuns(cold_argv, n) * 1e6);
+  printf("client:  %8.1f us per run\n", timeRuns(warm_argv, n) * 1e6);
+
+  kill(server, SIGKILL);
+  waitpid(server, NULL, 0);
+  unlink(SOCKET_PATH);
+
+  return 0;
+}
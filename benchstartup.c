@@ -0,0 +1,238 @@
+/*
+ * File:	benchstartup.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Time the start of the shell, from exec() to the first
+		prompt, and to the end of the first command found in the
+		last of many PATH directories, with and without a snapshot
+		of the PATH lookup cache.
+
+   Usage:	benchstartup [number of runs [budget in ms [PATH directories]]]
+		Run from the directory containing main. The directories
+		are created in "startuptree". Exits with 1 if the 99th
+		percentile to the first prompt is over the budget.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define STR_SIZE 1024
+#define TREE "startuptree"
+#define SNAPSHOT TREE "/snapshot"
+#define N_FILES 50 //non-matching executables per PATH directory
+#define SOCKET_PATH "/tmp/benchstartup.sock"
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Creates n_dirs directories of executables, the last with "benchcmd" in it, and returns the PATH
+char *generateTree(int n_dirs) {
+  char path[STR_SIZE];
+  char *env = (char *) malloc(n_dirs * STR_SIZE);
+  char *cwd = getcwd(NULL, 0);
+
+  env[0] = '\0';
+  mkdir(TREE, 0755);
+  for(int d = 0; d < n_dirs; d++) {
+    snprintf(path, sizeof(path), "%s/%s/d%03d", cwd, TREE, d);
+    mkdir(path, 0755);
+    strcat(env, d == 0 ? "" : ":");
+    strcat(env, path);
+    for(int i = 0; i < N_FILES; i++) {
+      snprintf(path, sizeof(path), "%s/d%03d/cmd%03d", TREE, d, i);
+      close(open(path, O_WRONLY | O_CREAT, 0755));
+    }
+  }
+  snprintf(path, sizeof(path), "%s/d%03d/benchcmd", TREE, n_dirs - 1);
+  symlink("/bin/true", path);
+  free(cwd);
+
+  return env;
+}
+
+//Reads from fd until the prompt "% " has been read
+void readPrompt(int fd) {
+  char buf[STR_SIZE];
+  char last = '\0';
+  ssize_t n;
+
+  while((n = read(fd, buf, sizeof(buf))) > 0) {
+    if(buf[n - 1] == ' ' && (n > 1 ? buf[n - 2] : last) == '%') {
+      return;
+    }
+    last = buf[n - 1];
+  }
+  fprintf(stderr, "main exited before its prompt\n");
+  exit(1);
+}
+
+//Starts main with argv, stores the seconds to the first prompt and to the end of "benchcmd"
+void timeStart(char *argv[], char *envp[], double *prompt, double *command) {
+  posix_spawn_file_actions_t actions;
+  int in[2], out[2];
+  pid_t pid;
+
+  if(pipe(in) != 0 || pipe(out) != 0) {
+    perror("pipe");
+    exit(1);
+  }
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, in[1]);
+  posix_spawn_file_actions_addclose(&actions, out[0]);
+
+  double start = now();
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, envp) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  close(in[0]);
+  close(out[1]);
+  readPrompt(out[0]);
+  *prompt = now() - start;
+  write(in[1], "benchcmd\n", 9);
+  readPrompt(out[0]);
+  *command = now() - start;
+
+  close(in[1]); //end of input, main exits and writes the snapshot
+  close(out[0]);
+  waitpid(pid, NULL, 0);
+  posix_spawn_file_actions_destroy(&actions);
+}
+
+//Starts "main --server" with argv, returns the seconds to the end of the first command of a client
+double timeServer(char *argv[], char *envp[]) {
+  char *client_argv[] = {"./client", SOCKET_PATH, "benchcmd", NULL};
+  posix_spawn_file_actions_t actions;
+  struct sockaddr_un addr;
+  pid_t server, client;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, SOCKET_PATH);
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  unlink(SOCKET_PATH);
+
+  double start = now();
+  if(posix_spawn(&server, argv[0], &actions, NULL, argv, envp) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  while(1) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    int ready = connect(sock, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+    close(sock);
+    if(ready) {
+      break;
+    }
+    usleep(20);
+  }
+  if(posix_spawn(&client, client_argv[0], &actions, NULL, client_argv, envp) != 0) {
+    perror(client_argv[0]);
+    exit(1);
+  }
+  waitpid(client, NULL, 0);
+  double seconds = now() - start;
+
+  kill(server, SIGKILL);
+  waitpid(server, NULL, 0);
+  unlink(SOCKET_PATH);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return seconds;
+}
+
+int compareDouble(const void *a, const void *b) {
+  double x = *(double *) a, y = *(double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+//Runs main n times and prints the percentiles, returns the 99th percentile to the prompt
+double report(char *label, char *argv[], char *envp[], int n) {
+  double *prompt = (double *) malloc(n * sizeof(double));
+  double *command = (double *) malloc(n * sizeof(double));
+
+  for(int i = 0; i < n; i++) {
+    timeStart(argv, envp, &(prompt[i]), &(command[i]));
+  }
+  qsort(prompt, n, sizeof(double), compareDouble);
+  qsort(command, n, sizeof(double), compareDouble);
+  double p99 = prompt[n * 99 / 100];
+  printf("%-12s first prompt %7.3f ms p50 %7.3f ms p99   first command %7.3f ms p50 %7.3f ms p99\n", label,
+         prompt[n / 2] * 1e3, p99 * 1e3, command[n / 2] * 1e3, command[n * 99 / 100] * 1e3);
+  free(prompt);
+  free(command);
+
+  return p99;
+}
+
+//Starts the server n times and prints the percentiles
+void reportServer(char *label, char *argv[], char *envp[], int n) {
+  double *first = (double *) malloc(n * sizeof(double));
+
+  for(int i = 0; i < n; i++) {
+    first[i] = timeServer(argv, envp);
+  }
+  qsort(first, n, sizeof(double), compareDouble);
+  printf("%-12s server to first command %7.3f ms p50 %7.3f ms p99\n", label, first[n / 2] * 1e3, first[n * 99 / 100] * 1e3);
+  free(first);
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 200;
+  double budget = argc > 2 ? atof(argv[2]) : 5;
+  int n_dirs = argc > 3 ? atoi(argv[3]) : 100;
+  char *cold_argv[] = {"./main", "--no-snapshot", NULL};
+  char *warm_argv[] = {"./main", "--snapshot", SNAPSHOT, NULL};
+  char *cold_server_argv[] = {"./main", "--no-snapshot", "--server", SOCKET_PATH, NULL};
+  char *warm_server_argv[] = {"./main", "--snapshot", SNAPSHOT "_server", "--server", SOCKET_PATH, NULL};
+  char *envp[] = {NULL, NULL};
+  double prompt, command;
+
+  if(n < 1 || n_dirs < 1) {
+    fprintf(stderr, "usage: %s [runs [budget_ms [path_dirs]]]\n", argv[0]);
+    return 2;
+  }
+  char *dirs = generateTree(n_dirs);
+  char *full = (char *) malloc(strlen(dirs) + 6);
+  sprintf(full, "PATH=%s", dirs);
+  envp[0] = full;
+
+  unlink(SNAPSHOT);
+  timeStart(warm_argv, envp, &prompt, &command); //writes the snapshot
+  unlink(SNAPSHOT "_server");
+  timeServer(warm_server_argv, envp); //writes the snapshot of every executable
+
+  printf("%d runs, %d PATH directories of %d executables, benchcmd in the last\n", n, n_dirs, N_FILES);
+  report("no snapshot", cold_argv, envp, n);
+  double p99 = report("snapshot", warm_argv, envp, n);
+  reportServer("no snapshot", cold_server_argv, envp, n);
+  reportServer("snapshot", warm_server_argv, envp, n);
+  printf("budget %.1f ms: %s\n", budget, p99 <= budget / 1e3 ? "met" : "exceeded");
+
+  free(dirs);
+  free(full);
+
+  return p99 <= budget / 1e3 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/*
+ * File:	benchwalk.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Benchmark the "**" walker against a single-threaded nftw()
+		walk, the same work "find" would do, on a generated tree.
+
+   Usage:	benchwalk [directory [number of files]]
+		The tree is created on the first run and reused afterwards.
+		The default is one million files in "walktree".
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ftw.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "walk.h"
+
+#define STR_SIZE 1024
+#define FILES_PER_DIR 1000
+#define SUBDIRS_PER_DIR 10
+
+static long nftw_matches = 0;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Creates dir/dNNN/sNN/fNNNN.c and .h files until n_files exist
+void generateTree(char *dir, long n_files) {
+  char path[STR_SIZE];
+  long made = 0;
+
+  mkdir(dir, 0755);
+  for(int d = 0; made < n_files; d++) {
+    snprintf(path, sizeof(path), "%s/d%03d", dir, d);
+    mkdir(path, 0755);
+    for(int s = 0; s < SUBDIRS_PER_DIR && made < n_files; s++) {
+      snprintf(path, sizeof(path), "%s/d%03d/s%02d", dir, d, s);
+      mkdir(path, 0755);
+      for(int f = 0; f < FILES_PER_DIR && made < n_files; f++, made++) {
+        snprintf(path, sizeof(path), "%s/d%03d/s%02d/f%04d.%c", dir, d, s, f, f % 2 ? 'h' : 'c');
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+          perror(path);
+          exit(1);
+        }
+        close(fd);
+      }
+    }
+  }
+}
+
+//Counts the ".c" files visited by nftw()
+int countMatch(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+  if(type == FTW_F && fnmatch("*.c", path + ftw->base, FNM_PERIOD) == 0) {
+    nftw_matches++;
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  char *dir = argc > 1 ? argv[1] : "walktree";
+  long n_files = argc > 2 ? atol(argv[2]) : 1000000;
+  char pattern[STR_SIZE];
+  char **paths;
+  struct stat st;
+  double start;
+
+  if(stat(dir, &st) != 0) {
+    printf("Generating %ld files in %s\n", n_files, dir);
+    start = now();
+    generateTree(dir, n_files);
+    printf("Generated in %.2f s\n", now() - start);
+  }
+
+  start = now();
+  nftw(dir, countMatch, 64, FTW_PHYS);
+  printf("nftw:     %ld matches in %.3f s\n", nftw_matches, now() - start);
+
+  snprintf(pattern, sizeof(pattern), "%s/**/*.c", dir);
+  start = now();
+  int n = walkGlob(pattern, &paths);
+  printf("walkGlob: %d matches in %.3f s (sorted)\n", n, now() - start);
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * File:	benchzygote.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Compare the commands per second the shell runs when it
+		forks them itself in executeCommand() and when the zygote
+		started by --zygote does.
+
+   Usage:	benchzygote [number of commands [command line]]
+		Run from the directory containing main. The command lines
+		are written to the standard input of main.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+//Returns the current time in seconds
+double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Runs main with argv on n copies of line and returns the commands per second
+double spawnRate(char *argv[], char *line, int n) {
+  posix_spawn_file_actions_t actions;
+  char name[] = "/tmp/benchzygoteXXXXXX";
+  int fd = mkstemp(name);
+  pid_t pid;
+
+  if(fd < 0) {
+    perror("mkstemp");
+    exit(1);
+  }
+  unlink(name);
+  FILE *fp = fdopen(fd, "w+");
+  for(int i = 0; i < n; i++) {
+    fprintf(fp, "%s\n", line);
+  }
+  fflush(fp);
+  lseek(fd, 0, SEEK_SET);
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fd, STDIN_FILENO);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  double start = now();
+  if(posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+    perror(argv[0]);
+    exit(1);
+  }
+  waitpid(pid, NULL, 0);
+  double seconds = now() - start;
+  posix_spawn_file_actions_destroy(&actions);
+  fclose(fp);
+
+  return n / seconds;
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 2000;
+  char *line = argc > 2 ? argv[2] : "true";
+  char *fork_argv[] = {"./main", NULL};
+  char *zygote_argv[] = {"./main", "--zygote", NULL};
+
+  printf("%d runs of \"%s\"\n", n, line);
+  printf("fork:   %8.0f commands per second\n", spawnRate(fork_argv, line, n));
+  printf("zygote: %8.0f commands per second\n", spawnRate(zygote_argv, line, n));
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * File:	client.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Run a command line in a shell started with --server, as if
+		"main -c" had been run in the current directory and
+		environment.
+
+   Usage:	client socket command line...
+
+   Return:	The exit status of the command line, or 127 if the server
+		cannot be reached.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+
+extern char **environ;
+
+//Appends a NUL terminated string to the payload
+void appendString(char **payload, size_t *used, size_t *size, char *s) {
+  size_t len = strlen(s) + 1;
+
+  if(*used + len > *size) {
+    *size = (*used + len) * 2;
+    *payload = (char *) realloc(*payload, *size);
+    if(*payload == NULL) {
+      perror("realloc");
+      exit(127);
+    }
+  }
+  memcpy(*payload + *used, s, len);
+  *used += len;
+}
+
+int main(int argc, char *argv[]) {
+  struct sockaddr_un addr;
+  char cwd[PATH_MAX];
+  char *payload = NULL;
+  size_t used = 0;
+  size_t size = 0;
+  int sock;
+
+  if(argc < 3) {
+    fprintf(stderr, "Usage: %s socket command line...\n", argv[0]);
+    return 127;
+  }
+
+  //The command line is made of the remaining arguments
+  size_t line_len = 0;
+  for(int i = 2; i < argc; i++) {
+    line_len += strlen(argv[i]) + 1;
+  }
+  char *line = (char *) malloc(line_len + 1);
+  line[0] = '\0';
+  for(int i = 2; i < argc; i++) {
+    strcat(line, argv[i]);
+    if(i < argc - 1) {
+      strcat(line, " ");
+    }
+  }
+  if(getcwd(cwd, sizeof(cwd)) == NULL) {
+    perror("getcwd");
+    return 127;
+  }
+  appendString(&payload, &used, &size, line);
+  appendString(&payload, &used, &size, cwd);
+  for(char **env = environ; *env != NULL; env++) {
+    appendString(&payload, &used, &size, *env);
+  }
+
+  if(strlen(argv[1]) >= sizeof(addr.sun_path) || (sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    perror(argv[1]);
+    return 127;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, argv[1]);
+  if(connect(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    perror(argv[1]);
+    return 127;
+  }
+
+  //Send the request with stdin, stdout and stderr attached
+  ServerRequest req = {SERVER_MAGIC, (uint32_t) used};
+  int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  char control[CMSG_SPACE(sizeof(fds))];
+  struct iovec iov = {&req, sizeof(req)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  memset(control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  if(sendmsg(sock, &msg, 0) != sizeof(req)) {
+    perror("sendmsg");
+    return 127;
+  }
+  for(size_t sent = 0; sent < used;) {
+    ssize_t n = write(sock, payload + sent, used - sent);
+    if(n < 0 && errno != EINTR) {
+      perror("write");
+      return 127;
+    }
+    sent += n > 0 ? n : 0;
+  }
+
+  //Wait for the exit status
+  int32_t status;
+  size_t got = 0;
+  while(got < sizeof(status)) {
+    ssize_t n = read(sock, (char *) &status + got, sizeof(status) - got);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      fprintf(stderr, "%s: connection closed\n", argv[1]);
+      return 127;
+    }
+    got += n;
+  }
+
+  return status;
+}
@@ -13,7 +13,7 @@
 //Return 0 otherwise
 int separator(char *token) {
   int i = 0;
-  char *commandSeparators[] = {pipeSep, conSep, seqSep, NULL};
+  char *commandSeparators[] = {pipeSep, conSep, seqSep, fanSep, NULL};
 
   while(commandSeparators[i] != NULL) {
     if(strcmp(commandSeparators[i], token) == 0) {
@@ -32,11 +32,18 @@ void fillCommandStructure(Command *cp, int first, int last, char *sep) {
   cp->sep = sep;
 }
 
-//Assigns redirection file name if "<" or ">" is found
+//Return 1 if the token redirects stdin, i.e. is "<", "<<" or "<<<"
+//Return 0 otherwise
+int isStdinRedirection(char *token) {
+  return strcmp(token, inFile) == 0 || strcmp(token, inHereDoc) == 0 || strcmp(token, inHereStr) == 0;
+}
+
+//Assigns redirection file name if "<", "<<", "<<<" or ">" is found
 void searchRedirection(char *token[], Command *cp) {
   for(int i = cp->first; i <= cp->last + 1; i++) {
-    if(strcmp(token[i], "<") == 0) { //if "<" found
+    if(isStdinRedirection(token[i])) { //if "<", "<<" or "<<<" found
       cp->stdin_file = token[i + 1]; //next token is assigned to stdin_file
+      cp->stdin_op = token[i];
     }
     else if(strcmp(token[i], ">") == 0) { //if ">" found
       cp->stdout_file = token[i + 1]; //next token is assigned to stdout_file
@@ -45,21 +52,22 @@ void searchRedirection(char *token[], Command *cp) {
 }
 
 //Builds the command line argument vector for execvp function
-void buildCommandArgumentArray(char *token[], Command *cp) {
+//Returns 0, or -1 if there is no memory for it
+int buildCommandArgumentArray(char *token[], Command *cp) {
   int n = (cp->last - cp->first + 1) + 1; //number of tokens in the command                                            //the element in argv must be a NULL
 
   //Re-allocate memory for argument vector
-  cp->argv = (char **) realloc(cp->argv, sizeof(char *) * n);
-  if(cp->argv == NULL) {
-    perror("realloc");
-    exit(1);
+  char **argv = (char **) realloc(cp->argv, sizeof(char *) * n);
+  if(argv == NULL) {
+    return -1;
   }
+  cp->argv = argv;
 
   //Build the argument vector
   int i;
   int k = 0;
   for(i = cp->first; i <= cp->last; i++) {
-    if(strcmp(token[i], ">") == 0 || strcmp(token[i], "<") == 0) {
+    if(strcmp(token[i], ">") == 0 || isStdinRedirection(token[i])) {
       i++; //skip off the std in/out redirection
     }
     else {
@@ -68,6 +76,20 @@ void buildCommandArgumentArray(char *token[], Command *cp) {
     }
   }
   cp->argv[k] = NULL;
+
+  return 0;
+}
+
+//Rebuilds the redirections and argument vector after the tokens of a command changed
+void buildCommand(char *token[], Command *cp) {
+  cp->stdin_file = NULL;
+  cp->stdin_op = NULL;
+  cp->stdout_file = NULL;
+  searchRedirection(token, cp);
+  if(buildCommandArgumentArray(token, cp) < 0) {
+    perror("realloc");
+    exit(1);
+  }
 }
 
 //Returns the number of commands
@@ -102,21 +124,44 @@ int separateCommands(char *token[], Command command[]) {
   int last; //points to the last tokens of a command
   char *sep; //command separator at the end of a command
   int c = 0;
+  int in_fan = 0; //1 between "|{" and "}"
   for(i = 0; i < nTokens; i++) {
     last = i;
-    if(separator(token[i])) {
+    //"}" ends the last command of a fan-out, which takes the separator after it
+    if(in_fan && strcmp(token[i], fanEnd) == 0) {
+      sep = token[i + 1]; //there is one, a ";" was added after a last "}"
+      if(first == last || (strcmp(sep, seqSep) != 0 && strcmp(sep, conSep) != 0)) {
+        return -5;
+      }
+      fillCommandStructure(&(command[c]), first, last, sep);
+      c++;
+      i++;
+      first = i + 1;
+      in_fan = 0;
+    }
+    else if(separator(token[i])) {
       sep = token[i];
       if(first == last) { //two consecutive separators
         return -2;
       }
+      if(in_fan && (strcmp(sep, conSep) == 0 || strcmp(sep, fanSep) == 0)) {
+        return -5;
+      }
+      if(in_fan && strcmp(sep, seqSep) == 0) {
+        sep = fanNextSep;
+      }
+      in_fan |= strcmp(sep, fanSep) == 0;
       fillCommandStructure(&(command[c]), first, last, sep);
       c++;
       first = i + 1;
     }
   }
+  if(in_fan) { //no "}"
+    return -5;
+  }
 
   //Check the last token of the last command
-  if(strcmp(token[last], pipeSep) == 0) { //last token is pipe separator
+  if(strcmp(token[last], pipeSep) == 0 || strcmp(token[last], fanSep) == 0) { //last token is pipe separator
     return -4;
   }
 
@@ -126,7 +171,9 @@ int separateCommands(char *token[], Command command[]) {
   //Handle standard in/out redirection and build command line argument vector
   for(i = 0; i < nCommands; i++) {
     searchRedirection(token, &(command[i]));
-    buildCommandArgumentArray(token, &(command[i]));
+    if(buildCommandArgumentArray(token, &(command[i])) < 0) {
+      return -6;
+    }
   }
 
   return nCommands;
@@ -140,6 +187,10 @@ void initialiseCommand(Command command[]) {
     command[i].sep = NULL;
     command[i].argv = NULL;
     command[i].stdin_file = NULL;
+    command[i].stdin_op = NULL;
+    command[i].stdin_doc = NULL;
+    command[i].subst_fds = NULL;
+    command[i].n_subst_fds = 0;
     command[i].stdout_file = NULL;
   }
 }
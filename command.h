@@ -16,7 +16,12 @@
 			   by more than one command separator
 			b) -3, the first token is a command separator
 			c) -4, the last command is followed by command
-			   separator "|"
+			   separator "|" or "|{"
+			d) -5, a fan-out "|{ ... }" is not closed, is nested,
+			   contains "&" or is not followed by ";", "&" or
+			   nothing
+	   	4) -6, if there is no memory for the argument vector of a
+		   command.
 
    Assume:	The array "command" must have at least MAX_NUM_COMMANDS number
 		of elements
@@ -26,6 +31,9 @@
 		   followed by ";".
 		2) If return value, nCommands >= 0, set command[nCommands] to
 		   NULL,
+		3) In "producer |{ c1 ; c2 }", the producer is followed by
+		   "|{", c1 by fanNextSep and c2 by the separator after "}".
+		   The token following c2 is then "}" instead of a separator.
 */
 
 #define MAX_NUM_COMMANDS 1000
@@ -34,15 +42,29 @@
 #define pipeSep "|" //pipe separator "|"
 #define conSep "&" //concurrent execution separator "&"
 #define seqSep ";" //sequential execution separator ";"
+#define fanSep "|{" //fan-out separator "|{", the output goes to every command up to "}"
+#define fanEnd "}" //end of the commands of a fan-out
+#define fanNextSep "{;}" //separates the commands of a fan-out, never typed by the user
+
+//Redirection operators for stdin
+#define inFile "<" //read stdin from a file
+#define inHereDoc "<<" //read stdin from the following lines, up to a delimiter
+#define inHereStr "<<<" //read stdin from the next token
 
 struct CommandStruct {
   int first; //index to the first token in the array "token" of the command
   int last; //index to the first token in the array "token" of the command
   char *sep; //the command separator that follows the command
-             //must be one of "|", "&", and ";"
+             //must be one of "|", "&", ";", "|{" and fanNextSep
   char **argv; //an array of tokens that forms a command
   char *stdin_file; //if not NULL, points to the file name for stdin
-                    //redirection
+                    //redirection, or the delimiter or text of a here-document
+                    //or here-string
+  char *stdin_op; //the stdin redirection operator, "<", "<<" or "<<<"
+  char *stdin_doc; //if not NULL, the text of a here-document or here-string
+  int *subst_fds; //pipes of the process substitutions in the command, kept
+                  //open across exec
+  int n_subst_fds; //number of elements in subst_fds
   char *stdout_file; //if not NULL, points to the file name for stdout
                      //redirection
 };
@@ -50,6 +72,8 @@ struct CommandStruct {
 typedef struct CommandStruct Command; //command type
 
 int separateCommands(char *token[], Command command[]);
+void buildCommand(char *token[], Command *cp);
+int isStdinRedirection(char *token);
 void initialiseCommand(Command command[]);
 void printCommandSequence(char *token[], Command command[]);
 void printStructCommand(char *token[], Command command[]);
@@ -0,0 +1,742 @@
+/*
+ * File:	complete.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "complete.h"
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#define EVENT_BUF_SIZE (64 * 1024)
+#define SCREEN_WIDTH 80
+
+struct ListingEntryStruct {
+  char *name;
+  int is_dir;
+};
+
+typedef struct ListingEntryStruct ListingEntry;
+
+struct ListingStruct {
+  char *dir; //absolute path name of the directory, or NULL if the slot is free
+  int wd; //inotify watch of the directory, or -1
+  int stale; //1 if the directory must be read again
+  int executables; //1 if only executables are listed, for the PATH directories
+  int n_entries;
+  int size;
+  ListingEntry *entries; //sorted by name
+  unsigned long last_used;
+};
+
+typedef struct ListingStruct Listing;
+
+struct TrieNodeStruct {
+  int child; //first child, or -1
+  int sibling; //next sibling, or -1, the siblings are sorted by c
+  int count; //number of names ending at or below this node
+  int end; //number of PATH directories holding the name ending here
+  unsigned char c;
+};
+
+typedef struct TrieNodeStruct TrieNode;
+
+//Builtin commands, completed like the executables
+static char *builtins[] = {"cd", "exit", "from-csv", "jobout", "onchange", "ppipe", "prompt", "perfstat", "pwd", "select", "sort-by", "stats", "to-csv", "where", NULL};
+
+static int inotify_fd = -1;
+static unsigned long clock_tick = 0; //orders the uses of the file listings
+
+static char *path_value = NULL; //PATH the command names were read from
+static Listing *path_dirs = NULL;
+static int n_path_dirs = 0;
+static Listing files[MAX_DIR_LISTINGS];
+
+static TrieNode *trie = NULL; //node 0 is the root
+static int n_nodes = 0;
+static int trie_size = 0;
+
+//Returns a new trie node for character c
+static int newNode(unsigned char c) {
+  if(n_nodes == trie_size) {
+    trie_size = trie_size == 0 ? 4096 : trie_size * 2;
+    trie = (TrieNode *) realloc(trie, sizeof(TrieNode) * trie_size);
+    if(trie == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  trie[n_nodes].child = -1;
+  trie[n_nodes].sibling = -1;
+  trie[n_nodes].count = 0;
+  trie[n_nodes].end = 0;
+  trie[n_nodes].c = c;
+
+  return n_nodes++;
+}
+
+//Returns the child of node for character c, adding it if create is 1
+//Returns -1 if there is no such child and create is 0
+static int trieChild(int node, unsigned char c, int create) {
+  int prev = -1;
+  int child = trie[node].child;
+
+  while(child != -1 && trie[child].c < c) {
+    prev = child;
+    child = trie[child].sibling;
+  }
+  if(child != -1 && trie[child].c == c) {
+    return child;
+  }
+  if(!create) {
+    return -1;
+  }
+  int added = newNode(c); //may move the array, so link by index only
+  trie[added].sibling = child;
+  if(prev == -1) {
+    trie[node].child = added;
+  }
+  else {
+    trie[prev].sibling = added;
+  }
+
+  return added;
+}
+
+//Returns the node of prefix, or -1 if no name starts with it
+static int trieFind(char *prefix) {
+  int node = 0;
+
+  for(unsigned char *p = (unsigned char *) prefix; *p != '\0' && node != -1; p++) {
+    node = trieChild(node, *p, 0);
+  }
+  if(node == -1 || trie[node].count == 0) {
+    return -1;
+  }
+
+  return node;
+}
+
+//Adds delta to the count of every node on the path of name
+static void trieCount(char *name, int delta) {
+  int node = 0;
+
+  trie[0].count += delta;
+  for(unsigned char *p = (unsigned char *) name; *p != '\0'; p++) {
+    node = trieChild(node, *p, 0);
+    trie[node].count += delta;
+  }
+}
+
+//Adds a name found in one more PATH directory
+static void trieInsert(char *name) {
+  int node = 0;
+
+  if(n_nodes == 0) {
+    newNode('\0');
+  }
+  for(unsigned char *p = (unsigned char *) name; *p != '\0'; p++) {
+    node = trieChild(node, *p, 1);
+  }
+  if(trie[node].end++ == 0) {
+    trieCount(name, 1);
+  }
+}
+
+//Removes a name found in one PATH directory less
+static void trieRemove(char *name) {
+  int node = 0;
+
+  for(unsigned char *p = (unsigned char *) name; *p != '\0' && node != -1; p++) {
+    node = trieChild(node, *p, 0);
+  }
+  if(node != -1 && trie[node].end > 0 && --trie[node].end == 0) {
+    trieCount(name, -1);
+  }
+}
+
+//Compares two entries of a listing by name
+static int compareEntries(const void *a, const void *b) {
+  return strcmp(((ListingEntry *) a)->name, ((ListingEntry *) b)->name);
+}
+
+//Returns the index of the first entry whose name is not less than name
+static int lowerBound(Listing *l, char *name) {
+  int lo = 0;
+  int hi = l->n_entries;
+
+  while(lo < hi) {
+    int mid = (lo + hi) / 2;
+    if(strcmp(l->entries[mid].name, name) < 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+//Returns the index of the first entry whose name does not start with prefix,
+//searching from the index first
+static int prefixEnd(Listing *l, char *prefix, int first) {
+  size_t len = strlen(prefix);
+  int lo = first;
+  int hi = l->n_entries;
+
+  while(lo < hi) {
+    int mid = (lo + hi) / 2;
+    if(strncmp(l->entries[mid].name, prefix, len) <= 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+//Returns the index of name in the listing, or -1
+static int findEntry(Listing *l, char *name) {
+  int i = lowerBound(l, name);
+
+  return i < l->n_entries && strcmp(l->entries[i].name, name) == 0 ? i : -1;
+}
+
+//Adds name to the listing, keeping it sorted
+//Returns 1 if it was added, 0 if it was already there
+static int insertEntry(Listing *l, char *name, int is_dir) {
+  int i = lowerBound(l, name);
+
+  if(i < l->n_entries && strcmp(l->entries[i].name, name) == 0) {
+    return 0;
+  }
+  if(l->n_entries == l->size) {
+    l->size = l->size == 0 ? 64 : l->size * 2;
+    l->entries = (ListingEntry *) realloc(l->entries, sizeof(ListingEntry) * l->size);
+    if(l->entries == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  memmove(l->entries + i + 1, l->entries + i, sizeof(ListingEntry) * (l->n_entries - i));
+  l->entries[i].name = strdup(name);
+  l->entries[i].is_dir = is_dir;
+  l->n_entries++;
+
+  return 1;
+}
+
+//Removes name from the listing
+//Returns 1 if it was removed, 0 if it was not there
+static int removeEntry(Listing *l, char *name) {
+  int i = findEntry(l, name);
+
+  if(i < 0) {
+    return 0;
+  }
+  free(l->entries[i].name);
+  memmove(l->entries + i, l->entries + i + 1, sizeof(ListingEntry) * (l->n_entries - i - 1));
+  l->n_entries--;
+
+  return 1;
+}
+
+//Frees the entries of a listing
+static void clearListing(Listing *l) {
+  for(int i = 0; i < l->n_entries; i++) {
+    free(l->entries[i].name);
+  }
+  free(l->entries);
+  l->entries = NULL;
+  l->n_entries = 0;
+  l->size = 0;
+}
+
+//Returns 1 if a listing other than l uses the watch wd
+static int isWatchShared(Listing *l, int wd) {
+  for(int i = 0; i < n_path_dirs; i++) {
+    if(&(path_dirs[i]) != l && path_dirs[i].wd == wd) {
+      return 1;
+    }
+  }
+  for(int i = 0; i < MAX_DIR_LISTINGS; i++) {
+    if(&(files[i]) != l && files[i].dir != NULL && files[i].wd == wd) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Stops watching the directory of a listing
+static void unwatchListing(Listing *l) {
+  if(l->wd >= 0 && !isWatchShared(l, l->wd)) {
+    inotify_rm_watch(inotify_fd, l->wd);
+  }
+  l->wd = -1;
+}
+
+//Returns 1 if the file name of directory dfd is an executable, for a PATH listing
+static int isExecutable(int dfd, char *name) {
+  struct stat st;
+
+  return fstatat(dfd, name, &st, 0) == 0 && S_ISREG(st.st_mode) && (st.st_mode & 0111) != 0;
+}
+
+//Returns 1 if the entry is a directory, following symbolic links
+static int isDirEntry(int dfd, struct dirent *d) {
+  struct stat st;
+
+  if(d->d_type != DT_UNKNOWN && d->d_type != DT_LNK) {
+    return d->d_type == DT_DIR;
+  }
+
+  return fstatat(dfd, d->d_name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+//Reads the directory of a listing and starts watching it
+//The watch is added first so that no change is missed while reading
+static void readListing(Listing *l) {
+  DIR *dp;
+  struct dirent *d;
+
+  unwatchListing(l);
+  clearListing(l);
+  l->stale = 0;
+  if(inotify_fd < 0) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  }
+  if(inotify_fd >= 0) {
+    l->wd = inotify_add_watch(inotify_fd, l->dir, WATCH_MASK);
+  }
+  if((dp = opendir(l->dir)) == NULL) {
+    return;
+  }
+  int dfd = dirfd(dp);
+  while((d = readdir(dp)) != NULL) {
+    if(strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) {
+      continue;
+    }
+    if(l->n_entries == l->size) {
+      l->size = l->size == 0 ? 64 : l->size * 2;
+      l->entries = (ListingEntry *) realloc(l->entries, sizeof(ListingEntry) * l->size);
+      if(l->entries == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    if(l->executables) {
+      if(d->d_type == DT_DIR || !isExecutable(dfd, d->d_name)) {
+        continue;
+      }
+      l->entries[l->n_entries].is_dir = 0;
+    }
+    else {
+      l->entries[l->n_entries].is_dir = isDirEntry(dfd, d);
+    }
+    l->entries[l->n_entries].name = strdup(d->d_name);
+    l->n_entries++;
+  }
+  closedir(dp);
+  qsort(l->entries, l->n_entries, sizeof(ListingEntry), compareEntries);
+}
+
+//Forgets the command names of the PATH directories
+static void clearPath() {
+  for(int i = 0; i < n_path_dirs; i++) {
+    unwatchListing(&(path_dirs[i]));
+    clearListing(&(path_dirs[i]));
+    free(path_dirs[i].dir);
+  }
+  free(path_dirs);
+  path_dirs = NULL;
+  n_path_dirs = 0;
+  free(path_value);
+  path_value = NULL;
+  n_nodes = 0;
+}
+
+//Reads the command names of every PATH directory into the trie
+static void readPath(char *path) {
+  char *copy = strdup(path);
+  int n = 1;
+
+  for(char *p = path; *p != '\0'; p++) {
+    n += *p == ':';
+  }
+  path_dirs = (Listing *) calloc(n, sizeof(Listing));
+  if(path_dirs == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  path_value = strdup(path);
+  newNode('\0');
+  for(int i = 0; builtins[i] != NULL; i++) {
+    trieInsert(builtins[i]);
+  }
+
+  char *save = NULL;
+  for(char *dir = strtok_r(copy, ":", &save); dir != NULL; dir = strtok_r(NULL, ":", &save)) {
+    int seen = 0;
+    for(int i = 0; i < n_path_dirs; i++) {
+      seen |= strcmp(path_dirs[i].dir, dir) == 0;
+    }
+    if(seen) {
+      continue; //a directory listed twice would count its names twice
+    }
+    Listing *l = &(path_dirs[n_path_dirs++]);
+    l->dir = strdup(dir);
+    l->wd = -1;
+    l->executables = 1;
+    readListing(l);
+    for(int i = 0; i < l->n_entries; i++) {
+      trieInsert(l->entries[i].name);
+    }
+  }
+  free(copy);
+}
+
+//Applies a change of the file name of a directory to one of its listings
+static void applyEvent(Listing *l, struct inotify_event *ev) {
+  if(ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+    l->stale = 1;
+    return;
+  }
+  if(ev->len == 0) {
+    return;
+  }
+  if(!l->executables) {
+    if(ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+      insertEntry(l, ev->name, (ev->mask & IN_ISDIR) != 0);
+    }
+    else if(ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+      removeEntry(l, ev->name);
+    }
+    return;
+  }
+
+  //A file of a PATH directory is a command name while it is executable
+  int listed = findEntry(l, ev->name) >= 0;
+  int executable = 0;
+  if(ev->mask & (IN_CREATE | IN_MOVED_TO | IN_ATTRIB)) {
+    int dfd = open(l->dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dfd >= 0) {
+      executable = isExecutable(dfd, ev->name);
+      close(dfd);
+    }
+  }
+  if(executable && !listed) {
+    insertEntry(l, ev->name, 0);
+    trieInsert(ev->name);
+  }
+  else if(!executable && listed) {
+    removeEntry(l, ev->name);
+    trieRemove(ev->name);
+  }
+}
+
+//Reads the pending inotify events without blocking and applies them
+static void readEvents() {
+  char buf[EVENT_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t n;
+
+  if(inotify_fd < 0) {
+    return;
+  }
+  while((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+    for(char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event *) p)->len) {
+      struct inotify_event *ev = (struct inotify_event *) p;
+
+      //Some events were lost, read every directory again when it is used
+      if(ev->mask & IN_Q_OVERFLOW) {
+        free(path_value);
+        path_value = NULL;
+        for(int i = 0; i < MAX_DIR_LISTINGS; i++) {
+          files[i].stale = 1;
+        }
+        continue;
+      }
+      for(int i = 0; i < n_path_dirs; i++) {
+        if(path_dirs[i].wd == ev->wd) {
+          applyEvent(&(path_dirs[i]), ev);
+          if(path_dirs[i].stale) {
+            free(path_value); //a PATH directory went away, read PATH again
+            path_value = NULL;
+          }
+        }
+      }
+      for(int i = 0; i < MAX_DIR_LISTINGS; i++) {
+        if(files[i].dir != NULL && files[i].wd == ev->wd) {
+          applyEvent(&(files[i]), ev);
+        }
+      }
+    }
+  }
+}
+
+//Makes the trie match the current PATH
+static void updatePath() {
+  char *path = getenv("PATH");
+
+  if(path == NULL) {
+    path = "";
+  }
+  if(path_value == NULL || strcmp(path_value, path) != 0) {
+    clearPath();
+    readPath(path);
+  }
+}
+
+//Returns the listing of directory dir, reading it if it is not cached
+static Listing *getListing(char *dir) {
+  Listing *l = NULL;
+
+  for(int i = 0; i < MAX_DIR_LISTINGS && l == NULL; i++) {
+    if(files[i].dir != NULL && strcmp(files[i].dir, dir) == 0) {
+      l = &(files[i]);
+    }
+  }
+  if(l == NULL) {
+    //Take a free slot or the one used least recently
+    l = &(files[0]);
+    for(int i = 0; i < MAX_DIR_LISTINGS && l->dir != NULL; i++) {
+      if(files[i].dir == NULL || files[i].last_used < l->last_used) {
+        l = &(files[i]);
+      }
+    }
+    if(l->dir != NULL) {
+      unwatchListing(l);
+      clearListing(l);
+      free(l->dir);
+    }
+    l->dir = strdup(dir);
+    l->wd = -1;
+    l->executables = 0;
+    l->stale = 1;
+  }
+  if(l->stale) {
+    readListing(l);
+  }
+  l->last_used = ++clock_tick;
+
+  return l;
+}
+
+//Finds the listing and the name prefix of a file name word
+//Returns the listing, or NULL if the directory of the word does not exist
+static Listing *splitFileWord(char *word, char **base) {
+  char dir[PATH_MAX];
+  char real[PATH_MAX];
+  char *slash = strrchr(word, '/');
+
+  if(slash == NULL) {
+    strcpy(dir, ".");
+    *base = word;
+  }
+  else if(slash == word) {
+    strcpy(dir, "/");
+    *base = word + 1;
+  }
+  else {
+    if(slash - word >= PATH_MAX) {
+      return NULL;
+    }
+    memcpy(dir, word, slash - word);
+    dir[slash - word] = '\0';
+    *base = slash + 1;
+  }
+  if(realpath(dir, real) == NULL) {
+    return NULL;
+  }
+
+  return getListing(real);
+}
+
+//Finds the entries of a listing starting with base
+//Hidden files are left out unless base starts with "."
+//The matches are the entries first to last - 1 without hidden_first to hidden_last - 1
+static void findMatches(Listing *l, char *base, int *first, int *last, int *hidden_first, int *hidden_last) {
+  *first = lowerBound(l, base);
+  *last = prefixEnd(l, base, *first);
+  *hidden_first = *hidden_last = *first;
+  if(base[0] == '\0') {
+    *hidden_first = lowerBound(l, ".");
+    *hidden_last = prefixEnd(l, ".", *hidden_first);
+  }
+}
+
+//Returns the number of characters at the start of a and b that are the same
+static size_t commonLength(char *a, char *b) {
+  size_t n = 0;
+
+  while(a[n] != '\0' && a[n] == b[n]) {
+    n++;
+  }
+
+  return n;
+}
+
+//Stores the characters after len of name, up to n, and the ending in suffix
+static void setSuffix(char *suffix, int size, char *name, size_t len, size_t n, char *ending) {
+  if(n < len || n - len + strlen(ending) + 1 > (size_t) size) {
+    suffix[0] = '\0';
+    return;
+  }
+  memcpy(suffix, name + len, n - len);
+  strcpy(suffix + n - len, ending);
+}
+
+//Completes a command name from the trie
+static int completeCommand(char *word, char *suffix, int size) {
+  char name[NAME_MAX + 1];
+  size_t len = strlen(word);
+  int node;
+
+  updatePath();
+  if(len > NAME_MAX || (node = trieFind(word)) < 0) {
+    suffix[0] = '\0';
+    return 0;
+  }
+  int n_matches = trie[node].count;
+
+  //Follow the nodes while the names do not branch
+  strcpy(name, word);
+  size_t n = len;
+  while(trie[node].end == 0 && n < NAME_MAX) {
+    int next = -1;
+    int n_children = 0;
+    for(int child = trie[node].child; child != -1; child = trie[child].sibling) {
+      if(trie[child].count > 0) {
+        next = child;
+        n_children++;
+      }
+    }
+    if(n_children != 1) {
+      break;
+    }
+    node = next;
+    name[n++] = trie[node].c;
+  }
+  name[n] = '\0';
+  setSuffix(suffix, size, name, len, n, n_matches == 1 ? " " : "");
+
+  return n_matches;
+}
+
+//Completes a file name from the listing of its directory
+static int completeFile(char *word, char *suffix, int size) {
+  char *base;
+  int first, last, hidden_first, hidden_last;
+  Listing *l = splitFileWord(word, &base);
+
+  suffix[0] = '\0';
+  if(l == NULL) {
+    return 0;
+  }
+  findMatches(l, base, &first, &last, &hidden_first, &hidden_last);
+  int n_matches = (last - first) - (hidden_last - hidden_first);
+  if(n_matches == 0) {
+    return 0;
+  }
+
+  //The names are sorted, so the first and the last have the common prefix of all
+  int lo = hidden_first > first ? first : hidden_last;
+  int hi = hidden_last < last ? last - 1 : hidden_first - 1;
+  ListingEntry *e = &(l->entries[lo]);
+  size_t n = commonLength(e->name, l->entries[hi].name);
+  char *ending = n_matches > 1 ? "" : (e->is_dir ? "/" : " ");
+  setSuffix(suffix, size, e->name, strlen(base), n, ending);
+
+  return n_matches;
+}
+
+//Completes word, a command name if command is 1 or a file name otherwise
+int completeWord(char *word, int command, char *suffix, int size) {
+  readEvents();
+  if(command && strchr(word, '/') == NULL) {
+    return completeCommand(word, suffix, size);
+  }
+
+  return completeFile(word, suffix, size);
+}
+
+//Collects the names below node of the trie, name holds the first n characters
+static void collectNames(int node, char *name, size_t n, char *names[], int *n_names) {
+  if(trie[node].end > 0 && *n_names < MAX_PRINT_COMPLETIONS) {
+    name[n] = '\0';
+    names[(*n_names)++] = strdup(name);
+  }
+  for(int child = trie[node].child; child != -1 && *n_names < MAX_PRINT_COMPLETIONS; child = trie[child].sibling) {
+    if(trie[child].count > 0 && n < NAME_MAX) {
+      name[n] = trie[child].c;
+      collectNames(child, name, n + 1, names, n_names);
+    }
+  }
+}
+
+//Prints the names matching word in columns below the command line
+void printCompletions(char *word, int command) {
+  char *names[MAX_PRINT_COMPLETIONS];
+  int n_names = 0;
+  int n_matches = 0;
+
+  readEvents();
+  if(command && strchr(word, '/') == NULL) {
+    char name[NAME_MAX + 1];
+    int node;
+    updatePath();
+    if(strlen(word) <= NAME_MAX && (node = trieFind(word)) >= 0) {
+      n_matches = trie[node].count;
+      strcpy(name, word);
+      collectNames(node, name, strlen(word), names, &n_names);
+    }
+  }
+  else {
+    char *base;
+    int first, last, hidden_first, hidden_last;
+    Listing *l = splitFileWord(word, &base);
+    if(l != NULL) {
+      findMatches(l, base, &first, &last, &hidden_first, &hidden_last);
+      n_matches = (last - first) - (hidden_last - hidden_first);
+      for(int i = first; i < last && n_names < MAX_PRINT_COMPLETIONS; i++) {
+        if(i >= hidden_first && i < hidden_last) {
+          continue;
+        }
+        ListingEntry *e = &(l->entries[i]);
+        char *name = (char *) malloc(strlen(e->name) + 2);
+        strcpy(name, e->name);
+        strcat(name, e->is_dir ? "/" : "");
+        names[n_names++] = name;
+      }
+    }
+  }
+
+  //Print the names in columns as wide as the longest one
+  size_t width = 0;
+  for(int i = 0; i < n_names; i++) {
+    width = strlen(names[i]) > width ? strlen(names[i]) : width;
+  }
+  int n_columns = SCREEN_WIDTH / (width + 2) > 0 ? SCREEN_WIDTH / (width + 2) : 1;
+  printf("\n");
+  for(int i = 0; i < n_names; i++) {
+    int last = (i + 1) % n_columns == 0 || i == n_names - 1;
+    printf("%-*s%s", last ? 0 : (int) width + 2, names[i], last ? "\n" : "");
+    free(names[i]);
+  }
+  if(n_matches > n_names) {
+    printf("... and %d more\n", n_matches - n_names);
+  }
+}
@@ -0,0 +1,30 @@
+/*
+ * File:	complete.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Complete a command name from the executables of the PATH
+		directories, or a file name from the listing of its
+		directory.
+
+   Return:	completeWord() returns the number of names starting with
+		"word" and stores in "suffix" the characters that all of
+		them have after "word". If exactly one name matches, a "/"
+		is added for a directory and a space otherwise.
+
+   Note:	1) The command names are kept in a trie and the listings of
+		   the last MAX_DIR_LISTINGS directories in sorted arrays.
+		   Both are built when a completion first needs them and are
+		   then kept up to date with inotify events, which are read
+		   without blocking at every completion. A directory is read
+		   again only if the events overflowed.
+		2) printCompletions() prints at most MAX_PRINT_COMPLETIONS
+		   of the matching names.
+*/
+
+#define MAX_DIR_LISTINGS 8
+#define MAX_PRINT_COMPLETIONS 200
+
+int completeWord(char *word, int command, char *suffix, int size);
+void printCompletions(char *word, int command);
@@ -0,0 +1,339 @@
+/*
+ * File:	expand.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "arena.h"
+#include "expand.h"
+#include "job.h"
+
+#define STR_SIZE 1024
+
+//Returns 1 if the token contains a command substitution
+int hasSubstitution(char *token) {
+  return strstr(token, "$(") != NULL || strchr(token, '`') != NULL;
+}
+
+//Returns 1 if the token is a process substitution <(...) or >(...)
+int isProcessSubstitution(char *token) {
+  return (token[0] == '<' || token[0] == '>') && token[1] == '(' && token[strlen(token) - 1] == ')';
+}
+
+//Returns 1 if c separates the words of a command output
+static int isFieldDelimiter(char c) {
+  return c == ' ' || c == '\t' || c == '\n';
+}
+
+//Returns the length of the substitution starting at p, including $( ) or ` `
+static size_t substitutionLength(char *p) {
+  char *q = p;
+  int depth = 0;
+
+  if(*q == '`') {
+    q = strchr(p + 1, '`');
+    return q == NULL ? strlen(p) : (size_t) (q - p) + 1;
+  }
+  q++; //skip "$"
+  do {
+    if(*q == '(') {
+      depth++;
+    }
+    else if(*q == ')') {
+      depth--;
+    }
+    q++;
+  } while(*q != '\0' && depth > 0);
+
+  return q - p;
+}
+
+//Returns the number of commands if the line is only pwd commands separated by ";" or "&",
+//or 0 otherwise. Such a line is evaluated by the shell itself
+static int isPureBuiltin(char *line) {
+  char *token[MAX_NUM_TOKENS];
+  char *copy = (char *) lineArenaAlloc(strlen(line) + 1);
+  int n_tokens;
+  int first = 1; //the next token starts a command
+  int n_commands = 0;
+
+  strcpy(copy, line);
+  initialiseToken(token);
+  n_tokens = tokeniseWhiteSpace(copy, token);
+  if(n_tokens <= 0) {
+    return 0;
+  }
+  for(int i = 0; i < n_tokens; i++) {
+    if(strcmp(token[i], seqSep) == 0 || strcmp(token[i], conSep) == 0) {
+      first = 1;
+    }
+    else if(first && strcmp(token[i], "pwd") == 0) {
+      first = 0;
+      n_commands++;
+    }
+    else {
+      return 0; //an argument, a pipe or a redirection, run by a subshell
+    }
+  }
+
+  return n_commands;
+}
+
+//Runs a command line and returns its standard output, stored in the line arena
+static char *runSubstitution(char *line, size_t *len) {
+  int n_pwd = isPureBuiltin(line);
+  if(n_pwd > 0) {
+    char dir[STR_SIZE];
+    if(getcwd(dir, sizeof(dir)) == NULL) {
+      dir[0] = '\0';
+    }
+    size_t dir_len = strlen(dir);
+    char *out = (char *) lineArenaAlloc((dir_len + 1) * n_pwd + 1);
+    for(int i = 0; i < n_pwd; i++) {
+      memcpy(out + i * (dir_len + 1), dir, dir_len);
+      out[i * (dir_len + 1) + dir_len] = '\n';
+    }
+    *len = (dir_len + 1) * n_pwd;
+    out[*len] = '\0';
+    return out;
+  }
+
+  int p[2];
+  if(pipe(p) == -1) {
+    perror("pipe");
+    exit(1);
+  }
+  fflush(stdout); //the child must not print what the shell has buffered
+  pid_t pid;
+  if((pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  //Child process, runs the line like a subshell
+  if(pid == 0) {
+    char *input = strdup(line); //parseCommand() frees the arena the line is in
+
+    close(p[0]);
+    dup2(p[1], STDOUT_FILENO);
+    close(p[1]);
+    exit(runLine(input));
+  }
+  //Parent process
+  close(p[1]);
+  char *out = lineArenaRead(p[0], len);
+  close(p[0]);
+  while(waitpid(pid, NULL, 0) < 0 && errno == EINTR) { //SIGCHLD of another child
+  }
+
+  return out;
+}
+
+//Returns the text of a token with its substitutions replaced by their output
+static char *substituteToken(char *token) {
+  size_t len;
+  size_t n = substitutionLength(token);
+  int starts = (token[0] == '$' && token[1] == '(') || token[0] == '`';
+
+  //A token that is just one substitution uses the output where it was read
+  if(starts && token[n] == '\0') {
+    char *line = token[0] == '`' ? strndup(token + 1, n - 2) : strndup(token + 2, n - 3);
+    char *out = runSubstitution(line, &len);
+    free(line);
+    return out;
+  }
+
+  //Otherwise join the literal parts and the outputs in a new string
+  size_t size = STR_SIZE;
+  size_t used = 0;
+  char *text = (char *) malloc(size);
+  char *p = token;
+  if(text == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  while(*p != '\0') {
+    char *part = p;
+    size_t part_len = 1;
+    if((p[0] == '$' && p[1] == '(') || p[0] == '`') {
+      n = substitutionLength(p);
+      char *line = p[0] == '`' ? strndup(p + 1, n - 2) : strndup(p + 2, n - 3);
+      part = runSubstitution(line, &part_len);
+      free(line);
+      p += n;
+    }
+    else {
+      p++;
+    }
+    if(used + part_len + 1 > size) {
+      size = (used + part_len + 1) * 2;
+      text = (char *) realloc(text, size);
+      if(text == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    memcpy(text + used, part, part_len);
+    used += part_len;
+  }
+  text[used] = '\0';
+
+  char *out = (char *) lineArenaAlloc(used + 1);
+  memcpy(out, text, used + 1);
+  free(text);
+
+  return out;
+}
+
+//Starts the command of a process substitution without waiting for it
+//Returns the "/dev/fd/N" name of the pipe connected to it, stored in the line arena
+static char *startProcessSubstitution(char *token, Command *cp) {
+  int p[2];
+  int reader = token[0] == '<'; //the command writes, the shell reads
+
+  //Both ends are closed on exec, execArgv() keeps the end of cp open
+  if(pipe2(p, O_CLOEXEC) == -1) {
+    perror("pipe");
+    exit(1);
+  }
+  fflush(stdout);
+  pid_t pid;
+  if((pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  //Child process, runs the line like a subshell
+  if(pid == 0) {
+    char *input = strndup(token + 2, strlen(token) - 3);
+
+    dup2(reader ? p[1] : p[0], reader ? STDOUT_FILENO : STDIN_FILENO);
+    close(p[0]);
+    close(p[1]);
+    for(int i = 0; i < cp->n_subst_fds; i++) {
+      close(cp->subst_fds[i]); //earlier substitutions of the same command
+    }
+    exit(runLine(input));
+  }
+  //Parent process
+  addJob(pid, JOB_SUBSTITUTION, token);
+  close(reader ? p[1] : p[0]);
+  int fd = reader ? p[0] : p[1];
+
+  //Room for every token of the command is allocated with the first substitution
+  if(cp->subst_fds == NULL) {
+    cp->subst_fds = (int *) lineArenaAlloc(sizeof(int) * (cp->last - cp->first + 1));
+  }
+  cp->subst_fds[cp->n_subst_fds++] = fd;
+
+  char *name = (char *) lineArenaAlloc(32);
+  snprintf(name, 32, "/dev/fd/%d", fd);
+
+  return name;
+}
+
+//Closes the process substitution pipes of the commands first to last
+//The commands have been started, so only they need the pipes now
+void closeSubstitutions(Command command[], int first, int last) {
+  for(int i = first; i <= last; i++) {
+    for(int j = 0; j < command[i].n_subst_fds; j++) {
+      close(command[i].subst_fds[j]);
+    }
+    command[i].n_subst_fds = 0;
+  }
+}
+
+//Returns the number of words in text
+static int countFields(char *text) {
+  int n_fields = 0;
+
+  for(char *p = text; *p != '\0'; p++) {
+    if(!isFieldDelimiter(*p) && (p == text || isFieldDelimiter(p[-1]))) {
+      n_fields++;
+    }
+  }
+
+  return n_fields;
+}
+
+//Replaces token[t] by the words of text, splitting text in place
+//Returns the number of words, or -1 if the array "token" is too small
+static int spliceFields(char *token[], int t, char *text, int index, Command command[], int n_commands) {
+  int n_tokens = 0;
+  int n_fields = countFields(text);
+  int delta = n_fields - 1;
+
+  while(token[n_tokens] != NULL) {
+    n_tokens++;
+  }
+  if(n_tokens + delta > MAX_NUM_TOKENS - 1) {
+    return -1;
+  }
+
+  //Move the following tokens, including the terminating NULL
+  memmove(token + t + n_fields, token + t + 1, sizeof(char *) * (n_tokens - t));
+
+  //Split the text in place, every word ends where a delimiter was
+  int k = t;
+  for(char *p = text; *p != '\0'; p++) {
+    if(isFieldDelimiter(*p)) {
+      *p = '\0';
+    }
+    else if(p == text || p[-1] == '\0') {
+      token[k++] = p;
+    }
+  }
+
+  //Move the commands by the number of added tokens
+  for(int i = index; i < n_commands; i++) {
+    if(command[i].first > t) {
+      command[i].first += delta;
+    }
+    if(command[i].last >= t) {
+      command[i].last += delta;
+    }
+  }
+
+  return n_fields;
+}
+
+//Expands the substitutions in the commands of the job starting at index
+int expandJob(char *token[], int index, Command command[], int n_commands) {
+  int end = index;
+
+  while(end < n_commands - 1 && strcmp(command[end].sep, pipeSep) == 0) {
+    end++;
+  }
+  for(int i = index; i <= end; i++) {
+    int changed = 0;
+    for(int t = command[i].first; t <= command[i].last; t++) {
+      if(isProcessSubstitution(token[t])) {
+        token[t] = startProcessSubstitution(token[t], &(command[i]));
+        changed = 1;
+      }
+      else if(hasSubstitution(token[t])) {
+        int n_fields = spliceFields(token, t, substituteToken(token[t]), i, command, n_commands);
+        if(n_fields < 0) {
+          return -1;
+        }
+        t += n_fields - 1; //the words are not expanded again
+        changed = 1;
+      }
+    }
+    if(changed) {
+      buildCommand(token, &(command[i]));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * File:	expand.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Replace the command substitutions $(...) and `...` in the
+		tokens of a job by the output of the commands they contain,
+		and the process substitutions <(...) and >(...) by the name
+		of a pipe connected to the command they contain.
+
+   Return:	1) 0, if successful, or
+		2) -1, if the array "token" is too small for the expanded
+		   command line.
+
+   Note:	1) The output is split into words at spaces, tabs and
+		   newlines. The words are stored in the line arena and
+		   spliced into the array "token", so the tokens following
+		   them and the first/last indices of the following commands
+		   are moved accordingly.
+		2) A substitution containing only the builtin pwd is
+		   evaluated without creating a child process.
+		3) The command of a process substitution runs at the same
+		   time as the command using it and is added to the job
+		   table. The pipe is passed as "/dev/fd/N" and stays open
+		   across exec only in the command it was written in. The
+		   shell closes its end with closeSubstitutions() once the
+		   job has been started.
+*/
+
+int hasSubstitution(char *token);
+int isProcessSubstitution(char *token);
+int expandJob(char *token[], int index, Command command[], int n_commands);
+void closeSubstitutions(Command command[], int first, int last);
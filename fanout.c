@@ -0,0 +1,357 @@
+/*
+ * File:	fanout.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "job.h"
+#include "fanout.h"
+
+#define STR_SIZE 1024
+
+struct ConsumerStruct {
+  int fd; //write end of the pipe to the consumer, -1 once the consumer has gone
+  size_t size; //size of the pipe
+  char *backlog; //bytes a partial tee() did not give to the consumer
+  size_t start; //first byte of the backlog still to be written
+  size_t end; //end of the backlog
+};
+
+typedef struct ConsumerStruct Consumer;
+
+//Returns the index of the last command of the fan-out job starting at index,
+//and stores the index of the last command of the producer in fan
+//Returns -1 if the job is not a fan-out
+static int fanOutEnd(int index, Command command[], int n_commands, int *fan) {
+  int i = index;
+
+  while(i < n_commands - 1 && strcmp(command[i].sep, pipeSep) == 0) {
+    i++;
+  }
+  if(strcmp(command[i].sep, fanSep) != 0) {
+    return -1;
+  }
+  *fan = i++;
+  while(strcmp(command[i].sep, pipeSep) == 0 || strcmp(command[i].sep, fanNextSep) == 0) {
+    i++;
+  }
+
+  return i;
+}
+
+//Runs the commands first to last in a subshell with the given stdin and stdout,
+//-1 keeps the one of the shell. The other pipes of the job are closed in it
+static pid_t startSubshell(char *command_token[], Command command[], int first, int last, int in, int out, int fds[], int n_fds) {
+  pid_t pid;
+
+  if((pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if(pid == 0) {
+    char *prompt = "%";
+    char new_prompt[STR_SIZE];
+
+    if(in >= 0) {
+      dup2(in, STDIN_FILENO);
+    }
+    if(out >= 0) {
+      dup2(out, STDOUT_FILENO);
+    }
+    for(int i = 0; i < n_fds; i++) {
+      close(fds[i]);
+    }
+    command[last].sep = seqSep; //the commands form a job of their own
+    runCommands(command_token, command + first, last - first + 1, &prompt, new_prompt);
+    exit(lastStatus);
+  }
+
+  return pid;
+}
+
+//Closes the pipe of a consumer that has gone
+static void closeConsumer(Consumer *c) {
+  close(c->fd);
+  c->fd = -1;
+  c->start = c->end = 0;
+}
+
+//Writes as much of the backlog as the consumer takes without blocking
+static void drainBacklog(Consumer *c) {
+  while(c->start < c->end) {
+    ssize_t n = write(c->fd, c->backlog + c->start, c->end - c->start);
+    if(n > 0) {
+      c->start += n;
+    }
+    else if(n < 0 && errno == EAGAIN) {
+      return;
+    }
+    else if(n == 0 || errno != EINTR) {
+      closeConsumer(c);
+      return;
+    }
+  }
+  c->start = c->end = 0;
+}
+
+//Reads exactly len bytes of the input pipe, which holds at least that many
+static void readInput(int in, char *buf, size_t len) {
+  while(len > 0) {
+    ssize_t n = read(in, buf, len);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      return;
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+//Removes len bytes from the input pipe without copying them
+static void discardInput(int in, int null_fd, char *buf, size_t len) {
+  while(len > 0) {
+    ssize_t n = splice(in, NULL, null_fd, NULL, len, SPLICE_F_MOVE);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      readInput(in, buf, len); //splice() to /dev/null is not supported
+      return;
+    }
+    len -= n;
+  }
+}
+
+//Waits until the fds are ready for events, skipping the ones that are -1
+static void waitFds(int fds[], int n, short events) {
+  struct pollfd pfd[MAX_FAN_CONSUMERS];
+  int n_fds = 0;
+
+  for(int i = 0; i < n; i++) {
+    if(fds[i] >= 0) {
+      pfd[n_fds].fd = fds[i];
+      pfd[n_fds].events = events;
+      n_fds++;
+    }
+  }
+  if(n_fds > 0) {
+    while(poll(pfd, n_fds, -1) < 0 && errno == EINTR) {
+    }
+  }
+}
+
+//Copies the input pipe to every consumer until the input ends or every consumer has gone
+static void pump(int in, Consumer c[], int n) {
+  int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  int in_size = fcntl(in, F_GETPIPE_SZ);
+  char *buf = (char *) malloc(in_size);
+  int fds[MAX_FAN_CONSUMERS];
+  void (*old_handler)(int) = signal(SIGPIPE, SIG_IGN); //a consumer may exit early
+
+  if(buf == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  for(int i = 0; i < n; i++) {
+    c[i].backlog = (char *) malloc(in_size);
+    if(c[i].backlog == NULL) {
+      perror("malloc");
+      exit(1);
+    }
+    c[i].start = c[i].end = 0;
+  }
+
+  while(1) {
+    int n_open = 0;
+    int pending = 0;
+    for(int i = 0; i < n; i++) {
+      n_open += c[i].fd >= 0;
+      pending |= c[i].start < c[i].end;
+      fds[i] = c[i].start < c[i].end ? c[i].fd : -1;
+    }
+    if(n_open == 0) {
+      break;
+    }
+
+    //Finish the backlogs of the last step before starting another
+    if(pending) {
+      waitFds(fds, n, POLLOUT);
+      for(int i = 0; i < n; i++) {
+        if(c[i].start < c[i].end) {
+          drainBacklog(&(c[i]));
+        }
+      }
+      continue;
+    }
+
+    //Wait for input, then for room in every consumer pipe
+    waitFds(&in, 1, POLLIN);
+    int avail = 0;
+    if(ioctl(in, FIONREAD, &avail) < 0 || avail == 0) {
+      break; //the producer has finished
+    }
+    size_t len = avail < in_size ? avail : in_size;
+    for(int i = 0; i < n; i++) {
+      int used = 0;
+      if(c[i].fd < 0) {
+        continue;
+      }
+      ioctl(c[i].fd, FIONREAD, &used);
+      while(c[i].fd >= 0 && (size_t) used >= c[i].size) {
+        struct pollfd pfd = {c[i].fd, POLLOUT, 0};
+        while(poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+        }
+        if(pfd.revents & POLLERR) {
+          closeConsumer(&(c[i])); //the consumer has exited with its pipe full
+        }
+        else {
+          ioctl(c[i].fd, FIONREAD, &used);
+        }
+      }
+      if(c[i].fd >= 0 && c[i].size - used < len) {
+        len = c[i].size - used;
+      }
+    }
+
+    //Give the same bytes to every consumer, then remove them from the input
+    int copy = 0;
+    size_t teed[MAX_FAN_CONSUMERS];
+    for(int i = 0; i < n; i++) {
+      teed[i] = len;
+      if(c[i].fd < 0) {
+        continue;
+      }
+      ssize_t t;
+      while((t = tee(in, c[i].fd, len, 0)) < 0 && errno == EINTR) {
+      }
+      if(t < 0 && errno == EAGAIN) {
+        t = 0; //the pipe has bytes to spare but no free slot, the bytes go to the backlog
+      }
+      else if(t < 0) {
+        closeConsumer(&(c[i])); //the consumer has exited
+        continue;
+      }
+      teed[i] = t;
+      copy |= (size_t) t < len;
+    }
+    if(!copy) {
+      discardInput(in, null_fd, buf, len);
+      continue;
+    }
+    readInput(in, buf, len);
+    for(int i = 0; i < n; i++) {
+      if(c[i].fd >= 0 && teed[i] < len) {
+        memcpy(c[i].backlog, buf + teed[i], len - teed[i]);
+        c[i].start = 0;
+        c[i].end = len - teed[i];
+      }
+    }
+  }
+
+  for(int i = 0; i < n; i++) {
+    if(c[i].fd >= 0) {
+      close(c[i].fd);
+    }
+    free(c[i].backlog);
+  }
+  close(in);
+  close(null_fd);
+  free(buf);
+  signal(SIGPIPE, old_handler);
+}
+
+//Starts the producer index to fan and the consumers fan + 1 to end, and pumps
+//the output of the producer to them
+static void runFanOut(char *command_token[], int index, int fan, int end, Command command[]) {
+  int first[MAX_FAN_CONSUMERS]; //first command of each consumer
+  int n = 0;
+
+  for(int i = fan + 1; i <= end; i++) {
+    if(n == MAX_FAN_CONSUMERS) {
+      printf("bash: too many commands in fan-out\n");
+      return;
+    }
+    first[n++] = i;
+    while(i < end && strcmp(command[i].sep, pipeSep) == 0) {
+      i++;
+    }
+  }
+
+  //Pipe 0 is read by the shell, pipes 1 to n are written by it
+  int p[2 * (n + 1)];
+  Consumer c[n];
+  for(int i = 0; i <= n; i++) {
+    if(pipe2(p + 2 * i, O_CLOEXEC) == -1) {
+      perror("pipe");
+      exit(1);
+    }
+    fcntl(p[2 * i], F_SETPIPE_SZ, FAN_PIPE_SIZE); //fewer, larger steps
+  }
+  fflush(stdout);
+
+  pid_t producer = startSubshell(command_token, command, index, fan, -1, p[1], p, 2 * (n + 1));
+  pid_t consumers[n];
+  for(int i = 0; i < n; i++) {
+    int last = i < n - 1 ? first[i + 1] - 1 : end;
+    consumers[i] = startSubshell(command_token, command, first[i], last, p[2 * i + 2], -1, p, 2 * (n + 1));
+  }
+
+  close(p[1]);
+  for(int i = 0; i < n; i++) {
+    close(p[2 * i + 2]);
+    c[i].fd = p[2 * i + 3];
+    c[i].size = fcntl(c[i].fd, F_GETPIPE_SZ);
+    fcntl(c[i].fd, F_SETFL, O_NONBLOCK);
+  }
+  pump(p[0], c, n);
+
+  waitChild(producer);
+  for(int i = 0; i < n; i++) {
+    waitChild(consumers[i]); //the status of the last consumer is kept
+  }
+}
+
+//Processes the job if it sends its output to several commands with "|{"
+int processFanOut(char *command_token[], int index, Command command[], int n_commands) {
+  int fan;
+  int end = fanOutEnd(index, command, n_commands, &fan);
+
+  if(end < 0) {
+    return 0;
+  }
+  if(strcmp(command[end].sep, conSep) != 0) {
+    runFanOut(command_token, index, fan, end, command);
+    return end - index;
+  }
+
+  //A background fan-out is pumped by a child of the shell
+  fflush(stdout);
+  pid_t pid;
+  if((pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if(pid == 0) {
+    runFanOut(command_token, index, fan, end, command);
+    exit(lastStatus);
+  }
+  addJob(pid, JOB_BACKGROUND, command[index].argv[0]);
+
+  return end - index;
+}
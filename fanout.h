@@ -0,0 +1,33 @@
+/*
+ * File:	fanout.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Run a fan-out job "producer |{ consumer1 ; consumer2 }",
+		which sends the standard output of the producer to the
+		standard input of every consumer.
+
+   Return:	processFanOut() returns the number of commands of the job
+		after the first one, or 0 if the job starting at "index" is
+		not a fan-out.
+
+   Note:	1) The producer and every consumer may be a pipeline with
+		   redirections. Each runs in a subshell.
+		2) The shell copies the stream with tee() and splice(), so
+		   the bytes are not copied through user space. Each step
+		   waits until every consumer can take more and is no larger
+		   than the room left in the fullest consumer pipe, so the
+		   slowest consumer holds up the producer. If a pipe takes
+		   only part of a step, the rest is given to that consumer
+		   from a copy in user space before the next step.
+		3) A consumer that exits early is dropped, the others still
+		   get the whole stream.
+		4) The exit status of the job is the one of the last
+		   consumer.
+*/
+
+#define MAX_FAN_CONSUMERS 64
+#define FAN_PIPE_SIZE (1024 * 1024) //requested size of the pipes of the job
+
+int processFanOut(char *command_token[], int index, Command command[], int n_commands);
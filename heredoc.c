@@ -0,0 +1,143 @@
+/*
+ * File:	heredoc.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "command.h"
+#include "arena.h"
+#include "heredoc.h"
+
+//Reads lines from stdin up to the delimiter and returns them, stored in the line arena
+//Returns NULL if end of file is reached first
+static char *readHereDocument(char *delimiter) {
+  char *line = NULL;
+  size_t line_size = 0;
+  ssize_t line_len;
+  char *text = NULL;
+  size_t size = 0;
+  size_t used = 0;
+  int found = 0;
+
+  while(1) {
+    printf("%s ", HERE_DOC_PROMPT);
+    fflush(stdout);
+    line_len = getline(&line, &line_size, stdin);
+    if(line_len < 0) {
+      break;
+    }
+    if(strncmp(line, delimiter, strlen(delimiter)) == 0 && (line[strlen(delimiter)] == '\n' || line[strlen(delimiter)] == '\0')) {
+      found = 1;
+      break;
+    }
+    if(used + line_len + 1 > size) {
+      size = (used + line_len + 1) * 2;
+      text = (char *) realloc(text, size);
+      if(text == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    memcpy(text + used, line, line_len);
+    used += line_len;
+  }
+  free(line);
+
+  char *doc = (char *) lineArenaAlloc(used + 1);
+  if(used > 0) {
+    memcpy(doc, text, used);
+  }
+  doc[used] = '\0';
+  free(text);
+
+  return found ? doc : NULL;
+}
+
+//Fills in the text of every here-document
+//Returns 0 if successful, or -1 if a here-document is not terminated
+int readHereDocuments(Command command[], int n_commands) {
+  for(int i = 0; i < n_commands; i++) {
+    if(command[i].stdin_op == NULL || command[i].stdin_file == NULL) {
+      continue;
+    }
+    if(strcmp(command[i].stdin_op, inHereDoc) == 0) {
+      command[i].stdin_doc = readHereDocument(command[i].stdin_file);
+      if(command[i].stdin_doc == NULL) {
+        printf("bash: warning: here-document delimited by end-of-file (wanted `%s')\n", command[i].stdin_file);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//Returns the text of a here-string, stored in the line arena
+char *hereString(char *word) {
+  size_t len = strlen(word);
+  char *text = (char *) lineArenaAlloc(len + 2);
+
+  memcpy(text, word, len);
+  strcpy(text + len, "\n");
+
+  return text;
+}
+
+//Writes the whole buffer, retrying after short writes
+static int writeAll(int fd, char *buf, size_t len) {
+  while(len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if(n < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    buf += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+//Returns a file descriptor positioned at the start of text, or -1 on failure
+int openHereDocument(char *text) {
+  size_t len = strlen(text);
+  int p[2];
+
+  //Text that fits into the pipe buffer can be written without blocking
+  if(pipe2(p, O_CLOEXEC) == 0) {
+    int capacity = fcntl(p[1], F_GETPIPE_SZ);
+    if(capacity > 0 && len <= (size_t) capacity) {
+      writeAll(p[1], text, len);
+      close(p[1]);
+      return p[0];
+    }
+    close(p[0]);
+    close(p[1]);
+  }
+
+  //Longer text goes into memory that the reader can seek in but not change
+  int fd = memfd_create("here-document", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if(fd < 0) {
+    perror("memfd_create");
+    return -1;
+  }
+  if(writeAll(fd, text, len) < 0) {
+    perror("write");
+    close(fd);
+    return -1;
+  }
+  lseek(fd, 0, SEEK_SET);
+  fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+
+  return fd;
+}
@@ -0,0 +1,26 @@
+/*
+ * File:	heredoc.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Here-documents (<< delimiter) and here-strings (<<< word).
+
+   Note:	1) readHereDocuments() reads the lines of every here-document
+		   of a parsed command line from stdin, in the order the
+		   commands appear, and stores the text of each in the line
+		   arena.
+		2) hereString() returns the text of a here-string, its word
+		   followed by a newline. It is built when the command runs,
+		   after the word has been expanded.
+		3) openHereDocument() returns a file descriptor from which
+		   the text can be read. Text that fits into a pipe is written
+		   into one; longer text goes into a sealed memfd. The file
+		   system is never used.
+*/
+
+#define HERE_DOC_PROMPT ">" //prompt for the lines of a here-document
+
+int readHereDocuments(Command command[], int n_commands);
+char *hereString(char *word);
+int openHereDocument(char *text);
@@ -0,0 +1,152 @@
+/*
+ * File:	job.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "command.h"
+#include "job.h"
+#include "metrics.h"
+#include "perfstat.h"
+#include "zygote.h"
+
+int lastStatus = 0;
+
+static Job jobs[MAX_NUM_JOBS];
+static int next_id = 1;
+static pid_t *untracked = NULL; //processes added while every slot held a running one
+static int n_untracked = 0;
+static int untracked_size = 0;
+
+//Adds a process to the job table and returns its job number
+//Returns -1 if every slot holds a running process, the process is still claimed when it ends
+int addJob(pid_t pid, int type, char *name) {
+  sigset_t sigs;
+  sigset_t old;
+  int slot = -1;
+
+  //The SIGCHLD handler walks the table, keep it out while the table changes
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &sigs, &old);
+
+  for(int i = 0; i < MAX_NUM_JOBS && slot == -1; i++) {
+    if(jobs[i].id == 0) {
+      slot = i;
+    }
+  }
+  if(slot == -1) {
+    //The oldest finished job has the lowest number
+    for(int i = 0; i < MAX_NUM_JOBS; i++) {
+      if(jobs[i].done && (slot == -1 || jobs[i].id < jobs[slot].id)) {
+        slot = i;
+      }
+    }
+  }
+  if(slot == -1) {
+    if(n_untracked == untracked_size) {
+      untracked_size = untracked_size == 0 ? 16 : untracked_size * 2;
+      untracked = (pid_t *) realloc(untracked, sizeof(pid_t) * untracked_size);
+      if(untracked == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    untracked[n_untracked++] = pid;
+  }
+  else {
+    jobs[slot].id = next_id++;
+    jobs[slot].pid = pid;
+    jobs[slot].type = type;
+    jobs[slot].done = 0;
+    jobs[slot].status = 0;
+    strncpy(jobs[slot].name, name, JOB_NAME_SIZE - 1);
+    jobs[slot].name[JOB_NAME_SIZE - 1] = '\0';
+  }
+  reapJobs(); //the process may have ended before it was added
+
+  sigprocmask(SIG_SETMASK, &old, NULL);
+
+  return slot == -1 ? -1 : jobs[slot].id;
+}
+
+//Returns the job with the given number, or NULL if there is none
+Job *findJob(int id) {
+  for(int i = 0; i < MAX_NUM_JOBS; i++) {
+    if(jobs[i].id == id && id != 0) {
+      return &(jobs[i]);
+    }
+  }
+
+  return NULL;
+}
+
+//Claims the processes in the job table, and the ones added while it was full, that have ended
+void reapJobs() {
+  int saved_errno = errno; //called from a signal handler
+  int status;
+
+  for(int i = 0; i < MAX_NUM_JOBS; i++) {
+    if(jobs[i].id != 0 && !jobs[i].done && waitpid(jobs[i].pid, &status, WNOHANG) == jobs[i].pid) {
+      jobs[i].status = exitStatus(status);
+      jobs[i].done = 1;
+      recordExit(jobs[i].pid, jobs[i].status);
+    }
+  }
+  for(int i = 0; i < n_untracked; i++) {
+    if(waitpid(untracked[i], &status, WNOHANG) == untracked[i]) {
+      recordExit(untracked[i], exitStatus(status));
+      untracked[i--] = untracked[--n_untracked];
+    }
+  }
+  errno = saved_errno;
+}
+
+//Converts a status from waitpid() into an exit status like the one of bash
+int exitStatus(int status) {
+  if(WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  if(WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+
+  return 0;
+}
+
+//Waits for a foreground child and returns its exit status
+int waitChild(pid_t pid) {
+  int status;
+  struct rusage ru;
+  uint64_t start = metricsNow();
+
+  if(isZygoteChild(pid)) {
+    //Its parent is the zygote, which sends the status
+    if(waitZygoteChild(pid, &status, &ru) < 0) {
+      return lastStatus;
+    }
+  }
+  else {
+    perfStatExiting(pid);
+    while(wait4(pid, &status, 0, &ru) < 0) {
+      if(errno != EINTR) {
+        return lastStatus; //already claimed
+      }
+    }
+  }
+  recordWait(start);
+  lastStatus = exitStatus(status);
+  recordExit(pid, lastStatus);
+  perfStatExited(pid, &ru);
+
+  return lastStatus;
+}
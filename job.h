@@ -0,0 +1,45 @@
+/*
+ * File:	job.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Keep track of the child processes the shell does not wait
+		for, i.e. background jobs and the commands of process
+		substitutions, so that they can be claimed when they end.
+
+   Note:	1) Foreground children are waited for with waitChild(),
+		   which records their exit status in lastStatus.
+		2) reapJobs() is called from the SIGCHLD handler and only
+		   claims the processes added with addJob().
+		3) When the table is full, the slot of the oldest finished
+		   job is reused. If every slot holds a running process,
+		   the process gets no job number but is still claimed
+		   when it ends.
+*/
+
+#define MAX_NUM_JOBS 256
+#define JOB_NAME_SIZE 64
+
+//Kinds of jobs
+#define JOB_BACKGROUND 0 //command followed by "&"
+#define JOB_SUBSTITUTION 1 //command of a process substitution
+
+struct JobStruct {
+  int id; //job number shown to the user, 0 if the slot is unused
+  pid_t pid;
+  int type; //JOB_BACKGROUND or JOB_SUBSTITUTION
+  int done; //1 once the process has been claimed
+  int status; //exit status, valid when done is 1
+  char name[JOB_NAME_SIZE]; //the command, possibly truncated
+};
+
+typedef struct JobStruct Job; //job type
+
+extern int lastStatus; //exit status of the last foreground command
+
+int addJob(pid_t pid, int type, char *name);
+Job *findJob(int id);
+void reapJobs();
+int waitChild(pid_t pid);
+int exitStatus(int status);
@@ -0,0 +1,400 @@
+/*
+ * File:	libmyshell.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "token.h"
+#include "command.h"
+#include "libmyshell.h"
+
+#define ERROR_SIZE 256
+
+//A context, everything the library keeps between two calls
+struct MyShellStruct {
+  int flags; //MYSH_CAPTURE or 0
+  char *cwd; //directory of the commands, NULL for the one of the program
+  char *out; //standard output of the last line, '\0'-terminated
+  size_t out_len;
+  size_t out_size;
+  int status; //exit status of the last command
+  char error[ERROR_SIZE]; //why the last line could not be run, or ""
+  pid_t *background; //commands followed by "&" not claimed yet
+  int n_background;
+  int background_size;
+};
+
+extern char **environ;
+
+//Converts a status from waitpid() into an exit status like the one of bash
+static int exitCode(int status) {
+  if(WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  if(WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+
+  return 0;
+}
+
+//Keeps the reason the line could not be run
+static void setError(MyShell *sh, const char *what, const char *why) {
+  snprintf(sh->error, ERROR_SIZE, "%s: %s", what, why);
+}
+
+//Appends n bytes to the output of the line
+static int appendOutput(MyShell *sh, char *data, size_t n) {
+  if(sh->out_len + n + 1 > sh->out_size) {
+    size_t size = (sh->out_len + n + 1) * 2;
+    char *out = (char *) realloc(sh->out, size);
+    if(out == NULL) {
+      return -1;
+    }
+    sh->out = out;
+    sh->out_size = size;
+  }
+  memcpy(sh->out + sh->out_len, data, n);
+  sh->out_len += n;
+  sh->out[sh->out_len] = '\0';
+
+  return 0;
+}
+
+//Claims the background commands that have ended, or waits for all of them
+static void claimBackground(MyShell *sh, int wait_all) {
+  int n = 0;
+
+  for(int i = 0; i < sh->n_background; i++) {
+    pid_t pid = waitpid(sh->background[i], NULL, wait_all ? 0 : WNOHANG);
+    if(pid == 0 || (pid < 0 && errno == EINTR)) {
+      sh->background[n++] = sh->background[i]; //still running
+    }
+  }
+  sh->n_background = n;
+}
+
+//Adds a command followed by "&" to the ones to claim
+static void addBackground(MyShell *sh, pid_t pid) {
+  if(sh->n_background == sh->background_size) {
+    int size = sh->background_size == 0 ? 8 : sh->background_size * 2;
+    pid_t *background = (pid_t *) realloc(sh->background, size * sizeof(pid_t));
+    if(background == NULL) {
+      waitpid(pid, NULL, 0);
+      return;
+    }
+    sh->background = background;
+    sh->background_size = size;
+  }
+  sh->background[sh->n_background++] = pid;
+}
+
+//Processes "cd [dir]" in the context, returns its exit status
+static int changeDirectory(MyShell *sh, Command *cp) {
+  char path[PATH_MAX];
+  char resolved[PATH_MAX];
+  char cwd[PATH_MAX];
+  char *dir = cp->argv[1] != NULL ? cp->argv[1] : getenv("HOME");
+  struct stat buf;
+
+  if(dir == NULL) {
+    setError(sh, "cd", "HOME not set");
+    return 1;
+  }
+  if(dir[0] == '/') {
+    snprintf(path, sizeof(path), "%s", dir);
+  }
+  else {
+    if(sh->cwd == NULL && getcwd(cwd, sizeof(cwd)) == NULL) {
+      setError(sh, "cd", strerror(errno));
+      return 1;
+    }
+    snprintf(path, sizeof(path), "%s/%s", sh->cwd != NULL ? sh->cwd : cwd, dir);
+  }
+  errno = 0;
+  if(realpath(path, resolved) == NULL || stat(resolved, &buf) != 0 || !S_ISDIR(buf.st_mode)) {
+    setError(sh, dir, errno != 0 ? strerror(errno) : "Not a directory");
+    return 1;
+  }
+  free(sh->cwd);
+  sh->cwd = strdup(resolved);
+
+  return 0;
+}
+
+//Returns a file holding the text of a "<<<" here-string, or -1
+static int hereString(char *word) {
+  int fd = memfd_create("here-string", MFD_CLOEXEC);
+  size_t len = strlen(word);
+
+  if(fd < 0) {
+    return -1;
+  }
+  if(write(fd, word, len) != (ssize_t) len || write(fd, "\n", 1) != 1 || lseek(fd, 0, SEEK_SET) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+//Returns 1 if a redirection of the command is not followed by a file name
+static int danglingRedirection(char *token[], Command *cp) {
+  for(int i = cp->first; i <= cp->last; i++) {
+    if(isStdinRedirection(token[i]) || strcmp(token[i], ">") == 0) {
+      if(i == cp->last || isStdinRedirection(token[i + 1]) || strcmp(token[i + 1], ">") == 0) {
+        return 1;
+      }
+      i++; //the file name
+    }
+  }
+
+  return 0;
+}
+
+//Runs the pipeline command[first..last], returns the exit status of its last command
+static int runPipeline(MyShell *sh, Command command[], int first, int last) {
+  posix_spawnattr_t attr;
+  sigset_t sigs;
+  int background = strcmp(command[last].sep, conSep) == 0;
+  int capture = (sh->flags & MYSH_CAPTURE) && !background;
+  int out_fds[2] = {-1, -1};
+  int in_fd = -1; //read end of the pipe from the command before
+  int status = 0;
+  pid_t *pids = (pid_t *) malloc((last - first + 1) * sizeof(pid_t));
+
+  if(pids == NULL) {
+    setError(sh, "malloc", strerror(errno));
+    return -1;
+  }
+  //The children start with no signal blocked or caught, whatever the program does
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+  sigemptyset(&sigs);
+  posix_spawnattr_setsigmask(&attr, &sigs);
+  sigfillset(&sigs);
+  posix_spawnattr_setsigdefault(&attr, &sigs);
+  //Every descriptor is close-on-exec, other threads may be spawning too
+  if(capture && pipe2(out_fds, O_CLOEXEC) < 0) {
+    setError(sh, "pipe", strerror(errno));
+    capture = 0;
+  }
+
+  for(int i = first; i <= last; i++) {
+    posix_spawn_file_actions_t actions;
+    int pipe_fds[2] = {-1, -1};
+    int doc_fd = -1;
+    Command *cp = &(command[i]);
+
+    posix_spawn_file_actions_init(&actions);
+    if(sh->cwd != NULL) {
+      posix_spawn_file_actions_addchdir_np(&actions, sh->cwd); //before the files are opened
+    }
+    if(in_fd >= 0) {
+      posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    }
+    if(i < last) {
+      if(pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        setError(sh, "pipe", strerror(errno));
+      }
+      else {
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+      }
+    }
+    else if(capture) {
+      posix_spawn_file_actions_adddup2(&actions, out_fds[1], STDOUT_FILENO);
+    }
+    if(cp->stdin_op != NULL && strcmp(cp->stdin_op, inFile) == 0) {
+      posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, cp->stdin_file, O_RDONLY, 0);
+    }
+    else if(cp->stdin_op != NULL && strcmp(cp->stdin_op, inHereStr) == 0 && (doc_fd = hereString(cp->stdin_file)) >= 0) {
+      posix_spawn_file_actions_adddup2(&actions, doc_fd, STDIN_FILENO);
+    }
+    if(cp->stdout_file != NULL) {
+      posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, cp->stdout_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    int error = posix_spawnp(&(pids[i - first]), cp->argv[0], &actions, &attr, cp->argv, environ);
+    if(error != 0) {
+      //The rest of the pipeline runs, like in the shell
+      setError(sh, cp->argv[0], strerror(error));
+      pids[i - first] = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    if(in_fd >= 0) {
+      close(in_fd);
+    }
+    if(doc_fd >= 0) {
+      close(doc_fd);
+    }
+    if(pipe_fds[1] >= 0) {
+      close(pipe_fds[1]);
+    }
+    in_fd = pipe_fds[0];
+  }
+  posix_spawnattr_destroy(&attr);
+
+  //Read all the output before waiting, the last command may fill the pipe
+  if(capture) {
+    char buf[8192];
+    ssize_t n;
+    close(out_fds[1]);
+    while((n = read(out_fds[0], buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+      if(n > 0 && appendOutput(sh, buf, n) < 0) {
+        setError(sh, "realloc", strerror(ENOMEM));
+        break;
+      }
+    }
+    close(out_fds[0]);
+  }
+  for(int i = 0; i <= last - first; i++) {
+    int wstatus;
+    if(pids[i] < 0) {
+      status = 127;
+    }
+    else if(background) {
+      addBackground(sh, pids[i]);
+    }
+    else {
+      while(waitpid(pids[i], &wstatus, 0) < 0 && errno == EINTR) {
+      }
+      status = exitCode(wstatus);
+    }
+  }
+  free(pids);
+
+  return background ? 0 : status;
+}
+
+//Returns a new context, with MYSH_CAPTURE to keep the output of each line
+MyShell *myshCreate(int flags) {
+  MyShell *sh = (MyShell *) calloc(1, sizeof(MyShell));
+
+  if(sh == NULL) {
+    return NULL;
+  }
+  sh->flags = flags;
+  if(appendOutput(sh, "", 0) < 0) {
+    free(sh);
+    return NULL;
+  }
+
+  return sh;
+}
+
+//Waits for the background commands of the context and frees it
+void myshDestroy(MyShell *sh) {
+  if(sh == NULL) {
+    return;
+  }
+  claimBackground(sh, 1);
+  free(sh->background);
+  free(sh->cwd);
+  free(sh->out);
+  free(sh);
+}
+
+//Runs a command line, returns the exit status of its last command or -1
+int myshRun(MyShell *sh, const char *line) {
+  size_t len = strlen(line);
+  int n_commands;
+  int status = 0;
+
+  claimBackground(sh, 0);
+  sh->out_len = 0;
+  sh->out[0] = '\0';
+  sh->error[0] = '\0';
+
+  //A line of len characters has fewer than len + 1 tokens, and one command per token at most
+  char *input = strdup(line);
+  char **token = (char **) calloc(len + 3, sizeof(char *));
+  Command *command = (Command *) calloc(len + 3, sizeof(Command));
+  if(input == NULL || token == NULL || command == NULL) {
+    free(input);
+    free(token);
+    free(command);
+    setError(sh, "malloc", strerror(ENOMEM));
+    return -1;
+  }
+  tokeniseLine(input, token, len + 3);
+  if((n_commands = separateCommands(token, command)) < 0) {
+    setError(sh, line, n_commands == -6 ? strerror(ENOMEM) : "syntax error");
+    status = -1;
+  }
+  for(int i = 0; i < n_commands && status >= 0; i++) {
+    if(danglingRedirection(token, &(command[i]))) {
+      setError(sh, line, "syntax error");
+      status = -1;
+    }
+    else if(command[i].argv[0] == NULL) {
+      setError(sh, line, "missing command");
+      status = -1;
+    }
+    else if(strcmp(command[i].sep, fanSep) == 0 || (command[i].stdin_op != NULL && strcmp(command[i].stdin_op, inHereDoc) == 0)) {
+      setError(sh, command[i].argv[0], "fan-outs and here-documents are not supported");
+      status = -1;
+    }
+  }
+
+  for(int i = 0; i < n_commands && status >= 0; i++) {
+    int last = i;
+    while(strcmp(command[last].sep, pipeSep) == 0) {
+      last++;
+    }
+    if(strcmp(command[i].argv[0], "exit") == 0) {
+      break;
+    }
+    else if(i == last && strcmp(command[i].argv[0], "cd") == 0) {
+      status = changeDirectory(sh, &(command[i]));
+    }
+    else {
+      status = runPipeline(sh, command, i, last);
+    }
+    i = last;
+  }
+
+  for(int i = 0; i < (int) len + 3; i++) {
+    free(command[i].argv); //separateCommands() may have failed after building some
+  }
+  free(command);
+  free(token);
+  free(input);
+  if(status >= 0) {
+    sh->status = status;
+  }
+
+  return status;
+}
+
+//Returns the standard output of the last line, and its length in len if not NULL
+const char *myshOutput(MyShell *sh, size_t *len) {
+  if(len != NULL) {
+    *len = sh->out_len;
+  }
+
+  return sh->out;
+}
+
+//Returns the exit status of the last command run
+int myshStatus(MyShell *sh) {
+  return sh->status;
+}
+
+//Returns why the last line could not be run, or why a command of it could not start, or ""
+const char *myshError(MyShell *sh) {
+  return sh->error;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:	libmyshell.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Run command lines from a C or C++ program without starting
+		/bin/sh for each of them, with the tokeniser and
+		separateCommands() of the shell. Built with "make lib" into
+		libmyshell.a and libmyshell.so.
+
+   Return:	1) myshCreate() returns a new context, or NULL if out of
+		   memory.
+		2) myshRun() returns the exit status of the last command of
+		   the line, like bash, or -1 if the line could not be run,
+		   with the reason in myshError().
+		3) myshOutput() returns the standard output of the line if
+		   the context was created with MYSH_CAPTURE, or "".
+
+   Note:	1) A line is made of commands separated by "|", ";" and
+		   "&", with "<" file, ">" file and "<<<" word
+		   redirections, split like the shell splits them. There is
+		   no expansion of variables, wildcards or substitutions.
+		   "cd dir" changes the directory of the context only; the
+		   other words are programs found through PATH.
+		2) Each context holds its own directory, output and status,
+		   and the library has no other state, so contexts can be
+		   used by several threads at once, one thread per context.
+		   Lines of any length are accepted.
+		3) Commands are started with posix_spawn(), with every
+		   signal at its default action and none blocked. The
+		   library installs no signal handler and does not change
+		   the signal mask of the program. It waits for each
+		   process by its pid, so the program must not reap them
+		   itself, e.g. with SIGCHLD ignored or waitpid(-1).
+		4) Commands followed by "&" are not waited for by
+		   myshRun(); they are claimed by the next myshRun() once
+		   they end, and waited for by myshDestroy().
+*/
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MYSH_CAPTURE 1 //keep the standard output of each line for myshOutput()
+
+typedef struct MyShellStruct MyShell;
+
+MyShell *myshCreate(int flags);
+void myshDestroy(MyShell *sh);
+int myshRun(MyShell *sh, const char *line);
+const char *myshOutput(MyShell *sh, size_t *len);
+int myshStatus(MyShell *sh);
+const char *myshError(MyShell *sh);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,241 @@
+/*
+ * File:	lineedit.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <termios.h>
+#include <unistd.h>
+#include "complete.h"
+#include "lineedit.h"
+
+#define KEY_CTRL(c) ((c) & 0x1f)
+#define KEY_ESC 27
+#define KEY_BACKSPACE 127
+#define MAX_WORD_SIZE 4096
+
+//Reads one byte from the terminal, returns -1 at the end of the input
+static int readKey() {
+  unsigned char c;
+  ssize_t n;
+
+  while((n = read(STDIN_FILENO, &c, 1)) < 0 && errno == EINTR) {
+  }
+
+  return n == 1 ? c : -1;
+}
+
+//Draws the prompt and the line again and puts the cursor at pos
+static void refreshLine(char *prompt, char *buf, int len, int pos) {
+  printf("\r%s %s\x1b[K", prompt, buf);
+  if(len > pos) {
+    printf("\x1b[%dD", len - pos);
+  }
+  fflush(stdout);
+}
+
+//Returns 1 if c ends a word for completion
+static int isWordDelimiter(char c) {
+  return strchr(" \t,&;|<>(`", c) != NULL;
+}
+
+//Returns 1 if the word starting at ws is the name of a command
+static int isCommandPosition(char *buf, int ws) {
+  int i = ws - 1;
+
+  while(i >= 0 && (buf[i] == ' ' || buf[i] == '\t' || buf[i] == ',')) {
+    i--;
+  }
+
+  return i < 0 || strchr(";&|(`", buf[i]) != NULL;
+}
+
+//Inserts n characters of s at pos
+//Returns 0, or -1 if the line is full
+static int insertText(char *buf, int *len, int *pos, int size, char *s, int n) {
+  if(*len + n > size - 1) {
+    return -1;
+  }
+  memmove(buf + *pos + n, buf + *pos, *len - *pos + 1);
+  memcpy(buf + *pos, s, n);
+  *len += n;
+  *pos += n;
+
+  return 0;
+}
+
+//Deletes the n characters before pos
+static void deleteText(char *buf, int *len, int *pos, int n) {
+  memmove(buf + *pos - n, buf + *pos, *len - *pos + 1);
+  *len -= n;
+  *pos -= n;
+}
+
+//Completes the word before the cursor, or prints the names it can become if list is 1
+static void completeLine(char *buf, int *len, int *pos, int size, int list) {
+  char word[MAX_WORD_SIZE];
+  char suffix[MAX_WORD_SIZE];
+  int ws = *pos;
+
+  while(ws > 0 && !isWordDelimiter(buf[ws - 1])) {
+    ws--;
+  }
+  if(*pos - ws >= MAX_WORD_SIZE) {
+    return;
+  }
+  memcpy(word, buf + ws, *pos - ws);
+  word[*pos - ws] = '\0';
+  int command = isCommandPosition(buf, ws);
+
+  if(list) {
+    printCompletions(word, command);
+    return;
+  }
+  int n_matches = completeWord(word, command, suffix, sizeof(suffix));
+  if(suffix[0] == '\0' || insertText(buf, len, pos, size, suffix, strlen(suffix)) < 0) {
+    if(n_matches != 1) {
+      printf("\a");
+    }
+  }
+}
+
+//Moves the cursor for an escape sequence, the ESC has been read
+static void readEscape(char *buf, int *len, int *pos) {
+  int c1 = readKey();
+  int c2 = readKey();
+
+  if(c1 != '[' && c1 != 'O') {
+    return;
+  }
+  if(c2 >= '0' && c2 <= '9') {
+    //Delete is ESC [ 3 ~, Home and End may be ESC [ 1 ~ and ESC [ 4 ~
+    if(readKey() != '~') {
+      return;
+    }
+    if(c2 == '3' && *pos < *len) {
+      (*pos)++;
+      deleteText(buf, len, pos, 1);
+    }
+    else if(c2 == '1' || c2 == '7') {
+      *pos = 0;
+    }
+    else if(c2 == '4' || c2 == '8') {
+      *pos = *len;
+    }
+  }
+  else if(c2 == 'C' && *pos < *len) {
+    (*pos)++;
+  }
+  else if(c2 == 'D' && *pos > 0) {
+    (*pos)--;
+  }
+  else if(c2 == 'H') {
+    *pos = 0;
+  }
+  else if(c2 == 'F') {
+    *pos = *len;
+  }
+}
+
+//Reads and edits a command line until Enter is pressed
+int editLine(char input[], int size, char *prompt) {
+  struct termios saved, raw;
+  int len = 0;
+  int pos = 0;
+  int last_key = 0;
+  int result = 0;
+
+  if(tcgetattr(STDIN_FILENO, &saved) < 0) {
+    return -1;
+  }
+  raw = saved;
+  raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+  raw.c_iflag &= ~(IXON | ICRNL);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+
+  input[0] = '\0';
+  refreshLine(prompt, input, len, pos);
+  while(1) {
+    int c = readKey();
+    if(c < 0 || (c == KEY_CTRL('d') && len == 0)) {
+      result = -1;
+      break;
+    }
+    if(c == '\r' || c == '\n') {
+      break;
+    }
+    switch(c) {
+      case '\t':
+        completeLine(input, &len, &pos, size, last_key == '\t');
+        break;
+      case KEY_BACKSPACE:
+      case KEY_CTRL('h'):
+        if(pos > 0) {
+          deleteText(input, &len, &pos, 1);
+        }
+        break;
+      case KEY_CTRL('d'):
+        if(pos < len) {
+          pos++;
+          deleteText(input, &len, &pos, 1);
+        }
+        break;
+      case KEY_CTRL('c'):
+        printf("^C\n");
+        len = pos = 0;
+        input[0] = '\0';
+        break;
+      case KEY_CTRL('a'):
+        pos = 0;
+        break;
+      case KEY_CTRL('e'):
+        pos = len;
+        break;
+      case KEY_CTRL('b'):
+        pos -= pos > 0;
+        break;
+      case KEY_CTRL('f'):
+        pos += pos < len;
+        break;
+      case KEY_CTRL('k'):
+        len = pos;
+        input[len] = '\0';
+        break;
+      case KEY_CTRL('u'):
+        deleteText(input, &len, &pos, pos);
+        break;
+      case KEY_CTRL('w'): {
+        int ws = pos;
+        while(ws > 0 && input[ws - 1] == ' ') {
+          ws--;
+        }
+        while(ws > 0 && input[ws - 1] != ' ') {
+          ws--;
+        }
+        deleteText(input, &len, &pos, pos - ws);
+        break;
+      }
+      case KEY_ESC:
+        readEscape(input, &len, &pos);
+        break;
+      default:
+        if(c >= ' ') {
+          char ch = (char) c;
+          insertText(input, &len, &pos, size, &ch, 1);
+        }
+    }
+    last_key = c;
+    refreshLine(prompt, input, len, pos);
+  }
+  printf("\n");
+  fflush(stdout);
+  tcsetattr(STDIN_FILENO, TCSADRAIN, &saved);
+
+  return result;
+}
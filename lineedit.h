@@ -0,0 +1,23 @@
+/*
+ * File:	lineedit.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Read a command line from a terminal in raw mode, so that it
+		can be edited and its words completed with Tab.
+
+   Return:	1) 0, if a line was read into "input", or
+		2) -1, at the end of the input (Ctrl-D on an empty line).
+
+   Note:	1) Keys: Left/Right, Home/End, Ctrl-A/E/B/F move the cursor,
+		   Backspace, Delete, Ctrl-D/K/U/W delete, Ctrl-C discards
+		   the line.
+		2) Tab completes the word before the cursor as a command
+		   name if it starts a command, or as a file name otherwise.
+		   If several names match, a second Tab prints them.
+		3) The terminal is put back into its previous mode before
+		   editLine() returns.
+*/
+
+int editLine(char input[], int size, char *prompt);
@@ -7,50 +7,144 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/resource.h>
 #include "token.h"
 #include "command.h"
 #include "myshell.h"
+#include "server.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "zygote.h"
+#include "prefetch.h"
+#include "session.h"
+#include "spool.h"
 
 #define STR_SIZE 1024
 
-int main() {
+//Prints how the shell can be started
+void usage(char *name) {
+  printf("Usage: %s [-c command_line | --server socket] [--metrics-file file [--metrics-interval seconds]] [--snapshot file | --no-snapshot] [--zygote] [--no-prefetch] [--spool-jobs] [--record file | --replay file [--speed N | --max] [--stubs]]\n", name);
+}
+
+int main(int argc, char *argv[]) {
   //Declaration of variables
   char *command_token[MAX_NUM_TOKENS];
   Command command[MAX_NUM_COMMANDS];
   int n_commands;
-  char input[STR_SIZE];
+  char input[STR_SIZE] = "";
   char *prompt = "%";
   char new_prompt[STR_SIZE];
-  int n_pipes;
+  char *line = NULL; //command line given with -c
+  char *socket_path = NULL; //socket given with --server
+  char *metrics_path = NULL; //file given with --metrics-file
+  int metrics_interval = 15; //seconds between two writes of the metrics file
+  char *snapshot_path = NULL; //file given with --snapshot
+  int snapshot = 1; //0 with --no-snapshot
+  int zygote = 0; //1 with --zygote
+  int prefetch = 1; //0 with --no-prefetch
+  int spool = 0; //1 with --spool-jobs
+  char home_snapshot[PATH_MAX];
+  char *record_path = NULL; //file given with --record
+  char *replay_path = NULL; //file given with --replay
+  double speed = 1; //0 with --max
+  int stubs = 0; //1 with --stubs
 
+  //Options
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      line = argv[++i];
+    }
+    else if(strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+      metrics_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+      metrics_interval = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+      snapshot_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "--no-snapshot") == 0) {
+      snapshot = 0;
+    }
+    else if(strcmp(argv[i], "--zygote") == 0) {
+      zygote = 1;
+    }
+    else if(strcmp(argv[i], "--no-prefetch") == 0) {
+      prefetch = 0;
+    }
+    else if(strcmp(argv[i], "--spool-jobs") == 0) {
+      spool = 1;
+    }
+    else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "--speed") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+      speed = atof(argv[++i]);
+    }
+    else if(strcmp(argv[i], "--max") == 0) {
+      speed = 0;
+    }
+    else if(strcmp(argv[i], "--stubs") == 0) {
+      stubs = 1;
+    }
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if(zygote) {
+    startZygote(); //first, while the shell is small
+  }
+  initMetrics(); //before any child, the children record into the same region
+  if(metrics_path != NULL) {
+    startMetricsWriter(metrics_path, metrics_interval);
+  }
+  if(record_path != NULL && startRecording(record_path) != 0) {
+    return 1;
+  }
+  if(snapshot && snapshot_path == NULL && getenv("HOME") != NULL) {
+    snprintf(home_snapshot, sizeof(home_snapshot), "%s/.myshell_snapshot", getenv("HOME"));
+    snapshot_path = home_snapshot;
+  }
+  if(snapshot && snapshot_path != NULL) {
+    openSnapshot(snapshot_path); //the caches start from the last run of the shell
+  }
+  if(prefetch) {
+    startPrefetch();
+  }
+  if(spool) {
+    startSpool();
+  }
   blockSignal(); //block SIGINT, SIGQUIT, SIGTSTP
+  catchSigChld(); //claim zombie processes
+
+  if(line != NULL) {
+    return runLine(line);
+  }
+  if(socket_path != NULL) {
+    return runServer(socket_path);
+  }
+  if(replay_path != NULL) {
+    return replaySession(replay_path, speed, stubs);
+  }
 
   //Start of program
   while(strcmp(input, "exit") != 0) {
     getInput(input, prompt);
+    beginLine(input); //for --record
     n_commands = parseCommand(input, command_token, command);
-    for(int i = 0; i < n_commands; i++) {
-      if(builtInCommand(i, command)) {
-        prompt = processPrompt(prompt, new_prompt, i, command);
-        processPWD(i, command);
-        processCD(i, command);
-      }
-      else if((n_pipes = processPipeAndStdin(command_token, i, command)) > 0) {
-        i = i + n_pipes;
-      }
-      else if((n_pipes = processPipeAndStdout(command_token, i, command)) > 0) {
-        i = i + n_pipes;
-      }
-      else if((n_pipes = processPipe(i, command)) > 0) {
-        i = i + n_pipes;
-      }
-      else {
-        processStdin(command_token, i, command);
-        processStdout(command_token, i, command);
-        executeCommand(i, command);
-      }
-      catchSigChld(); //claim zombie processes
-    }
+    runCommands(command_token, command, n_commands, &prompt, new_prompt);
+    endLine();
   }
 
   return 0;
@@ -0,0 +1,459 @@
+/*
+ * File:	metrics.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "command.h"
+#include "metrics.h"
+#include "perfstat.h"
+#include "session.h"
+
+#define STR_SIZE 1024
+#define OTHER_COMMAND 0 //slot of the commands that do not fit into the table
+
+struct HistogramStruct {
+  uint64_t count;
+  uint64_t sum; //nanoseconds
+  uint64_t max;
+  uint64_t buckets[HIST_BUCKETS];
+};
+
+typedef struct HistogramStruct Histogram;
+
+struct CommandMetricsStruct {
+  int state; //0 if free, 1 while the name is written, 2 when in use
+  char name[METRIC_NAME_SIZE];
+  uint64_t failures;
+  Histogram wall;
+};
+
+typedef struct CommandMetricsStruct CommandMetrics;
+
+struct MetricsStruct {
+  Histogram parse;
+  Histogram spawn;
+  Histogram wait;
+  Histogram glob;
+  uint64_t glob_failures;
+  CommandMetrics commands[MAX_METRIC_COMMANDS];
+};
+
+typedef struct MetricsStruct Metrics;
+
+//A child started by forkCommand() and not claimed yet
+struct TrackedChildStruct {
+  pid_t pid; //0 if the slot is free
+  int command; //slot in the command table
+  uint64_t start;
+};
+
+typedef struct TrackedChildStruct TrackedChild;
+
+static Metrics *metrics = NULL;
+static TrackedChild children[MAX_TRACKED_CHILDREN]; //children of this process only
+static uint64_t fork_start = 0; //inherited by the child, for recordExec()
+
+static char *writer_path = NULL;
+static int writer_interval = 0;
+static pid_t writer_pid = 0; //the shell that writes the file, not its children
+
+//Upper bounds of the buckets written to the Prometheus file, in seconds
+static double export_bounds[] = {1e-6, 1e-5, 1e-4, 5e-4, 1e-3, 5e-3, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60, 300, 3600, 0};
+
+//Maps the region shared with the children of the shell
+void initMetrics() {
+  metrics = (Metrics *) mmap(NULL, sizeof(Metrics), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(metrics == MAP_FAILED) {
+    metrics = NULL; //nothing is recorded
+    return;
+  }
+  strcpy(metrics->commands[OTHER_COMMAND].name, "(other)");
+  metrics->commands[OTHER_COMMAND].state = 2;
+}
+
+//Returns the time in nanoseconds
+uint64_t metricsNow() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//Returns the bucket of a time in nanoseconds
+static int bucketIndex(uint64_t ns) {
+  if(ns < HIST_SUB_BUCKETS) {
+    return ns;
+  }
+  int exp = 63 - __builtin_clzll(ns);
+  if(exp > HIST_MAX_EXP) {
+    return HIST_BUCKETS - 1;
+  }
+
+  return (exp - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS + ((ns >> (exp - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+}
+
+//Returns the first time in nanoseconds after the bucket
+static uint64_t bucketEnd(int i) {
+  if(i < HIST_SUB_BUCKETS) {
+    return i + 1;
+  }
+  int exp = i / HIST_SUB_BUCKETS + HIST_SUB_BITS - 1;
+  uint64_t width = (uint64_t) 1 << (exp - HIST_SUB_BITS);
+
+  return (HIST_SUB_BUCKETS + i % HIST_SUB_BUCKETS) * width + width;
+}
+
+//Adds a time in nanoseconds to a histogram
+static void recordTime(Histogram *h, uint64_t ns) {
+  uint64_t max = __atomic_load_n(&(h->max), __ATOMIC_RELAXED);
+
+  __atomic_add_fetch(&(h->buckets[bucketIndex(ns)]), 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&(h->sum), ns, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&(h->count), 1, __ATOMIC_RELAXED);
+  while(ns > max && !__atomic_compare_exchange_n(&(h->max), &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+
+//Records the parsing of a command line that started at start
+void recordParse(uint64_t start) {
+  if(metrics != NULL) {
+    recordTime(&(metrics->parse), metricsNow() - start);
+  }
+}
+
+//Records the time the shell waited for a child, from start
+void recordWait(uint64_t start) {
+  if(metrics != NULL) {
+    recordTime(&(metrics->wait), metricsNow() - start);
+  }
+}
+
+//Stores the sums and counts of the times recorded so far
+void metricsTotals(MetricsTotals *totals) {
+  memset(totals, 0, sizeof(MetricsTotals));
+  if(metrics != NULL) {
+    totals->parse_ns = __atomic_load_n(&(metrics->parse.sum), __ATOMIC_RELAXED);
+    totals->spawn_ns = __atomic_load_n(&(metrics->spawn.sum), __ATOMIC_RELAXED);
+    totals->spawns = __atomic_load_n(&(metrics->spawn.count), __ATOMIC_RELAXED);
+    totals->wait_ns = __atomic_load_n(&(metrics->wait.sum), __ATOMIC_RELAXED);
+  }
+}
+
+//Records a wildcard expansion that started at start
+void recordGlob(uint64_t start, int failed) {
+  if(metrics != NULL) {
+    recordTime(&(metrics->glob), metricsNow() - start);
+    if(failed) {
+      __atomic_add_fetch(&(metrics->glob_failures), 1, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+//Returns the slot of the command table for the name argv[0] ends with
+//The slots are shared by every process of the shell, so a free slot is
+//claimed with compare and swap
+static int commandSlot(char *argv0) {
+  char *slash = strrchr(argv0, '/');
+  char name[METRIC_NAME_SIZE];
+  uint32_t hash = 2166136261u;
+
+  snprintf(name, sizeof(name), "%s", slash == NULL ? argv0 : slash + 1);
+  for(char *p = name; *p != '\0'; p++) {
+    hash = (hash ^ (unsigned char) *p) * 16777619u;
+  }
+  for(int probe = 0; probe < MAX_METRIC_COMMANDS - 1; probe++) {
+    int i = 1 + (hash + probe) % (MAX_METRIC_COMMANDS - 1);
+    CommandMetrics *cm = &(metrics->commands[i]);
+    int state = __atomic_load_n(&(cm->state), __ATOMIC_ACQUIRE);
+    if(state == 0) {
+      if(__atomic_compare_exchange_n(&(cm->state), &state, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        strcpy(cm->name, name);
+        __atomic_store_n(&(cm->state), 2, __ATOMIC_RELEASE);
+        return i;
+      }
+    }
+    while(state == 1) { //another process is writing the name
+      state = __atomic_load_n(&(cm->state), __ATOMIC_ACQUIRE);
+    }
+    if(strcmp(cm->name, name) == 0) {
+      return i;
+    }
+  }
+
+  return OTHER_COMMAND;
+}
+
+//Forks a child that runs the command name, and times it until recordExit()
+pid_t forkCommand(char *name) {
+  pid_t pid;
+
+  perfStatPrepare();
+  fork_start = metricsNow();
+  pid = fork();
+  perfStatForked(pid, name);
+  if(pid > 0) {
+    trackCommand(pid, name, fork_start);
+  }
+
+  return pid;
+}
+
+//Keeps the start of a child for recordExit(), for children not started by forkCommand()
+void trackCommand(pid_t pid, char *name, uint64_t start) {
+  if(metrics == NULL) {
+    return;
+  }
+  int command = commandSlot(name);
+  for(int i = 0; i < MAX_TRACKED_CHILDREN; i++) {
+    if(__atomic_load_n(&(children[i].pid), __ATOMIC_ACQUIRE) == 0) {
+      children[i].command = command;
+      children[i].start = start;
+      //The pid goes last, the SIGCHLD handler may look at the slot at any time
+      __atomic_store_n(&(children[i].pid), pid, __ATOMIC_RELEASE);
+      break;
+    }
+  }
+}
+
+//Records the time from forkCommand() until now, called by the child before exec()
+void recordExec() {
+  if(metrics != NULL && fork_start != 0) {
+    recordTime(&(metrics->spawn), metricsNow() - fork_start);
+  }
+}
+
+//Records the end of a child started by forkCommand()
+//Called from waitChild() and from the SIGCHLD handler
+void recordExit(pid_t pid, int status) {
+  if(metrics == NULL) {
+    return;
+  }
+  for(int i = 0; i < MAX_TRACKED_CHILDREN; i++) {
+    if(__atomic_load_n(&(children[i].pid), __ATOMIC_ACQUIRE) == pid) {
+      CommandMetrics *cm = &(metrics->commands[children[i].command]);
+      uint64_t wall = metricsNow() - children[i].start;
+      recordTime(&(cm->wall), wall);
+      recordSessionCommand(cm->name, wall, status);
+      if(status != 0) {
+        __atomic_add_fetch(&(cm->failures), 1, __ATOMIC_RELAXED);
+      }
+      __atomic_store_n(&(children[i].pid), 0, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+//Returns the time below which a fraction q of the times of a histogram are
+static uint64_t quantile(Histogram *h, double q) {
+  uint64_t count = __atomic_load_n(&(h->count), __ATOMIC_RELAXED);
+  uint64_t max = __atomic_load_n(&(h->max), __ATOMIC_RELAXED);
+  uint64_t seen = 0;
+
+  for(int i = 0; i < HIST_BUCKETS; i++) {
+    seen += __atomic_load_n(&(h->buckets[i]), __ATOMIC_RELAXED);
+    if(seen > 0 && seen >= q * count) {
+      return bucketEnd(i) < max ? bucketEnd(i) : max;
+    }
+  }
+
+  return max;
+}
+
+//Formats a time in nanoseconds with a unit that keeps it short
+char *formatTime(uint64_t ns, char buf[], int size) {
+  if(ns < 1000) {
+    snprintf(buf, size, "%luns", (unsigned long) ns);
+  }
+  else if(ns < 1000000) {
+    snprintf(buf, size, "%.1fus", ns / 1e3);
+  }
+  else if(ns < 1000000000) {
+    snprintf(buf, size, "%.1fms", ns / 1e6);
+  }
+  else {
+    snprintf(buf, size, "%.2fs", ns / 1e9);
+  }
+
+  return buf;
+}
+
+//Prints a line of the stats builtin
+static void printHistogram(char *name, Histogram *h, long failures) {
+  char p50[32], p90[32], p99[32], max[32];
+  uint64_t count = __atomic_load_n(&(h->count), __ATOMIC_RELAXED);
+
+  if(count == 0) {
+    return;
+  }
+  printf("%-20s %8lu ", name, (unsigned long) count);
+  if(failures < 0) {
+    printf("%8s", "-");
+  }
+  else {
+    printf("%8ld", failures);
+  }
+  printf(" %9s %9s %9s %9s\n", formatTime(quantile(h, 0.5), p50, 32), formatTime(quantile(h, 0.9), p90, 32), formatTime(quantile(h, 0.99), p99, 32), formatTime(__atomic_load_n(&(h->max), __ATOMIC_RELAXED), max, 32));
+}
+
+//Prints the metrics for the stats builtin
+void printStats() {
+  if(metrics == NULL) {
+    printf("bash: stats: no metrics\n");
+    return;
+  }
+  printf("%-20s %8s %8s %9s %9s %9s %9s\n", "", "count", "failed", "p50", "p90", "p99", "max");
+  printHistogram("(parse)", &(metrics->parse), -1);
+  printHistogram("(spawn)", &(metrics->spawn), -1);
+  printHistogram("(wait)", &(metrics->wait), -1);
+  printHistogram("(glob)", &(metrics->glob), metrics->glob_failures);
+  for(int i = 0; i < MAX_METRIC_COMMANDS; i++) {
+    CommandMetrics *cm = &(metrics->commands[i]);
+    if(__atomic_load_n(&(cm->state), __ATOMIC_ACQUIRE) == 2) {
+      printHistogram(cm->name, &(cm->wall), __atomic_load_n(&(cm->failures), __ATOMIC_RELAXED));
+    }
+  }
+}
+
+//Writes a histogram in the Prometheus text format
+//labels is empty or ends with ",", e.g. "command=\"ls\","
+static void writeHistogram(FILE *fp, char *metric, char *labels, Histogram *h) {
+  uint64_t cumulative = 0;
+  int i = 0;
+  uint64_t count = __atomic_load_n(&(h->count), __ATOMIC_RELAXED);
+
+  for(int b = 0; export_bounds[b] != 0; b++) {
+    uint64_t bound = (uint64_t) (export_bounds[b] * 1e9);
+    while(i < HIST_BUCKETS && bucketEnd(i) <= bound + 1) {
+      cumulative += __atomic_load_n(&(h->buckets[i]), __ATOMIC_RELAXED);
+      i++;
+    }
+    fprintf(fp, "%s_bucket{%sle=\"%g\"} %lu\n", metric, labels, export_bounds[b], (unsigned long) cumulative);
+  }
+  fprintf(fp, "%s_bucket{%sle=\"+Inf\"} %lu\n", metric, labels, (unsigned long) count);
+  if(labels[0] != '\0') {
+    char plain[STR_SIZE];
+    snprintf(plain, sizeof(plain), "{%.*s}", (int) strlen(labels) - 1, labels);
+    labels = plain;
+    fprintf(fp, "%s_sum%s %.9f\n", metric, labels, __atomic_load_n(&(h->sum), __ATOMIC_RELAXED) / 1e9);
+    fprintf(fp, "%s_count%s %lu\n", metric, labels, (unsigned long) count);
+  }
+  else {
+    fprintf(fp, "%s_sum %.9f\n", metric, __atomic_load_n(&(h->sum), __ATOMIC_RELAXED) / 1e9);
+    fprintf(fp, "%s_count %lu\n", metric, (unsigned long) count);
+  }
+}
+
+//Copies a command name into a label value, escaping \ and "
+static void escapeLabel(char *name, char *value, int size) {
+  int k = 0;
+
+  for(char *p = name; *p != '\0' && k < size - 3; p++) {
+    if(*p == '\\' || *p == '"') {
+      value[k++] = '\\';
+    }
+    value[k++] = *p == '\n' ? ' ' : *p;
+  }
+  value[k] = '\0';
+}
+
+//Writes the metrics to path in the Prometheus text format, atomically
+int writeMetrics(char *path) {
+  char tmp[STR_SIZE];
+  FILE *fp;
+
+  if(metrics == NULL) {
+    return -1;
+  }
+  snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int) getpid());
+  if((fp = fopen(tmp, "w")) == NULL) {
+    return -1;
+  }
+  fprintf(fp, "# HELP shell_parse_seconds Time to parse a command line.\n# TYPE shell_parse_seconds histogram\n");
+  writeHistogram(fp, "shell_parse_seconds", "", &(metrics->parse));
+  fprintf(fp, "# HELP shell_spawn_seconds Time from fork to exec of a command.\n# TYPE shell_spawn_seconds histogram\n");
+  writeHistogram(fp, "shell_spawn_seconds", "", &(metrics->spawn));
+  fprintf(fp, "# HELP shell_wait_seconds Time the shell waits for a command in the foreground.\n# TYPE shell_wait_seconds histogram\n");
+  writeHistogram(fp, "shell_wait_seconds", "", &(metrics->wait));
+  fprintf(fp, "# HELP shell_glob_seconds Time to expand a wildcard.\n# TYPE shell_glob_seconds histogram\n");
+  writeHistogram(fp, "shell_glob_seconds", "", &(metrics->glob));
+  fprintf(fp, "# HELP shell_glob_failures_total Wildcards that matched nothing or failed.\n# TYPE shell_glob_failures_total counter\n");
+  fprintf(fp, "shell_glob_failures_total %lu\n", (unsigned long) __atomic_load_n(&(metrics->glob_failures), __ATOMIC_RELAXED));
+
+  fprintf(fp, "# HELP shell_command_seconds Wall time of a command by name.\n# TYPE shell_command_seconds histogram\n");
+  for(int i = 0; i < MAX_METRIC_COMMANDS; i++) {
+    CommandMetrics *cm = &(metrics->commands[i]);
+    if(__atomic_load_n(&(cm->state), __ATOMIC_ACQUIRE) == 2 && __atomic_load_n(&(cm->wall.count), __ATOMIC_RELAXED) > 0) {
+      char value[2 * METRIC_NAME_SIZE];
+      char labels[3 * METRIC_NAME_SIZE];
+      escapeLabel(cm->name, value, sizeof(value));
+      snprintf(labels, sizeof(labels), "command=\"%s\",", value);
+      writeHistogram(fp, "shell_command_seconds", labels, &(cm->wall));
+    }
+  }
+  fprintf(fp, "# HELP shell_command_failures_total Commands that exited with a status other than 0.\n# TYPE shell_command_failures_total counter\n");
+  for(int i = 0; i < MAX_METRIC_COMMANDS; i++) {
+    CommandMetrics *cm = &(metrics->commands[i]);
+    if(__atomic_load_n(&(cm->state), __ATOMIC_ACQUIRE) == 2 && __atomic_load_n(&(cm->wall.count), __ATOMIC_RELAXED) > 0) {
+      char value[2 * METRIC_NAME_SIZE];
+      escapeLabel(cm->name, value, sizeof(value));
+      fprintf(fp, "shell_command_failures_total{command=\"%s\"} %lu\n", value, (unsigned long) __atomic_load_n(&(cm->failures), __ATOMIC_RELAXED));
+    }
+  }
+
+  if(fclose(fp) != 0 || rename(tmp, path) != 0) {
+    unlink(tmp);
+    return -1;
+  }
+
+  return 0;
+}
+
+//Writes the file every writer_interval seconds
+static void *metricsWriter(void *arg) {
+  while(1) {
+    sleep(writer_interval);
+    writeMetrics(writer_path);
+  }
+
+  return NULL;
+}
+
+//Writes the file a last time when the shell exits, but not when its children do
+static void writeMetricsAtExit() {
+  if(getpid() == writer_pid) {
+    writeMetrics(writer_path);
+  }
+}
+
+//Writes the metrics to path every interval seconds and at exit
+void startMetricsWriter(char *path, int interval) {
+  pthread_t thread;
+  sigset_t all, old;
+
+  writer_path = path;
+  writer_interval = interval > 0 ? interval : 1;
+  writer_pid = getpid();
+  writeMetrics(path);
+  atexit(writeMetricsAtExit);
+
+  //The thread must not take the signals of the shell, e.g. SIGCHLD
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  if(pthread_create(&thread, NULL, metricsWriter, NULL) == 0) {
+    pthread_detach(thread);
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
@@ -0,0 +1,70 @@
+/*
+ * File:	metrics.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Count and time what the shell does: the parsing of command
+		lines, the time from fork() to exec() of a command, the time
+		the shell waits for a command, the wall time and failures
+		of the commands by name, and the time and failures of
+		wildcard expansions.
+
+   Return:	1) forkCommand() returns like fork().
+		2) writeMetrics() returns 0, or -1 if the file cannot be
+		   written.
+		3) metricsTotals() stores the sums of the times of the
+		   parsing, spawning and waiting so far, from which the
+		   times of one command line are found by difference.
+
+   Note:	1) The metrics live in one fixed-size region shared with
+		   every child of the shell, so that subshells and the
+		   children about to exec record into it too. Recording
+		   takes a clock reading and a few atomic additions and
+		   never allocates memory.
+		2) Times are kept in log-linear histograms: each power of 2
+		   of nanoseconds is split into HIST_SUB_BUCKETS buckets,
+		   so a time is known to within 1/HIST_SUB_BUCKETS of it.
+		3) Commands are kept by the name argv[0] ends with, in a
+		   table of MAX_METRIC_COMMANDS names. Commands that do not
+		   fit are counted under "(other)".
+		4) writeMetrics() writes the Prometheus text format to a
+		   temporary file and renames it over "path", so a reader
+		   like the node_exporter textfile collector never sees a
+		   partial file. startMetricsWriter() does this every
+		   "interval" seconds from a thread and when the shell
+		   exits.
+*/
+
+#define HIST_SUB_BITS 3
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_MAX_EXP 44 //times from 2^44 ns (about 4.9 hours) up share the last bucket
+#define HIST_BUCKETS ((HIST_MAX_EXP - HIST_SUB_BITS + 2) * HIST_SUB_BUCKETS)
+#define MAX_METRIC_COMMANDS 128
+#define METRIC_NAME_SIZE 32
+#define MAX_TRACKED_CHILDREN 256
+
+//Sums of the times recorded by every process of the shell, for differences
+struct MetricsTotalsStruct {
+  uint64_t parse_ns;
+  uint64_t spawn_ns;
+  uint64_t spawns;
+  uint64_t wait_ns;
+};
+
+typedef struct MetricsTotalsStruct MetricsTotals;
+
+void initMetrics();
+uint64_t metricsNow();
+void recordParse(uint64_t start);
+void recordWait(uint64_t start);
+void metricsTotals(MetricsTotals *totals);
+void recordGlob(uint64_t start, int failed);
+pid_t forkCommand(char *name);
+void trackCommand(pid_t pid, char *name, uint64_t start);
+void recordExec();
+void recordExit(pid_t pid, int status);
+char *formatTime(uint64_t ns, char buf[], int size);
+void printStats();
+int writeMetrics(char *path);
+void startMetricsWriter(char *path, int interval);
@@ -11,14 +11,33 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <glob.h>
+#include <stdint.h>
 #include "token.h"
 #include "command.h"
 #include "myshell.h"
+#include "walk.h"
+#include "arena.h"
+#include "expand.h"
+#include "heredoc.h"
+#include "job.h"
+#include "pathcache.h"
+#include "lineedit.h"
+#include "fanout.h"
+#include "onchange.h"
+#include "metrics.h"
+#include "ppipe.h"
+#include "records.h"
+#include "perfstat.h"
+#include "zygote.h"
+#include "prefetch.h"
+#include "spool.h"
+#include "textfilter.h"
 
 #define STR_SIZE 1024
 
@@ -39,31 +58,134 @@ void getInput(char input[], char *prompt) {
   int again = 1;
   char *line_pt; //pointer to the line buffer
 
+  //A terminal gets line editing and Tab completion
+  if(isatty(STDIN_FILENO) && isatty(STDOUT_FILENO)) {
+    if(editLine(input, STR_SIZE, prompt) < 0) {
+      strcpy(input, "exit");
+    }
+    return;
+  }
   while(again) {
     again = 0;
     printf("%s ", prompt);
+    fflush(stdout); //the prompt must appear even if stdout is not a terminal
     line_pt = fgets(input, STR_SIZE, stdin);
-    if(input[strlen(input)-1] == '\n') {
-      input[strlen(input)-1] = '\0';
-    }
     if(line_pt == NULL) {
       if(errno == EINTR) {
         again = 1; //signal interruption, read again
       }
+      else {
+        strcpy(input, "exit"); //end of input, exit like bash does
+      }
+    }
+    else if(input[0] != '\0' && input[strlen(input)-1] == '\n') {
+      input[strlen(input)-1] = '\0';
     }
   }
 }
 
 //Parses the input and fills up command
 int parseCommand(char input[], char *token[], Command command[]) {
+  uint64_t start = metricsNow();
+
+  lineArenaReset(); //the tokens of the previous line are no longer used
   initialiseToken(token);
   initialiseCommand(command);
-  tokeniseWhiteSpace(input, token);
+  if(tokeniseWhiteSpace(input, token) < 0) {
+    printf("Too many tokens in command line\n");
+    return 0;
+  }
   int n_commands = separateCommands(token, command);
+  if(n_commands == -6) {
+    perror("realloc");
+    exit(1);
+  }
+  recordParse(start); //the here-documents are read from the user, not parsed
+  if(n_commands > 0 && readHereDocuments(command, n_commands) < 0) {
+    return 0;
+  }
 
   return n_commands;
 }
 
+//Parses and runs a command line, e.g. for "-c" or a subshell
+//Returns the exit status of the last command waited for
+int runLine(char *line) {
+  char *command_token[MAX_NUM_TOKENS];
+  Command command[MAX_NUM_COMMANDS];
+  char *prompt = "%";
+  char new_prompt[STR_SIZE];
+
+  int n_commands = parseCommand(line, command_token, command);
+  runCommands(command_token, command, n_commands, &prompt, new_prompt);
+
+  return lastStatus;
+}
+
+//Runs the commands of a parsed command line
+void runCommands(char *command_token[], Command command[], int n_commands, char **prompt, char new_prompt[]) {
+  int n_pipes;
+  int job;
+
+  prefetchCommands(command, n_commands); //read the later commands from disk while the first runs
+  for(int i = 0; i < n_commands; i++) {
+    job = i;
+    //Expand command substitutions when a job starts
+    if(i == 0 || strcmp(command[i - 1].sep, pipeSep) != 0) {
+      //A fan-out is run by subshells, which expand their own commands
+      if((n_pipes = processFanOut(command_token, i, command, n_commands)) > 0) {
+        i = i + n_pipes;
+        continue;
+      }
+      //onchange runs the rest of the line itself, expanding it on every run
+      if((n_pipes = processOnChange(command_token, i, command, n_commands)) > 0) {
+        i = i + n_pipes - 1;
+        continue;
+      }
+      //perfstat runs the rest of the line itself and reports on it
+      if((n_pipes = processPerfStat(command_token, i, command, n_commands)) > 0) {
+        i = i + n_pipes - 1;
+        continue;
+      }
+      if(expandJob(command_token, i, command, n_commands) < 0) {
+        printf("Too many tokens in command line\n");
+        return;
+      }
+    }
+    if(command[i].argv[0] == NULL) {
+      continue; //the substitutions produced no words
+    }
+    if(!builtInCommand(i, command)) {
+      lookupPath(command[i].argv[0]); //the children find the command in the cache
+    }
+    if(builtInCommand(i, command)) {
+      *prompt = processPrompt(*prompt, new_prompt, i, command);
+      processPWD(i, command);
+      processCD(i, command);
+      processStats(i, command);
+      processJobOut(i, command);
+    }
+    else if((n_pipes = processRecords(i, command)) > 0) {
+      i = i + n_pipes - 1;
+    }
+    else if((n_pipes = processPipeAndStdin(command_token, i, command)) > 0) {
+      i = i + n_pipes;
+    }
+    else if((n_pipes = processPipeAndStdout(command_token, i, command)) > 0) {
+      i = i + n_pipes;
+    }
+    else if((n_pipes = processPipe(i, command)) > 0) {
+      i = i + n_pipes;
+    }
+    else {
+      processStdin(command_token, i, command);
+      processStdout(command_token, i, command);
+      executeCommand(i, command);
+    }
+    closeSubstitutions(command, job, i); //the commands of the job have started
+  }
+}
+
 //Processes the command if argv[0] is "prompt"
 char *processPrompt(char *prompt, char new_prompt[], int index, Command command[]) {
   if(strcmp(command[index].argv[0], "prompt") == 0) {
@@ -94,6 +216,27 @@ void processPWD(int index, Command command[]) {
   }
 }
 
+//Processes the command if argv[0] is "stats"
+void processStats(int index, Command command[]) {
+  if(strcmp(command[index].argv[0], "stats") == 0) {
+    printStats();
+  }
+}
+
+//Processes the command if argv[0] is "jobout", i.e. "jobout %n [-f]"
+void processJobOut(int index, Command command[]) {
+  int n_args = command[index].last - command[index].first;
+
+  if(strcmp(command[index].argv[0], "jobout") == 0) {
+    if(n_args < 1 || n_args > 2 || (n_args == 2 && strcmp(command[index].argv[2], "-f") != 0)) {
+      printf("bash: jobout: usage: jobout %%n [-f]\n");
+    }
+    else if(printJobOutput(atoi(command[index].argv[1] + (command[index].argv[1][0] == '%')), n_args == 2) < 0) {
+      printf("bash: jobout: %s: no spooled output\n", command[index].argv[1]);
+    }
+  }
+}
+
 //Processes the command if argv[0] is "cd"
 void processCD(int index, Command command[]) {
   char dir[STR_SIZE];
@@ -179,29 +322,36 @@ int processPipe(int index, Command command[]) {
       }
     }
 
+    pid_t pids[n_pipes + 1];
+
     //Create first child process
-    if((pid = fork()) == 0) {
+    if((pid = pids[0] = forkCommand(command[index].argv[0])) == 0) {
       dup2(p[1], STDOUT_FILENO); //replace stdout with first pipe write
+      if(command[index].stdin_file != NULL) {
+        int stdin_fd = openStdinFile(&(command[index]));
+        dup2(stdin_fd, STDIN_FILENO); //replace stdin with file or here-document read
+        close(stdin_fd);
+      }
       for(int i = 0; i < n_pipes * 2; i++) {
         close(p[i]);
       }
       if(isWildCard(index, command) != -1) { //-1 means no wildcard, any int >= 0 means wildcard present
         int num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[isWildCard(index, command)]);
-        char *argv[command[index].last - command[index].first + 1 + num_of_wildcard_tokens];
+        char **argv = allocArgv(command[index].last - command[index].first + 1 + num_of_wildcard_tokens);
         getArgvForWildCard(index, command, argv);
-        execvp(argv[0], argv);
+        execArgv(index, command, argv);
       }
       else {
         char *argv[command[index].last - command[index].first + 2];
         getArgvForExecuteCommand(index, command, argv);
-        execvp(argv[0], argv);
+        execArgv(index, command, argv);
       }
       perror("execvp");
       exit(1);
     }
     //Create subsequent child processes
     for(int i = 0; i < n_pipes - 1; i++) {
-      if((pid = fork()) == 0) {
+      if((pid = pids[i + 1] = forkCommand(command[index + i + 1].argv[0])) == 0) {
         dup2(p[i * 2], STDIN_FILENO); //replace stdin with pipe read
         dup2(p[i * 2 + 3], STDOUT_FILENO); //replace stdout with pipe write
         for(int j = 0; j < n_pipes * 2; j++) {
@@ -209,20 +359,20 @@ int processPipe(int index, Command command[]) {
         }
         char *argv[command[index + i + 1].last - command[index + i + 1].first + 2];
         getArgvForExecuteCommand(index + i + 1, command, argv);
-        execvp(argv[0], argv);
+        execArgv(index + i + 1, command, argv);
         perror("execvp");
         exit(1);
       }
     }
     //Create last child process
-    if((pid = fork()) == 0) {
+    if((pid = pids[n_pipes] = forkCommand(command[index + n_pipes].argv[0])) == 0) {
       dup2(p[n_pipes * 2 - 2], STDIN_FILENO); //replace stdin with last pipe read
       for(int i = 0; i < n_pipes * 2; i++) {
         close(p[i]);
       }
       char *argv[command[index + n_pipes].last - command[index + n_pipes].first + 2];
       getArgvForExecuteCommand(index + n_pipes, command, argv);
-      execvp(argv[0], argv);
+      execArgv(index + n_pipes, command, argv);
       perror("execvp");
       exit(1);
     }
@@ -232,7 +382,7 @@ int processPipe(int index, Command command[]) {
       close(p[i]);
     }
     for(int i = 0; i < n_pipes + 1; i++) {
-      wait(NULL);
+      waitChild(pids[i]);
     }
     flag = n_pipes;
   }
@@ -248,16 +398,16 @@ void processStdin(char *command_token[], int index, Command command[]) {
   if(strcmp(command[index].argv[0], "exit") != 0 && command[index].stdin_file != NULL) {
     //Get stdin_index
     for(int i = command[index].first; i <= command[index].last; i++) {
-      if(strcmp(command_token[i], "<") == 0) {
+      if(isStdinRedirection(command_token[i])) {
         stdin_index = i;
       }
     }
     //Number of args after "<" = 1
     if(command[index].last - stdin_index == 1) {
-      stdin_fd = open(command[index].stdin_file, O_RDONLY);
+      stdin_fd = openStdinFile(&(command[index]));
       //Create child process
-      pid_t pid;
-      if((pid = fork()) < 0) {
+      pid_t pid = spawnCommand(index, command, stdin_fd, -1);
+      if(pid < 0 && (pid = forkCommand(command[index].argv[0])) < 0) {
         perror("fork");
         exit(1);
       }
@@ -267,21 +417,21 @@ void processStdin(char *command_token[], int index, Command command[]) {
         close(stdin_fd);
         if(isWildCardForStdinStdout(index, command) != -1) {
           int num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[isWildCardForStdinStdout(index, command)]);
-          char *argv[command[index].last - command[index].first - 1 + num_of_wildcard_tokens];
+          char **argv = allocArgv(command[index].last - command[index].first - 1 + num_of_wildcard_tokens);
           getArgvForWildCardStdinStdout(index, command, argv);
-          execvp(argv[0], argv);
+          execArgv(index, command, argv);
         }
         else {
           char *argv[command[index].last - command[index].first];
           getArgvForStdinStdout(index, command, argv);
-          execvp(argv[0], argv);
+          execArgv(index, command, argv);
         }
         perror("execvp");
         exit(1);
       }
       //Parent process
       close(stdin_fd);
-      wait(NULL);
+      waitChild(pid);
     }
     //Missing arg after "<"
     else if(command[index].last - stdin_index == 0) {
@@ -294,6 +444,18 @@ void processStdin(char *command_token[], int index, Command command[]) {
   }
 }
 
+//Opens the file or here-document that replaces stdin of a command
+int openStdinFile(Command *cp) {
+  if(cp->stdin_doc != NULL) {
+    return openHereDocument(cp->stdin_doc);
+  }
+  if(cp->stdin_op != NULL && strcmp(cp->stdin_op, inHereStr) == 0) {
+    return openHereDocument(hereString(cp->stdin_file));
+  }
+
+  return open(cp->stdin_file, O_RDONLY);
+}
+
 //Processes the command if stdout_file is not null
 void processStdout(char *command_token[], int index, Command command[]) {
   int stdout_index;
@@ -310,8 +472,8 @@ void processStdout(char *command_token[], int index, Command command[]) {
     if(command[index].last - stdout_index == 1) {
       stdout_fd = open(command[index].stdout_file, O_WRONLY | O_CREAT | O_TRUNC, 0664);
       //Create child process
-      pid_t pid;
-      if((pid = fork()) < 0) {
+      pid_t pid = spawnCommand(index, command, -1, stdout_fd);
+      if(pid < 0 && (pid = forkCommand(command[index].argv[0])) < 0) {
         perror("fork");
         exit(1);
       }
@@ -321,21 +483,21 @@ void processStdout(char *command_token[], int index, Command command[]) {
         close(stdout_fd);
         if(isWildCardForStdinStdout(index, command) != -1) {
           int num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[isWildCardForStdinStdout(index, command)]);
-          char *argv[command[index].last - command[index].first - 1 + num_of_wildcard_tokens];
+          char **argv = allocArgv(command[index].last - command[index].first - 1 + num_of_wildcard_tokens);
           getArgvForWildCardStdinStdout(index, command, argv);
-          execvp(argv[0], argv);
+          execArgv(index, command, argv);
         }
         else {
           char *argv[command[index].last - command[index].first];
           getArgvForStdinStdout(index, command, argv);
-          execvp(argv[0], argv);
+          execArgv(index, command, argv);
         }
         perror("execvp");
         exit(1);
       }
       //Parent process
       close(stdout_fd);
-      wait(NULL);
+      waitChild(pid);
     }
     //Missing arg after ">"
     else if(command[index].last - stdout_index == 0) {
@@ -366,16 +528,16 @@ int processPipeAndStdin(char *command_token[], int index, Command command[]) {
   }
 
   //Check that stdin file is not null
-  if(command[index + n_pipes].stdin_file != NULL) {
+  if(n_pipes > 0 && command[index + n_pipes].stdin_file != NULL) {
     //Get stdin_index
     for(int i = command[index + n_pipes].first; i <= command[index + n_pipes].last; i++) {
-      if(strcmp(command_token[i], "<") == 0) {
+      if(isStdinRedirection(command_token[i])) {
         stdin_index = i;
       }
     }
     //Number of args after "<" = 1
     if(command[index + n_pipes].last - stdin_index == 1) {
-      stdin_fd = open(command[index + n_pipes].stdin_file, O_RDONLY);
+      stdin_fd = openStdinFile(&(command[index + n_pipes]));
       //Create child process
       pid_t pid;
       if((pid = fork()) < 0) {
@@ -391,7 +553,7 @@ int processPipeAndStdin(char *command_token[], int index, Command command[]) {
       }
       //Parent process
       close(stdin_fd);
-      wait(NULL);
+      waitChild(pid);
     }
     //Missing arg after "<"
     else if(command[index + n_pipes].last - stdin_index == 0) {
@@ -409,7 +571,7 @@ int processPipeAndStdin(char *command_token[], int index, Command command[]) {
 
 //Processes the command if "|" is present and stdout file is not null
 int processPipeAndStdout(char *command_token[], int index, Command command[]) {
-  int n_pipes;
+  int n_pipes = 0;
   int stdout_index;
   int stdout_fd;
   int flag = 0;
@@ -425,7 +587,7 @@ int processPipeAndStdout(char *command_token[], int index, Command command[]) {
   }
 
   //Check that stdout file is not null
-  if(command[index + n_pipes].stdout_file != NULL) {
+  if(n_pipes > 0 && command[index + n_pipes].stdout_file != NULL) {
     //Get stdout_index
     for(int i = command[index + n_pipes].first; i <= command[index + n_pipes].last; i++) {
       if(strcmp(command_token[i], ">") == 0) {
@@ -450,7 +612,7 @@ int processPipeAndStdout(char *command_token[], int index, Command command[]) {
       }
       //Parent process
       close(stdout_fd);
-      wait(NULL);
+      waitChild(pid);
     }
     //Missing arg after ">"
     else if(command[index + n_pipes].last - stdout_index == 0) {
@@ -468,33 +630,103 @@ int processPipeAndStdout(char *command_token[], int index, Command command[]) {
 
 //Executes all Unix commands
 void executeCommand(int index, Command command[]) {
-  if(strcmp(command[index].argv[0], "exit") != 0) {
-    pid_t pid;
-    if((pid = fork()) < 0) {
+  //Commands with redirections are run by processStdin() and processStdout()
+  if(strcmp(command[index].argv[0], "exit") != 0 && command[index].stdin_file == NULL && command[index].stdout_file == NULL) {
+    int spool_fds[2];
+    int spooled = strcmp(command[index].sep, "&") == 0 && spoolPipe(spool_fds) == 0; //with --spool-jobs
+    pid_t pid = spawnCommand(index, command, -1, -1); //-1 if the shell must fork it
+    if(pid < 0 && (pid = forkCommand(command[index].argv[0])) < 0) {
       perror("fork");
       exit(1);
     }
     //Child process
     if(pid == 0) {
+      if(spooled) {
+        spoolChild(spool_fds);
+      }
       if(isWildCard(index, command) != -1) { //-1 means no wildcard, any int >= 0 means wildcard present
         int num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[isWildCard(index, command)]);
-        char *argv[command[index].last - command[index].first + 1 + num_of_wildcard_tokens];
+        char **argv = allocArgv(command[index].last - command[index].first + 1 + num_of_wildcard_tokens);
         getArgvForWildCard(index, command, argv);
-        execvp(argv[0], argv);
+        execArgv(index, command, argv);
       }
       else {
         char *argv[command[index].last - command[index].first + 2];
         getArgvForExecuteCommand(index, command, argv);
-        execvp(argv[0], argv);
+        execArgv(index, command, argv);
       }
       perror("execvp");
       exit(1);
     }
     //Parent process
     if(strcmp(command[index].sep, "&") != 0) {
-      wait(NULL);
+      waitChild(pid);
+    }
+    else if(spooled) {
+      spoolJob(addJob(pid, JOB_BACKGROUND, command[index].argv[0]), spool_fds);
     }
+    else {
+      addJob(pid, JOB_BACKGROUND, command[index].argv[0]);
+    }
+  }
+}
+
+//Starts command[index] through the zygote, with stdin or stdout replaced by
+//the file if it is not -1, and returns its pid, or -1 if the shell must fork it
+pid_t spawnCommand(int index, Command command[], int stdin_fd, int stdout_fd) {
+  int redirected = command[index].stdin_file != NULL || command[index].stdout_file != NULL;
+
+  //Background jobs are claimed by the SIGCHLD handler, which cannot wait for
+  //the children of the zygote, and wildcards are expanded by the child
+  if(!zygoteRunning() || strcmp(command[index].sep, "&") == 0 || command[index].n_subst_fds > 0 || perfStatActive()
+     || (redirected ? isWildCardForStdinStdout(index, command) : isWildCard(index, command)) != -1) {
+    return -1;
+  }
+  if(redirected && stdin_fd < 0 && stdout_fd < 0) {
+    return -1; //the file could not be opened, forked as before
+  }
+  char *argv[command[index].last - command[index].first + 2];
+  if(redirected) {
+    getArgvForStdinStdout(index, command, argv);
+  }
+  else {
+    getArgvForExecuteCommand(index, command, argv);
+  }
+  char *path = lookupPath(argv[0]);
+  if(path == NULL || strcmp(argv[0], "ppipe") == 0 || isTextFilter(argv)) {
+    return -1;
+  }
+  uint64_t start = metricsNow();
+  pid_t pid = zygoteSpawn(path, argv, stdin_fd, stdout_fd);
+  if(pid > 0) {
+    trackCommand(pid, argv[0], start);
+  }
+
+  return pid;
+}
+
+//Replaces the child process by argv, the arguments of command[index]
+void execArgv(int index, Command command[], char *argv[]) {
+  //Keep the process substitution pipes of this command open across exec
+  for(int i = 0; i < command[index].n_subst_fds; i++) {
+    fcntl(command[index].subst_fds[i], F_SETFD, 0);
+  }
+  if(strcmp(argv[0], "ppipe") == 0) {
+    recordExec();
+    startStageCounters();
+    exit(runParallelPipe(argv)); //the stage is run by this child rather than by a program
+  }
+  if(isTextFilter(argv)) {
+    recordExec();
+    startStageCounters();
+    exit(runTextFilter(argv)); //grep -F, head, wc and cut are run by this child too
+  }
+  char *path = lookupPath(argv[0]);
+  recordExec();
+  if(path != NULL) {
+    execv(path, argv);
   }
+  execvp(argv[0], argv); //not cached, or the cached file has gone
 }
 
 //Catch SIGCHLD to remove zombies from the system
@@ -510,9 +742,13 @@ void catchSigChld() {
 int builtInCommand(int index, Command command[]) {
   int flag = 0;
 
-  if(strcmp(command[index].argv[0], "exit") != 0 && (strcmp(command[index].argv[0], "prompt") == 0 || strcmp(command[index].argv[0], "pwd") == 0 || strcmp(command[index].argv[0], "cd") == 0)) {
+  if(strcmp(command[index].argv[0], "exit") != 0 && (strcmp(command[index].argv[0], "prompt") == 0 || strcmp(command[index].argv[0], "pwd") == 0 || strcmp(command[index].argv[0], "cd") == 0 || strcmp(command[index].argv[0], "stats") == 0 || strcmp(command[index].argv[0], "jobout") == 0)) {
     flag = 1;
   }
+  //pwd writing to a pipe or a file is run as the program, the builtin only prints
+  if(strcmp(command[index].argv[0], "pwd") == 0 && (command[index].stdout_file != NULL || strcmp(command[index].sep, pipeSep) == 0)) {
+    flag = 0;
+  }
 
   return flag;
 }
@@ -562,7 +798,7 @@ int isDirectory(char *filename) {
 int isWildCard(int index, Command command[]) {
   int flag = -1;
 
-  for(int i = 0; i <= command[index].last - command[index].first; i++) {
+  for(int i = 0; i <= command[index].last - command[index].first && command[index].argv[i] != NULL; i++) {
     if(strchr(command[index].argv[i], '*') != NULL || strchr(command[index].argv[i], '?') != NULL) {
       flag = i;
     }
@@ -587,6 +823,13 @@ int isWildCardForStdinStdout(int index, Command command[]) {
 //Returns the number of wildcard files
 int numOfWildCardFiles(char *input) {
   glob_t glob_buf;
+  char **paths;
+  int n_paths;
+
+  if(isRecursiveWildCard(input)) {
+    n_paths = walkGlob(input, &paths);
+    return n_paths < 0 ? 0 : n_paths;
+  }
 
   glob(input, 0, NULL, &glob_buf);
   globfree(&glob_buf);
@@ -597,13 +840,37 @@ int numOfWildCardFiles(char *input) {
 //Stores the wildcard file names in char *token[]
 void expandWildCard(char *input, char *token[]) {
   glob_t glob_buf;
+  char **paths;
+  uint64_t start = metricsNow();
 
-  glob(input, 0, NULL, &glob_buf);
+  if(isRecursiveWildCard(input)) {
+    int n_paths = walkGlob(input, &paths);
+    for(int i = 0; i < n_paths; i++) {
+      token[i] = paths[i];
+    }
+    releaseWalkGlob(); //the next expansion walks the tree again
+    recordGlob(start, n_paths <= 0);
+    return;
+  }
+
+  recordGlob(start, glob(input, 0, NULL, &glob_buf) != 0); //no match counts as a failure
   for(int i = 0; i < glob_buf.gl_pathc; i++) {
     token[i] = glob_buf.gl_pathv[i];
   }
 }
 
+//Allocates an argv of size elements, the matches of a wildcard can be too many for the stack
+char **allocArgv(int size) {
+  char **argv = (char **) malloc(sizeof(char *) * size);
+
+  if(argv == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+
+  return argv;
+}
+
 //Gets char *argv[] for processStdinStdout()
 void getArgvForStdinStdout(int index, Command command[], char *argv[]) {
   for(int i = 0; i <= command[index].last - command[index].first - 2; i++) {
@@ -623,15 +890,20 @@ void getArgvForExecuteCommand(int index, Command command[], char *argv[]) {
 //Gets char *argv[] if wildcard is present
 void getArgvForWildCard(int index, Command command[], char *argv[]) {
   int wildcard_index;
-  char *wildcard_token[MAX_NUM_TOKENS];
+  char **wildcard_token = NULL;
   int num_of_wildcard_tokens;
 
-  for(int i = 0; i <= command[index].last - command[index].first; i++) {
+  for(int i = 0; i <= command[index].last - command[index].first && command[index].argv[i] != NULL; i++) {
       //Get wildcard_index
       if(strchr(command[index].argv[i], '*') != NULL || strchr(command[index].argv[i], '?') != NULL) {
         wildcard_index = i;
-        initialiseToken(wildcard_token);
         num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[i]);
+        //Sized by the number of matches, "**" can match far more than MAX_NUM_TOKENS files
+        wildcard_token = (char **) realloc(wildcard_token, sizeof(char *) * (num_of_wildcard_tokens + 1));
+        if(wildcard_token == NULL) {
+          perror("realloc");
+          exit(1);
+        }
         expandWildCard(command[index].argv[i], wildcard_token); //store all expanded filenames in wildcard_token[]
       }
     }
@@ -651,15 +923,20 @@ void getArgvForWildCard(int index, Command command[], char *argv[]) {
 //Gets char *argv[] if wildcard is present
 void getArgvForWildCardStdinStdout(int index, Command command[], char *argv[]) {
   int wildcard_index;
-  char *wildcard_token[MAX_NUM_TOKENS];
+  char **wildcard_token = NULL;
   int num_of_wildcard_tokens;
 
   for(int i = 0; i <= command[index].last - command[index].first - 2; i++) {
       //Get wildcard_index
       if(strchr(command[index].argv[i], '*') != NULL || strchr(command[index].argv[i], '?') != NULL) {
         wildcard_index = i;
-        initialiseToken(wildcard_token);
         num_of_wildcard_tokens = numOfWildCardFiles(command[index].argv[i]);
+        //Sized by the number of matches, "**" can match far more than MAX_NUM_TOKENS files
+        wildcard_token = (char **) realloc(wildcard_token, sizeof(char *) * (num_of_wildcard_tokens + 1));
+        if(wildcard_token == NULL) {
+          perror("realloc");
+          exit(1);
+        }
         expandWildCard(command[index].argv[i], wildcard_token); //store all expanded filenames in wildcard_token[]
       }
     }
@@ -679,9 +956,5 @@ void getArgvForWildCardStdinStdout(int index, Command command[], char *argv[]) {
 
 //Claims zombie processes
 void claimChildren() {
-  pid_t pid = 1;
-
-  while(pid > 0) {
-    pid = waitpid(0, (int *)0, WNOHANG);
-  }
+  reapJobs(); //foreground children are claimed by waitChild()
 }
@@ -8,15 +8,22 @@
 void blockSignal();
 void getInput(char input[], char *prompt);
 int parseCommand(char input[], char *token[], Command command[]);
+int runLine(char *line);
+void runCommands(char *command_token[], Command command[], int n_commands, char **prompt, char new_prompt[]);
 char *processPrompt(char *prompt, char new_prompt[], int index, Command command[]);
 void processPWD(int index, Command command[]);
 void processCD(int index, Command command[]);
+void processStats(int index, Command command[]);
+void processJobOut(int index, Command command[]);
 int processPipe(int index, Command command[]);
 void processStdin(char *command_token[], int index, Command command[]);
+int openStdinFile(Command *cp);
 void processStdout(char *command_token[], int index, Command command[]);
 int processPipeAndStdin(char *command_token[], int index, Command command[]);
 int processPipeAndStdout(char *command_token[], int index, Command command[]);
 void executeCommand(int index, Command command[]);
+pid_t spawnCommand(int index, Command command[], int stdin_fd, int stdout_fd);
+void execArgv(int index, Command command[], char *argv[]);
 void catchSigChld();
 
 //Helper functions
@@ -28,6 +35,7 @@ int isWildCard(int index, Command command[]);
 int isWildCardForStdinStdout(int index, Command command[]);
 int numOfWildCardFiles(char *input);
 void expandWildCard(char *input, char *token[]);
+char **allocArgv(int size);
 void getArgvForExecuteCommand(int index, Command command[], char *argv[]);
 void getArgvForStdinStdout(int index, Command command[], char *argv[]);
 void getArgvForWildCard(int index, Command command[], char *argv[]);
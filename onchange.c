@@ -0,0 +1,337 @@
+/*
+ * File:	onchange.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "job.h"
+#include "onchange.h"
+
+#define STR_SIZE 1024
+#define EVENT_BUF_SIZE (64 * 1024)
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+
+struct WatchStruct {
+  int wd; //inotify watch of the directory
+  char *dir; //path name of the directory
+  char *name; //the file watched in the directory, or NULL for every file
+  int recursive; //1 if the directories created in it are watched too
+};
+
+typedef struct WatchStruct Watch;
+
+static Watch *watches = NULL;
+static int n_watches = 0;
+static int watches_size = 0;
+
+//Watches the file name of directory dir, or every file of dir if name is NULL
+static void addWatch(int ifd, char *dir, char *name, int recursive) {
+  int wd = inotify_add_watch(ifd, dir, WATCH_MASK | IN_ONLYDIR);
+
+  if(wd < 0) {
+    printf("bash: onchange: %s: %s\n", dir, strerror(errno));
+    return;
+  }
+  if(n_watches == watches_size) {
+    watches_size = watches_size == 0 ? 16 : watches_size * 2;
+    watches = (Watch *) realloc(watches, sizeof(Watch) * watches_size);
+    if(watches == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  watches[n_watches].wd = wd;
+  watches[n_watches].dir = strdup(dir);
+  watches[n_watches].name = name == NULL ? NULL : strdup(name);
+  watches[n_watches].recursive = recursive;
+  n_watches++;
+  if(!recursive || name != NULL) {
+    return;
+  }
+
+  //Watch the directories below dir as well
+  DIR *dp = opendir(dir);
+  struct dirent *d;
+  if(dp == NULL) {
+    return;
+  }
+  while((d = readdir(dp)) != NULL) {
+    char path[PATH_MAX];
+    struct stat st;
+    if(d->d_name[0] == '.') {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+    if(d->d_type == DT_DIR || (d->d_type == DT_UNKNOWN && stat(path, &st) == 0 && S_ISDIR(st.st_mode))) {
+      addWatch(ifd, path, NULL, 1);
+    }
+  }
+  closedir(dp);
+}
+
+//Watches a path given to the builtin
+//A file is watched through its directory, so that it is still watched after
+//an editor has replaced it by a new file
+static void addPath(int ifd, char *path, int recursive) {
+  struct stat st;
+  char dir[PATH_MAX];
+
+  if(stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+    addWatch(ifd, path, NULL, recursive);
+    return;
+  }
+  char *slash = strrchr(path, '/');
+  if(slash == NULL) {
+    addWatch(ifd, ".", path, 0);
+  }
+  else if(slash - path < PATH_MAX) {
+    memcpy(dir, path, slash - path);
+    dir[slash - path] = '\0';
+    addWatch(ifd, slash == path ? "/" : dir, slash + 1, 0);
+  }
+}
+
+//Reads the pending inotify events
+//Returns 1 if one of them is a change of a watched file
+static int readChanges(int ifd) {
+  char buf[EVENT_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t n;
+  int changed = 0;
+
+  while((n = read(ifd, buf, sizeof(buf))) > 0) {
+    for(char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event *) p)->len) {
+      struct inotify_event *ev = (struct inotify_event *) p;
+      if(ev->len == 0 || ev->name[0] == '.') {
+        continue;
+      }
+      int n_old = n_watches; //addWatch() may add to the table
+      for(int i = 0; i < n_old; i++) {
+        if(watches[i].wd != ev->wd) {
+          continue;
+        }
+        if(watches[i].name == NULL || strcmp(watches[i].name, ev->name) == 0) {
+          changed = 1;
+        }
+        if(watches[i].recursive && (ev->mask & IN_CREATE) && (ev->mask & IN_ISDIR)) {
+          char path[PATH_MAX];
+          snprintf(path, sizeof(path), "%s/%s", watches[i].dir, ev->name);
+          addWatch(ifd, path, NULL, 1);
+        }
+      }
+    }
+  }
+
+  return changed;
+}
+
+//Forgets the watches of the builtin
+static void clearWatches(int ifd) {
+  for(int i = 0; i < n_watches; i++) {
+    free(watches[i].dir);
+    free(watches[i].name);
+  }
+  free(watches);
+  watches = NULL;
+  n_watches = 0;
+  watches_size = 0;
+  close(ifd);
+}
+
+//Runs the parsed commands in a child of the shell, in a process group of its own
+static pid_t startRun(char *command_token[], Command run[], int n_run) {
+  pid_t pid;
+
+  fflush(stdout);
+  if((pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if(pid == 0) {
+    char *prompt = "%";
+    char new_prompt[STR_SIZE];
+
+    setpgid(0, 0);
+    runCommands(command_token, run, n_run, &prompt, new_prompt);
+    exit(lastStatus);
+  }
+  setpgid(pid, pid); //either call may run first, kill() must find the group
+
+  return pid;
+}
+
+//Kills the run and everything it started, and claims it
+static void stopRun(pid_t pid) {
+  kill(-pid, SIGTERM);
+  waitChild(pid);
+}
+
+//Returns a descriptor that is readable once the process pid has ended, or -1
+static int openPid(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return syscall(SYS_pidfd_open, pid, 0);
+#else
+  return -1;
+#endif
+}
+
+//Watches the paths and runs the commands until SIGINT arrives
+static void watchAndRun(int ifd, int sfd, char *command_token[], Command run[], int n_run) {
+  struct signalfd_siginfo si;
+  pid_t pid = startRun(command_token, run, n_run);
+  int pfd = openPid(pid);
+
+  while(1) {
+    struct pollfd fds[3] = {{sfd, POLLIN, 0}, {ifd, POLLIN, 0}, {pfd, POLLIN, 0}};
+    if(poll(fds, pfd >= 0 ? 3 : 2, -1) < 0) {
+      continue; //interrupted by SIGCHLD
+    }
+    if(fds[0].revents & POLLIN) {
+      break; //Ctrl-C
+    }
+    if(pfd >= 0 && (fds[2].revents & POLLIN)) {
+      waitChild(pid); //the run has finished
+      close(pfd);
+      pfd = -1;
+      pid = -1;
+    }
+    if(!(fds[1].revents & POLLIN) || !readChanges(ifd)) {
+      continue;
+    }
+
+    //A change makes the run going on out of date
+    if(pid > 0) {
+      stopRun(pid);
+      pid = -1;
+    }
+    if(pfd >= 0) {
+      close(pfd);
+      pfd = -1;
+    }
+
+    //Wait until the changes stop for a while, e.g. while a build writes many files
+    int quiet = 0;
+    while(!quiet) {
+      struct pollfd wait_fds[2] = {{sfd, POLLIN, 0}, {ifd, POLLIN, 0}};
+      int n = poll(wait_fds, 2, ONCHANGE_DEBOUNCE_MS);
+      if(n > 0 && (wait_fds[0].revents & POLLIN)) {
+        break;
+      }
+      if(n > 0) {
+        readChanges(ifd);
+      }
+      quiet = n == 0;
+    }
+    if(!quiet) {
+      break;
+    }
+    pid = startRun(command_token, run, n_run);
+    pfd = openPid(pid);
+  }
+
+  read(sfd, &si, sizeof(si));
+  if(pid > 0) {
+    stopRun(pid);
+  }
+  if(pfd >= 0) {
+    close(pfd);
+  }
+  lastStatus = 128 + SIGINT; //ended by Ctrl-C like a foreground command
+}
+
+//Processes the command if argv[0] is "onchange"
+int processOnChange(char *command_token[], int index, Command command[], int n_commands) {
+  if(strcmp(command[index].argv[0], "onchange") != 0) {
+    return 0;
+  }
+  int n_rest = n_commands - index - 1; //commands after this one
+
+  //The paths go up to "--", the command line starts after it
+  int recursive = command[index].argv[1] != NULL && strcmp(command[index].argv[1], "-r") == 0;
+  int first_path = 1 + recursive;
+  int dashes = first_path;
+  while(command[index].argv[dashes] != NULL && strcmp(command[index].argv[dashes], "--") != 0) {
+    dashes++;
+  }
+  int t = command[index].first;
+  while(t <= command[index].last && strcmp(command_token[t], "--") != 0) {
+    t++;
+  }
+  if(dashes == first_path || command[index].argv[dashes] == NULL || command[index].argv[dashes + 1] == NULL || t >= command[index].last) {
+    printf("bash: onchange: usage: onchange [-r] paths... -- command line\n");
+    return n_rest + 1;
+  }
+
+  int ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(ifd < 0) {
+    perror("inotify_init1");
+    return n_rest + 1;
+  }
+  for(int i = first_path; i < dashes; i++) {
+    char *path = command[index].argv[i];
+    if(strchr(path, '*') != NULL || strchr(path, '?') != NULL) {
+      int n_paths = numOfWildCardFiles(path);
+      char **paths = allocArgv(n_paths + 1);
+      expandWildCard(path, paths);
+      for(int j = 0; j < n_paths; j++) {
+        addPath(ifd, paths[j], recursive);
+        free(paths[j]); //the watches keep copies
+      }
+      free(paths);
+    }
+    else {
+      addPath(ifd, path, recursive);
+    }
+  }
+  if(n_watches == 0) {
+    clearWatches(ifd);
+    return n_rest + 1;
+  }
+
+  //SIGINT is blocked in the shell, so Ctrl-C is read from a signalfd
+  //Ctrl-C pressed before onchange started is thrown away first
+  sigset_t sigint;
+  struct signalfd_siginfo si;
+  sigemptyset(&sigint);
+  sigaddset(&sigint, SIGINT);
+  int sfd = signalfd(-1, &sigint, SFD_NONBLOCK | SFD_CLOEXEC);
+  if(sfd < 0) {
+    perror("signalfd");
+    clearWatches(ifd);
+    return n_rest + 1;
+  }
+  while(read(sfd, &si, sizeof(si)) > 0) {
+  }
+
+  //The first command of the command line is the part of this one after "--"
+  Command run[n_rest + 1];
+  memcpy(run, command + index, sizeof(Command) * (n_rest + 1));
+  run[0].first = t + 1;
+  run[0].argv = NULL;
+  buildCommand(command_token, &(run[0]));
+
+  watchAndRun(ifd, sfd, command_token, run, n_rest + 1);
+
+  free(run[0].argv);
+  close(sfd);
+  clearWatches(ifd);
+
+  return n_rest + 1;
+}
@@ -0,0 +1,28 @@
+/*
+ * File:	onchange.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	The builtin "onchange [-r] paths... -- command line", which
+		runs the command line, and runs it again every time one of
+		the paths changes, until Ctrl-C is pressed.
+
+   Return:	The number of commands taken by the builtin, i.e. the one
+		holding "onchange" and the rest of the command line, or 0
+		if argv[0] is not "onchange".
+
+   Note:	1) The paths may contain wildcards. A directory stands for
+		   the files in it, and with -r for the files below it.
+		   Files whose names start with "." are left out.
+		2) The changes are read with inotify. A run starts once no
+		   change has been seen for ONCHANGE_DEBOUNCE_MS, and the
+		   run still going when a change is seen is killed first.
+		3) The command line is parsed once. Every run is a child of
+		   the shell that runs the parsed commands in a process
+		   group of its own, so the whole run can be killed.
+*/
+
+#define ONCHANGE_DEBOUNCE_MS 100
+
+int processOnChange(char *command_token[], int index, Command command[], int n_commands);
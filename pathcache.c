@@ -0,0 +1,400 @@
+/*
+ * File:	pathcache.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "pathcache.h"
+#include "snapshot.h"
+
+struct PathEntryStruct {
+  char *name; //command name, NULL if the slot is unused
+  char *path; //full path name of the command
+};
+
+typedef struct PathEntryStruct PathEntry;
+
+static PathEntry *table = NULL; //open addressing with linear probing
+static int table_size = 0;
+static int n_entries = 0;
+static char *path_env = NULL; //value of PATH the entries were found with
+
+//The section of the snapshot holding the cache, followed by the modification
+//times of the PATH directories as int64_t[n_dirs][2], the table as
+//uint32_t[table_size][2] with the offsets of the name and path of each
+//command, or 0 in unused slots, and the strings. Offsets are from the start
+//of the section.
+struct PathSnapshotStruct {
+  uint32_t path_env; //offset of the value of PATH the entries were found with
+  uint32_t n_dirs;
+  uint32_t table_size; //a power of 2
+  uint32_t n_entries;
+  uint32_t complete; //1 if the table has every executable of PATH, as after warmPathCache()
+  uint32_t unused;
+};
+
+typedef struct PathSnapshotStruct PathSnapshot;
+
+static PathSnapshot *snap = NULL; //the snapshot of the cache if it holds for path_env
+static int64_t (*dir_mtime)[2] = NULL; //modification times of the PATH directories
+static int n_dirs = 0; //-1 if PATH has a relative directory, which a snapshot cannot check
+static int dirty = 0; //1 if the cache has entries the snapshot has not
+static int warmed = 0; //1 if the cache has every executable of PATH
+
+//Returns the FNV-1a hash of a string
+static uint32_t hashName(char *name) {
+  uint32_t h = 2166136261u;
+
+  while(*name != '\0') {
+    h = (h ^ (unsigned char) *name++) * 16777619u;
+  }
+
+  return h;
+}
+
+//Returns the slot of name, or the empty slot where it belongs
+static PathEntry *findSlot(char *name) {
+  uint32_t i = hashName(name) & (table_size - 1);
+
+  while(table[i].name != NULL && strcmp(table[i].name, name) != 0) {
+    i = (i + 1) & (table_size - 1);
+  }
+
+  return &(table[i]);
+}
+
+//Returns the table of the snapshot
+static uint32_t *snapshotSlots() {
+  return (uint32_t *) ((char *) snap + sizeof(PathSnapshot) + snap->n_dirs * sizeof(dir_mtime[0]));
+}
+
+//Returns the full path name of a command in the snapshot, or NULL
+static char *findSnapshot(char *name) {
+  char *base = (char *) snap;
+  uint32_t *slot = snapshotSlots();
+  uint32_t i = hashName(name) & (snap->table_size - 1);
+
+  while(slot[2 * i] != 0) {
+    if(strcmp(base + slot[2 * i], name) == 0) {
+      return base + slot[2 * i + 1];
+    }
+    i = (i + 1) & (snap->table_size - 1);
+  }
+
+  return NULL;
+}
+
+//Reads the modification times of the directories of path_env
+static void statDirs() {
+  struct stat buf;
+  char dir_name[PATH_MAX];
+  char *dir = path_env;
+
+  free(dir_mtime);
+  n_dirs = 0;
+  dir_mtime = (int64_t (*)[2]) malloc((strlen(path_env) + 1) * sizeof(dir_mtime[0]));
+  if(dir_mtime == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  while(n_dirs >= 0) {
+    size_t len = strcspn(dir, ":");
+    if(dir[0] != '/' || len >= sizeof(dir_name)) {
+      n_dirs = -1; //e.g. an empty entry, the current directory
+      break;
+    }
+    memcpy(dir_name, dir, len);
+    dir_name[len] = '\0';
+    if(stat(dir_name, &buf) == 0) {
+      dir_mtime[n_dirs][0] = buf.st_mtim.tv_sec;
+      dir_mtime[n_dirs][1] = buf.st_mtim.tv_nsec;
+    }
+    else {
+      dir_mtime[n_dirs][0] = -1;
+      dir_mtime[n_dirs][1] = -1;
+    }
+    n_dirs++;
+    dir += len;
+    if(*dir == '\0') {
+      break;
+    }
+    dir++;
+  }
+}
+
+//Returns the snapshot of the cache if it was taken with path_env and the
+//PATH directories have not changed since, otherwise NULL
+static PathSnapshot *checkSnapshot() {
+  size_t size;
+  PathSnapshot *s = (PathSnapshot *) snapshotSection(SNAPSHOT_PATH_INDEX, &size);
+  char *base = (char *) s;
+
+  if(s == NULL || n_dirs < 0 || size < sizeof(PathSnapshot) || base[size - 1] != '\0') {
+    return NULL;
+  }
+  //Every offset must lie in the section, which ends with a '\0'
+  size_t slots_end = sizeof(PathSnapshot) + (size_t) s->n_dirs * sizeof(dir_mtime[0]) + (size_t) s->table_size * 2 * sizeof(uint32_t);
+  if(s->table_size == 0 || (s->table_size & (s->table_size - 1)) != 0 || slots_end > size || s->path_env >= size) {
+    return NULL;
+  }
+  if(strcmp(base + s->path_env, path_env) != 0 || s->n_dirs != (uint32_t) n_dirs
+     || memcmp(base + sizeof(PathSnapshot), dir_mtime, n_dirs * sizeof(dir_mtime[0])) != 0) {
+    return NULL;
+  }
+  uint32_t *slot = (uint32_t *) (base + sizeof(PathSnapshot) + n_dirs * sizeof(dir_mtime[0]));
+  uint32_t used = 0;
+  for(uint32_t i = 0; i < 2 * s->table_size; i += 2) {
+    if(slot[i] != 0) {
+      if(slot[i] < slots_end || slot[i] >= size || slot[i + 1] < slots_end || slot[i + 1] >= size) {
+        return NULL;
+      }
+      used++;
+    }
+  }
+  if(used >= s->table_size) {
+    return NULL; //a full table would never end a search
+  }
+
+  return s;
+}
+
+//Empties the cache
+static void clearPathCache() {
+  for(int i = 0; i < table_size; i++) {
+    free(table[i].name);
+    free(table[i].path);
+  }
+  free(table);
+  table = NULL;
+  table_size = 0;
+  n_entries = 0;
+}
+
+//Empties the cache if PATH is not the one the entries were found with
+static void checkPathEnv() {
+  char *env = getenv("PATH");
+
+  if(env == NULL) {
+    env = "";
+  }
+  if(path_env == NULL || strcmp(path_env, env) != 0) {
+    clearPathCache();
+    free(path_env);
+    path_env = strdup(env);
+    statDirs();
+    snap = checkSnapshot();
+    dirty = 0;
+    warmed = 0;
+  }
+}
+
+//Adds a command unless it is already in the cache
+static void addPath(char *name, char *path) {
+  //Keep the table at most half full
+  if(2 * (n_entries + 1) > table_size) {
+    PathEntry *old = table;
+    int old_size = table_size;
+
+    table_size = table_size == 0 ? 256 : table_size * 2;
+    table = (PathEntry *) calloc(table_size, sizeof(PathEntry));
+    if(table == NULL) {
+      perror("calloc");
+      exit(1);
+    }
+    for(int i = 0; i < old_size; i++) {
+      if(old[i].name != NULL) {
+        *findSlot(old[i].name) = old[i];
+      }
+    }
+    free(old);
+  }
+
+  PathEntry *slot = findSlot(name);
+  if(slot->name == NULL) {
+    slot->name = strdup(name);
+    slot->path = strdup(path);
+    n_entries++;
+    dirty |= snap == NULL || findSnapshot(name) == NULL;
+  }
+}
+
+//Returns 1 if path is an executable file
+static int isExecutable(char *path) {
+  struct stat buf;
+
+  return access(path, X_OK) == 0 && stat(path, &buf) == 0 && S_ISREG(buf.st_mode);
+}
+
+//Returns the full path name of a command found through PATH
+char *lookupPath(char *name) {
+  char path[PATH_MAX];
+
+  if(strchr(name, '/') != NULL || name[0] == '\0') {
+    return NULL;
+  }
+  checkPathEnv();
+  if(table != NULL) {
+    PathEntry *slot = findSlot(name);
+    if(slot->name != NULL) {
+      return slot->path;
+    }
+  }
+  if(snap != NULL) {
+    char *path = findSnapshot(name);
+    if(path != NULL) {
+      return path;
+    }
+  }
+
+  //Search the directories of PATH in order, like execvp()
+  char *dir = path_env;
+  while(*dir != '\0') {
+    size_t len = strcspn(dir, ":");
+    if(len == 0) {
+      snprintf(path, sizeof(path), "%s", name); //empty entry is the current directory
+    }
+    else {
+      snprintf(path, sizeof(path), "%.*s/%s", (int) len, dir, name);
+    }
+    if(isExecutable(path)) {
+      addPath(name, path);
+      return findSlot(name)->path;
+    }
+    dir += len;
+    if(*dir == ':') {
+      dir++;
+    }
+  }
+
+  return NULL;
+}
+
+//Adds every executable in the directories of PATH
+void warmPathCache() {
+  char path[PATH_MAX];
+  char dir_name[PATH_MAX];
+  struct dirent *de;
+
+  checkPathEnv();
+  if(snap != NULL && snap->complete) {
+    return; //lookups find every command in the snapshot
+  }
+  char *dir = path_env;
+  while(*dir != '\0') {
+    size_t len = strcspn(dir, ":");
+    if(len > 0 && len < sizeof(dir_name)) {
+      memcpy(dir_name, dir, len);
+      dir_name[len] = '\0';
+      DIR *dp = opendir(dir_name);
+      if(dp != NULL) {
+        while((de = readdir(dp)) != NULL) {
+          if(de->d_name[0] == '.') {
+            continue;
+          }
+          snprintf(path, sizeof(path), "%s/%s", dir_name, de->d_name);
+          //Earlier directories win, so only check names not seen yet
+          if((table == NULL || findSlot(de->d_name)->name == NULL) && isExecutable(path)) {
+            addPath(de->d_name, path);
+          }
+        }
+        closedir(dp);
+      }
+    }
+    dir += len;
+    if(*dir == ':') {
+      dir++;
+    }
+  }
+  warmed = 1;
+}
+
+//Returns a new section of the snapshot holding the cache and the entries of
+//the snapshot it started with, or NULL if the snapshot has them all already
+void *buildPathSnapshot(size_t *size) {
+  if(!(dirty || (warmed && (snap == NULL || !snap->complete))) || path_env == NULL || n_dirs < 0) {
+    return NULL;
+  }
+
+  //Count the entries and the bytes of their strings, the cache first
+  uint32_t *old = snap != NULL ? snapshotSlots() : NULL;
+  size_t n = 0;
+  size_t strings = strlen(path_env) + 1;
+  for(int i = 0; i < table_size; i++) {
+    if(table[i].name != NULL) {
+      n++;
+      strings += strlen(table[i].name) + strlen(table[i].path) + 2;
+    }
+  }
+  for(uint32_t i = 0; old != NULL && i < snap->table_size; i++) {
+    char *name = (char *) snap + old[2 * i];
+    if(old[2 * i] != 0 && (table == NULL || findSlot(name)->name == NULL)) {
+      n++;
+      strings += strlen(name) + strlen((char *) snap + old[2 * i + 1]) + 2;
+    }
+  }
+  uint32_t new_size = 16;
+  while(new_size < 2 * (n + 1)) {
+    new_size *= 2;
+  }
+
+  size_t slots_start = sizeof(PathSnapshot) + n_dirs * sizeof(dir_mtime[0]);
+  size_t total = slots_start + (size_t) new_size * 2 * sizeof(uint32_t) + strings;
+  if(total > UINT32_MAX) {
+    return NULL;
+  }
+  char *data = (char *) calloc(1, total);
+  if(data == NULL) {
+    return NULL;
+  }
+  PathSnapshot *s = (PathSnapshot *) data;
+  uint32_t *slot = (uint32_t *) (data + slots_start);
+  size_t end = slots_start + (size_t) new_size * 2 * sizeof(uint32_t);
+  s->n_dirs = n_dirs;
+  s->table_size = new_size;
+  s->n_entries = n;
+  s->complete = warmed || (snap != NULL && snap->complete);
+  memcpy(data + sizeof(PathSnapshot), dir_mtime, n_dirs * sizeof(dir_mtime[0]));
+  s->path_env = end;
+  end += strlen(strcpy(data + end, path_env)) + 1;
+
+  //Insert the cache, then what only the old snapshot has
+  for(int pass = 0; pass < 2; pass++) {
+    int count = pass == 0 ? table_size : (old != NULL ? snap->table_size : 0);
+    for(int i = 0; i < count; i++) {
+      char *name, *path;
+      if(pass == 0) {
+        name = table[i].name;
+        path = table[i].path;
+      }
+      else {
+        name = old[2 * i] != 0 ? (char *) snap + old[2 * i] : NULL;
+        path = (char *) snap + old[2 * i + 1];
+        if(name != NULL && table != NULL && findSlot(name)->name != NULL) {
+          name = NULL;
+        }
+      }
+      if(name == NULL) {
+        continue;
+      }
+      uint32_t j = hashName(name) & (new_size - 1);
+      while(slot[2 * j] != 0) {
+        j = (j + 1) & (new_size - 1);
+      }
+      slot[2 * j] = end;
+      end += strlen(strcpy(data + end, name)) + 1;
+      slot[2 * j + 1] = end;
+      end += strlen(strcpy(data + end, path)) + 1;
+    }
+  }
+  *size = total;
+
+  return data;
+}
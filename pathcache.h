@@ -0,0 +1,34 @@
+/*
+ * File:	pathcache.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Remember where the commands found through PATH live, so that
+		running a command again does not search every directory of
+		PATH.
+
+   Return:	1) lookupPath() returns the full path name of the command, or
+		   NULL if the name contains a "/" or the command is not
+		   found.
+		2) buildPathSnapshot() returns a section for the snapshot
+		   file, to be freed, and stores its size in "size", or
+		   returns NULL if the snapshot has every entry already.
+
+   Note:	1) The cache is emptied when PATH changes. An entry that has
+		   gone stale is noticed by execArgv(), which falls back to
+		   execvp().
+		2) warmPathCache() enters every executable of every PATH
+		   directory at once, for processes that serve many command
+		   lines, like the shell server.
+		3) With a snapshot, a command not in the cache is looked up
+		   in the table of the snapshot before PATH is searched.
+		   The snapshot is only used if it was taken with the same
+		   PATH, and the directories of PATH have not been
+		   modified since, which is checked at the first lookup.
+		   A PATH with a relative directory is never snapshotted.
+*/
+
+char *lookupPath(char *name);
+void warmPathCache();
+void *buildPathSnapshot(size_t *size);
@@ -0,0 +1,372 @@
+/*
+ * File:	perfstat.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/perf_event.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "job.h"
+#include "metrics.h"
+#include "perfstat.h"
+
+#define STR_SIZE 1024
+#define N_EVENTS 4
+#define EV_CYCLES 0
+#define EV_INSTRUCTIONS 1
+#define EV_CACHE_MISSES 2
+#define EV_CONTEXT_SWITCHES 3
+
+struct StageStatStruct {
+  char name[PERF_NAME_SIZE];
+  uint64_t start; //ns of metricsNow()
+  uint64_t end; //0 until the command has been claimed
+  int64_t counts[N_EVENTS]; //-1 where the event could not be counted
+  double user; //seconds
+  double sys;
+  long nvcsw; //voluntary context switches, e.g. waiting for I/O
+  long nivcsw; //involuntary ones
+  uint64_t rchar; //bytes read, from /proc/pid/io
+  uint64_t wchar;
+};
+
+typedef struct StageStatStruct StageStat;
+
+struct PerfRunStruct {
+  int n_stages;
+  StageStat stages[MAX_PERF_STAGES];
+};
+
+typedef struct PerfRunStruct PerfRun;
+
+//A child of this process being counted
+struct CountedChildStruct {
+  pid_t pid; //0 if the slot is free
+  int stage; //slot in the shared table
+  int fds[N_EVENTS]; //perf event descriptors, -1 where none
+};
+
+typedef struct CountedChildStruct CountedChild;
+
+static struct {
+  uint32_t type;
+  uint64_t config;
+} events[N_EVENTS] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}
+};
+
+static PerfRun *perf_run = NULL; //shared table while perfstat runs, inherited by subshells
+static CountedChild counted[MAX_PERF_STAGES]; //children of this process only
+static int sync_fds[2] = {-1, -1}; //holds the child until its counters are open
+static int user_only = 0; //1 once counting the kernel has been refused
+
+//Opens a counter of the event for the process pid, which starts at its exec
+//Returns the descriptor, or -1
+static int openCounter(int event, pid_t pid) {
+  struct perf_event_attr attr;
+  int fd;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = events[event].type;
+  attr.config = events[event].config;
+  attr.disabled = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit = 1; //count the processes it starts too
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = user_only;
+  attr.exclude_hv = 1;
+  fd = syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+  if(fd < 0 && (errno == EACCES || errno == EPERM) && !user_only) {
+    user_only = 1; //perf_event_paranoid 2 still allows counting user space
+    return openCounter(event, pid);
+  }
+
+  return fd;
+}
+
+//Reads a counter, scaled up if it was not always on the CPU
+//Returns -1 if there is none
+static int64_t readCounter(int fd) {
+  uint64_t v[3]; //value, time enabled, time running
+
+  if(fd < 0 || read(fd, v, sizeof(v)) != sizeof(v)) {
+    return -1;
+  }
+  if(v[2] > 0 && v[2] < v[1]) {
+    return (int64_t) ((double) v[0] * v[1] / v[2]);
+  }
+
+  return v[0];
+}
+
+//Returns 1 while perfstat runs
+int perfStatActive() {
+  return perf_run != NULL;
+}
+
+//Makes the pipe that holds the next child of forkCommand() until its counters are open
+void perfStatPrepare() {
+  if(perf_run == NULL) {
+    return;
+  }
+  if(pipe2(sync_fds, O_CLOEXEC) < 0) {
+    sync_fds[0] = sync_fds[1] = -1;
+  }
+}
+
+//Opens the counters of the child of forkCommand(), or in the child waits for them
+void perfStatForked(pid_t pid, char *name) {
+  char c;
+
+  if(perf_run == NULL) {
+    return;
+  }
+  if(pid == 0) {
+    //The counters of the siblings belong to the parent
+    for(int i = 0; i < MAX_PERF_STAGES; i++) {
+      for(int e = 0; counted[i].pid != 0 && e < N_EVENTS; e++) {
+        if(counted[i].fds[e] >= 0) {
+          close(counted[i].fds[e]);
+        }
+      }
+      counted[i].pid = 0;
+    }
+    if(sync_fds[0] >= 0) {
+      close(sync_fds[1]);
+      while(read(sync_fds[0], &c, 1) < 0 && errno == EINTR) {
+      }
+      close(sync_fds[0]);
+    }
+    return;
+  }
+
+  int stage = __atomic_fetch_add(&(perf_run->n_stages), 1, __ATOMIC_RELAXED);
+  int slot = 0;
+  while(slot < MAX_PERF_STAGES && counted[slot].pid != 0) {
+    slot++;
+  }
+  if(pid > 0 && stage < MAX_PERF_STAGES && slot < MAX_PERF_STAGES) {
+    StageStat *st = &(perf_run->stages[stage]);
+    char *base = strrchr(name, '/');
+    snprintf(st->name, sizeof(st->name), "%s", base == NULL ? name : base + 1);
+    st->start = metricsNow();
+    counted[slot].pid = pid;
+    counted[slot].stage = stage;
+    for(int e = 0; e < N_EVENTS; e++) {
+      counted[slot].fds[e] = openCounter(e, pid);
+    }
+  }
+  if(sync_fds[0] >= 0) {
+    close(sync_fds[0]);
+    close(sync_fds[1]); //the child goes on
+    sync_fds[0] = sync_fds[1] = -1;
+  }
+}
+
+//Starts the counters of a child of forkCommand() that does not exec
+void startStageCounters() {
+  if(perf_run != NULL) {
+    prctl(PR_TASK_PERF_EVENTS_ENABLE);
+  }
+}
+
+//Returns the slot of the child pid in counted[], or -1
+static int countedSlot(pid_t pid) {
+  for(int i = 0; perf_run != NULL && i < MAX_PERF_STAGES; i++) {
+    if(counted[i].pid == pid) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+//Waits until the child pid has ended without claiming it, and reads its
+///proc/pid/io, which goes away once it is claimed
+void perfStatExiting(pid_t pid) {
+  int slot = countedSlot(pid);
+  siginfo_t info;
+  char path[STR_SIZE];
+  char line[STR_SIZE];
+
+  if(slot < 0) {
+    return;
+  }
+  while(waitid(P_PID, pid, &info, WEXITED | WNOWAIT) < 0) {
+    if(errno != EINTR) {
+      return;
+    }
+  }
+  StageStat *st = &(perf_run->stages[counted[slot].stage]);
+  snprintf(path, sizeof(path), "/proc/%d/io", (int) pid);
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL) {
+    return;
+  }
+  while(fgets(line, sizeof(line), fp) != NULL) {
+    unsigned long long v;
+    if(sscanf(line, "rchar: %llu", &v) == 1) {
+      st->rchar = v;
+    }
+    else if(sscanf(line, "wchar: %llu", &v) == 1) {
+      st->wchar = v;
+    }
+  }
+  fclose(fp);
+}
+
+//Records the counters and rusage of the child pid, which has been claimed
+void perfStatExited(pid_t pid, struct rusage *ru) {
+  int slot = countedSlot(pid);
+
+  if(slot < 0) {
+    return;
+  }
+  StageStat *st = &(perf_run->stages[counted[slot].stage]);
+  st->end = metricsNow();
+  st->user = ru->ru_utime.tv_sec + ru->ru_utime.tv_usec / 1e6;
+  st->sys = ru->ru_stime.tv_sec + ru->ru_stime.tv_usec / 1e6;
+  st->nvcsw = ru->ru_nvcsw;
+  st->nivcsw = ru->ru_nivcsw;
+  for(int e = 0; e < N_EVENTS; e++) {
+    st->counts[e] = readCounter(counted[slot].fds[e]);
+    if(counted[slot].fds[e] >= 0) {
+      close(counted[slot].fds[e]);
+    }
+  }
+  counted[slot].pid = 0;
+}
+
+//Prints a count, or "-" if it is not known
+static void printCount(int64_t v, int width) {
+  if(v < 0) {
+    fprintf(stderr, " %*s", width, "-");
+  }
+  else {
+    fprintf(stderr, " %*lld", width, (long long) v);
+  }
+}
+
+//Prints a line of the report
+static void printStage(StageStat *st) {
+  double wall = (st->end - st->start) / 1e9;
+  int64_t ctx = st->counts[EV_CONTEXT_SWITCHES] >= 0 ? st->counts[EV_CONTEXT_SWITCHES] : st->nvcsw + st->nivcsw;
+
+  fprintf(stderr, "%-16s %8.3f %8.3f %8.3f %5.0f%%", st->name, wall, st->user, st->sys, wall > 0 ? 100 * (st->user + st->sys) / wall : 0);
+  printCount(st->counts[EV_CYCLES], 14);
+  printCount(st->counts[EV_INSTRUCTIONS], 14);
+  if(st->counts[EV_CYCLES] > 0 && st->counts[EV_INSTRUCTIONS] >= 0) {
+    fprintf(stderr, " %5.2f", (double) st->counts[EV_INSTRUCTIONS] / st->counts[EV_CYCLES]);
+  }
+  else {
+    fprintf(stderr, " %5s", "-");
+  }
+  printCount(st->counts[EV_CACHE_MISSES], 12);
+  printCount(ctx, 8);
+  fprintf(stderr, " %10.1f %10.1f\n", st->rchar / 1048576.0, st->wchar / 1048576.0);
+}
+
+//Prints the numbers of every command of the run and their sum
+static void printReport(uint64_t start) {
+  int n = perf_run->n_stages < MAX_PERF_STAGES ? perf_run->n_stages : MAX_PERF_STAGES;
+  StageStat total;
+  int counters = 0;
+
+  memset(&total, 0, sizeof(total));
+  strcpy(total.name, "total");
+  total.start = start;
+  total.end = metricsNow();
+  fprintf(stderr, "%-16s %8s %8s %8s %6s %14s %14s %5s %12s %8s %10s %10s\n", "command", "wall s", "user s", "sys s", "cpu", "cycles", "instructions", "IPC", "cache-miss", "ctx-sw", "read MiB", "write MiB");
+  for(int i = 0; i < n; i++) {
+    StageStat *st = &(perf_run->stages[i]);
+    if(st->end == 0) {
+      continue; //still running in the background
+    }
+    printStage(st);
+    total.user += st->user;
+    total.sys += st->sys;
+    total.nvcsw += st->nvcsw;
+    total.nivcsw += st->nivcsw;
+    total.rchar += st->rchar;
+    total.wchar += st->wchar;
+    for(int e = 0; e < N_EVENTS; e++) {
+      if(st->counts[e] < 0 || total.counts[e] < 0) {
+        total.counts[e] = -1;
+      }
+      else {
+        total.counts[e] += st->counts[e];
+      }
+    }
+    counters |= st->counts[EV_CYCLES] >= 0;
+  }
+  printStage(&total);
+  if(n > 0 && !counters) {
+    fprintf(stderr, "perfstat: hardware counters not available%s\n", total.counts[EV_CONTEXT_SWITCHES] < 0 ? ", context switches are from rusage" : "");
+  }
+}
+
+//Processes the command if argv[0] is "perfstat"
+int processPerfStat(char *command_token[], int index, Command command[], int n_commands) {
+  if(strcmp(command[index].argv[0], "perfstat") != 0) {
+    return 0;
+  }
+  int n_rest = n_commands - index - 1; //commands after this one
+
+  if(command[index].argv[1] == NULL) {
+    printf("bash: perfstat: usage: perfstat command line\n");
+    return n_rest + 1;
+  }
+
+  //The first command of the command line is the part of this one after "perfstat"
+  Command run[n_rest + 1];
+  memcpy(run, command + index, sizeof(Command) * (n_rest + 1));
+  run[0].first = command[index].first + 1;
+  run[0].argv = NULL;
+  buildCommand(command_token, &(run[0]));
+
+  int owner = perf_run == NULL; //a nested perfstat reports to the outer one
+  if(owner) {
+    perf_run = (PerfRun *) mmap(NULL, sizeof(PerfRun), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(perf_run == MAP_FAILED) {
+      perror("mmap");
+      perf_run = NULL;
+    }
+  }
+
+  char *prompt = "%";
+  char new_prompt[STR_SIZE];
+  uint64_t start = metricsNow();
+  int status;
+  runCommands(command_token, run, n_rest + 1, &prompt, new_prompt);
+  status = lastStatus;
+
+  if(owner && perf_run != NULL) {
+    printReport(start);
+    munmap(perf_run, sizeof(PerfRun));
+    perf_run = NULL;
+  }
+  free(run[0].argv);
+  lastStatus = status;
+
+  return n_rest + 1;
+}
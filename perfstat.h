@@ -0,0 +1,48 @@
+/*
+ * File:	perfstat.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	The prefix "perfstat command line", which runs the command
+		line and then prints to stderr, for every command it
+		started and in total, the wall, user and system time, the
+		CPU cycles, instructions, instructions per cycle, cache
+		misses and context switches, and the bytes read and
+		written.
+
+   Return:	1) processPerfStat() returns the number of commands taken by
+		   the prefix, i.e. the one holding "perfstat" and the rest
+		   of the command line, or 0 if argv[0] is not "perfstat".
+		2) perfStatActive() returns 1 while perfstat runs, when
+		   commands must be started by forkCommand().
+
+   Note:	1) forkCommand() calls perfStatPrepare() and perfStatForked()
+		   around fork(). While perfstat runs, the parent opens the
+		   counters of the child with perf_event_open() before the
+		   child may exec, and the counters start at exec. They
+		   count the processes the child starts as well. A child
+		   that does not exec, e.g. a run of record stages, starts
+		   them with startStageCounters().
+		2) waitChild() calls perfStatExiting() before it claims the
+		   child, to read /proc/pid/io while the child is a zombie,
+		   and perfStatExited() with the rusage of wait4() after.
+		3) The numbers are kept in a region shared with the
+		   subshells of the command line, so that the commands of
+		   a pipeline run by a subshell are reported too.
+		4) Where perf events cannot be opened, e.g. for
+		   perf_event_paranoid or in a container, the counters are
+		   shown as "-" and the context switches are taken from
+		   the rusage.
+*/
+
+#define MAX_PERF_STAGES 128
+#define PERF_NAME_SIZE 32
+
+int processPerfStat(char *command_token[], int index, Command command[], int n_commands);
+void perfStatPrepare();
+int perfStatActive();
+void perfStatForked(pid_t pid, char *name);
+void startStageCounters();
+void perfStatExiting(pid_t pid);
+void perfStatExited(pid_t pid, struct rusage *ru);
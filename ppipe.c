@@ -0,0 +1,383 @@
+/*
+ * File:	ppipe.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include "job.h"
+#include "pathcache.h"
+#include "ppipe.h"
+
+#define OUT_BUF_SIZE (64 * 1024)
+
+struct WorkerStruct {
+  pid_t pid; //copy of the command running the block, -1 if the worker is free
+  long block; //number of the block
+  char *in; //the block, kept until the copy has ended since vmsplice() lends its pages
+  size_t in_size; //size of the buffer in
+  size_t in_len; //length of the block
+  size_t in_off; //bytes of the block given to the copy
+  int in_fd; //write end of the pipe to the copy, -1 once the block is given
+  int out_fd; //read end of the pipe from the copy, -1 at the end of its output
+  char *out; //output read before it is the turn of the block
+  size_t out_size; //size of the buffer out
+  size_t out_len; //bytes in out
+};
+
+typedef struct WorkerStruct Worker;
+
+//Returns the length of the block at the start of buf, or 0 if more input is
+//needed to find where it ends
+static size_t blockEnd(char *buf, size_t len, size_t block_size, int eof) {
+  char *nl = NULL;
+
+  if(len >= block_size) {
+    nl = memrchr(buf, '\n', block_size);
+    if(nl == NULL) {
+      nl = memchr(buf + block_size, '\n', len - block_size); //a line longer than a block
+    }
+  }
+  if(nl != NULL) {
+    return nl - buf + 1;
+  }
+
+  return eof ? len : 0;
+}
+
+//Makes a pipe whose ends are closed on exec
+static void makePipe(int fds[2], size_t size) {
+  if(pipe2(fds, O_CLOEXEC) < 0) {
+    perror("pipe2");
+    exit(1);
+  }
+  fcntl(fds[1], F_SETPIPE_SZ, (int) size); //the pipe stays smaller above /proc/sys/fs/pipe-max-size
+}
+
+//Starts a copy of the command for the block of the worker
+static void startCopy(Worker *w, char *argv[], size_t block_size) {
+  int in[2], out[2];
+
+  makePipe(in, block_size);
+  makePipe(out, block_size);
+  if((w->pid = fork()) < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if(w->pid == 0) {
+    dup2(in[0], STDIN_FILENO);
+    dup2(out[1], STDOUT_FILENO);
+    signal(SIGPIPE, SIG_DFL);
+    char *path = lookupPath(argv[0]);
+    if(path != NULL) {
+      execv(path, argv);
+    }
+    execvp(argv[0], argv);
+    perror("execvp");
+    exit(1);
+  }
+  close(in[0]);
+  close(out[1]);
+  w->in_fd = in[1];
+  w->out_fd = out[0];
+  w->in_off = 0;
+  w->out_len = 0;
+  fcntl(w->in_fd, F_SETFL, O_NONBLOCK);
+  fcntl(w->out_fd, F_SETFL, O_NONBLOCK);
+}
+
+//Gives the copy as much of its block as its pipe takes
+static void feedCopy(Worker *w) {
+  while(w->in_off < w->in_len) {
+    struct iovec iov = {w->in + w->in_off, w->in_len - w->in_off};
+    ssize_t n = vmsplice(w->in_fd, &iov, 1, SPLICE_F_NONBLOCK);
+    if(n < 0 && errno == EINVAL) {
+      n = write(w->in_fd, iov.iov_base, iov.iov_len);
+    }
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n < 0 && errno == EAGAIN) {
+      return;
+    }
+    if(n < 0) {
+      break; //the copy does not read the rest of its block
+    }
+    w->in_off += n;
+  }
+  close(w->in_fd);
+  w->in_fd = -1;
+}
+
+//Reads what the copy has written so far into the buffer of the worker
+static void readOutput(Worker *w) {
+  while(1) {
+    if(w->out_len == w->out_size) {
+      w->out_size = w->out_size == 0 ? OUT_BUF_SIZE : w->out_size * 2;
+      w->out = (char *) realloc(w->out, w->out_size);
+      if(w->out == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    ssize_t n = read(w->out_fd, w->out + w->out_len, w->out_size - w->out_len);
+    if(n > 0) {
+      w->out_len += n;
+    }
+    else if(n == 0 || (errno != EINTR && errno != EAGAIN)) {
+      close(w->out_fd);
+      w->out_fd = -1;
+      return;
+    }
+    else if(errno == EAGAIN) {
+      return;
+    }
+  }
+}
+
+//Writes len bytes of buf to fd
+//Returns -1 if fd cannot be written any more
+static int writeAll(int fd, char *buf, size_t len) {
+  while(len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n < 0) {
+      return -1;
+    }
+    buf += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+//Claims the copy of a worker whose output has been written, and frees the worker
+//Returns the exit status of the copy
+static int endCopy(Worker *w) {
+  int status;
+
+  if(w->in_fd >= 0) {
+    close(w->in_fd); //the copy ended without reading all of its block
+    w->in_fd = -1;
+  }
+  if(w->out_fd >= 0) {
+    close(w->out_fd);
+    w->out_fd = -1;
+  }
+  while(waitpid(w->pid, &status, 0) < 0) {
+    if(errno != EINTR) {
+      status = 0;
+      break;
+    }
+  }
+  w->pid = -1;
+  w->out_len = 0;
+
+  return exitStatus(status);
+}
+
+//Runs the stage ppipe with its standard input and output
+int runParallelPipe(char *argv[]) {
+  long n_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  long block_size = PPIPE_BLOCK_SIZE;
+  int i = 1;
+
+  while(argv[i] != NULL && strcmp(argv[i], "--") != 0) {
+    if(strcmp(argv[i], "-j") == 0 && argv[i + 1] != NULL) {
+      n_workers = atol(argv[i + 1]);
+    }
+    else if(strcmp(argv[i], "-b") == 0 && argv[i + 1] != NULL) {
+      block_size = atol(argv[i + 1]);
+    }
+    else {
+      break;
+    }
+    i = i + 2;
+  }
+  if(argv[i] == NULL || strcmp(argv[i], "--") != 0 || argv[i + 1] == NULL || n_workers < 1 || n_workers > PPIPE_MAX_WORKERS || block_size < 1) {
+    fprintf(stderr, "bash: ppipe: usage: ppipe [-j workers] [-b bytes] -- command args\n");
+    return 1;
+  }
+  char **copy_argv = argv + i + 1;
+
+  Worker workers[n_workers];
+  memset(workers, 0, sizeof(workers));
+  for(i = 0; i < n_workers; i++) {
+    workers[i].pid = -1;
+    workers[i].in_fd = -1;
+    workers[i].out_fd = -1;
+  }
+
+  size_t pend_size = block_size; //input read but not yet given to a worker
+  size_t pend_len = 0;
+  char *pend = (char *) malloc(pend_size);
+  if(pend == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+
+  long next = 0; //block to be given to a worker next
+  long head = 0; //block whose output is being written
+  int eof = 0;
+  int use_splice = 1; //0 once the standard output turns out not to take splice()
+  int wait_out = 0; //1 while the standard output is full
+  int broken = 0; //1 once the standard output cannot be written
+  int status = 0;
+  size_t cut;
+
+  signal(SIGPIPE, SIG_IGN); //a copy or the next stage may stop reading early
+  while(!broken && (!eof || pend_len > 0 || head < next)) {
+    //Give out the blocks round-robin, each once its worker is free
+    while((cut = blockEnd(pend, pend_len, block_size, eof)) > 0 && workers[next % n_workers].pid == -1) {
+      Worker *w = &(workers[next % n_workers]);
+      char *buf = w->in;
+      size_t size = w->in_size;
+      size_t rest = pend_len - cut;
+
+      w->in = pend;
+      w->in_size = pend_size;
+      w->in_len = cut;
+      w->block = next++;
+      if(size < rest || size < (size_t) block_size) {
+        size = rest > (size_t) block_size ? rest : (size_t) block_size;
+        buf = (char *) realloc(buf, size);
+        if(buf == NULL) {
+          perror("realloc");
+          exit(1);
+        }
+      }
+      memcpy(buf, pend + cut, rest); //the start of the next block
+      pend = buf;
+      pend_size = size;
+      pend_len = rest;
+      startCopy(w, copy_argv, block_size);
+    }
+
+    struct pollfd fds[2 * n_workers + 2];
+    int feed_at[n_workers], drain_at[n_workers];
+    int n_fds = 0, in_at = -1, out_at = -1;
+    if(!eof && blockEnd(pend, pend_len, block_size, 0) == 0) {
+      fds[n_fds] = (struct pollfd) {STDIN_FILENO, POLLIN, 0};
+      in_at = n_fds++;
+    }
+    if(wait_out) {
+      fds[n_fds] = (struct pollfd) {STDOUT_FILENO, POLLOUT, 0};
+      out_at = n_fds++;
+    }
+    for(i = 0; i < n_workers; i++) {
+      feed_at[i] = drain_at[i] = -1;
+      if(workers[i].in_fd >= 0) {
+        fds[n_fds] = (struct pollfd) {workers[i].in_fd, POLLOUT, 0};
+        feed_at[i] = n_fds++;
+      }
+      if(workers[i].out_fd >= 0 && !(wait_out && workers[i].block == head)) {
+        fds[n_fds] = (struct pollfd) {workers[i].out_fd, POLLIN, 0};
+        drain_at[i] = n_fds++;
+      }
+    }
+    if(poll(fds, n_fds, -1) < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      exit(1);
+    }
+
+    //Read the input up to the end of the next block
+    if(in_at >= 0 && fds[in_at].revents) {
+      if(pend_len == pend_size) {
+        pend_size *= 2;
+        pend = (char *) realloc(pend, pend_size);
+        if(pend == NULL) {
+          perror("realloc");
+          exit(1);
+        }
+      }
+      size_t want = pend_len < (size_t) block_size ? block_size - pend_len : pend_size - pend_len;
+      ssize_t n = read(STDIN_FILENO, pend + pend_len, want);
+      if(n > 0) {
+        pend_len += n;
+      }
+      else if(n == 0 || (errno != EINTR && errno != EAGAIN)) {
+        eof = 1;
+      }
+    }
+    if(out_at >= 0 && fds[out_at].revents) {
+      wait_out = 0;
+    }
+
+    for(i = 0; i < n_workers; i++) {
+      Worker *w = &(workers[i]);
+      if(feed_at[i] >= 0 && fds[feed_at[i]].revents) {
+        feedCopy(w);
+      }
+      if(drain_at[i] < 0 || !fds[drain_at[i]].revents) {
+        continue;
+      }
+      if(w->block != head || !use_splice) {
+        readOutput(w);
+        continue;
+      }
+
+      //The output of the block being written goes on without a copy
+      ssize_t n = splice(w->out_fd, NULL, STDOUT_FILENO, NULL, block_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if(n == 0) {
+        close(w->out_fd);
+        w->out_fd = -1;
+      }
+      else if(n < 0 && errno == EAGAIN) {
+        wait_out = 1; //the copy has written something, so the standard output is full
+      }
+      else if(n < 0 && errno == EPIPE) {
+        broken = 1;
+      }
+      else if(n < 0 && errno != EINTR) {
+        use_splice = 0; //e.g. a terminal
+        readOutput(w);
+      }
+    }
+
+    //Write the outputs in the order of the blocks
+    while(!broken && head < next) {
+      Worker *w = &(workers[head % n_workers]);
+      if(writeAll(STDOUT_FILENO, w->out, w->out_len) < 0) {
+        broken = 1;
+        break;
+      }
+      w->out_len = 0;
+      if(w->out_fd >= 0) {
+        break; //the copy is still writing
+      }
+      int copy_status = endCopy(w);
+      if(status == 0) {
+        status = copy_status;
+      }
+      head++;
+    }
+  }
+
+  //The next stage has stopped reading, so the copies are not needed any more
+  for(i = 0; i < n_workers; i++) {
+    if(workers[i].pid > 0) {
+      endCopy(&(workers[i]));
+    }
+    free(workers[i].in);
+    free(workers[i].out);
+  }
+  free(pend);
+
+  return broken ? 128 + SIGPIPE : status;
+}
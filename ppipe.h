@@ -0,0 +1,33 @@
+/*
+ * File:	ppipe.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	The stage "ppipe [-j workers] [-b bytes] -- command args",
+		which splits its standard input into blocks of whole lines,
+		runs the command on the blocks in up to "workers" copies at
+		once, and writes their outputs in the order of the blocks.
+
+   Return:	0 if every copy of the command succeeded, otherwise the
+		status of the first one that did not, or 1 on a usage error.
+
+   Note:	1) runParallelPipe() is run by the child forked for the
+		   stage, in place of exec().
+		2) A block is about "bytes" long, PPIPE_BLOCK_SIZE by
+		   default, and ends after a newline unless it holds the
+		   end of the input. A line longer than a block is not
+		   split. Block k goes to worker k % workers, which runs
+		   one copy of the command per block, so the output of a
+		   block is known to end when its copy exits.
+		3) The blocks are given to the copies with vmsplice(), and
+		   the output of the block being written is moved to the
+		   standard output with splice() when it is a pipe or a
+		   file. The outputs of later blocks are read into memory
+		   meanwhile, so that no copy waits for the ones before it.
+*/
+
+#define PPIPE_BLOCK_SIZE (4 * 1024 * 1024)
+#define PPIPE_MAX_WORKERS 256
+
+int runParallelPipe(char *argv[]);
@@ -0,0 +1,370 @@
+/*
+ * File:	prefetch.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "prefetch.h"
+
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_WHO_PROCESS 1
+
+#define PREFETCH_FILE 0 //a file read as it is
+#define PREFETCH_COMMAND 1 //a command name, found through PATH
+
+//The usual library directories, looked in after DT_RUNPATH and LD_LIBRARY_PATH
+static char *lib_dirs[] = {"/lib/x86_64-linux-gnu", "/usr/lib/x86_64-linux-gnu", "/lib/aarch64-linux-gnu", "/usr/lib/aarch64-linux-gnu", "/lib64", "/usr/lib64", "/lib", "/usr/lib", "/usr/local/lib", NULL};
+
+//The work for one command line
+struct PrefetchWorkStruct {
+  char *names[PREFETCH_MAX_FILES];
+  int kinds[PREFETCH_MAX_FILES];
+  int n_names;
+  char *path_env; //PATH of the shell
+  char *lib_path_env; //LD_LIBRARY_PATH of the shell, or NULL
+};
+
+typedef struct PrefetchWorkStruct PrefetchWork;
+
+//What the thread has done for the current command line
+struct PrefetchStateStruct {
+  char *seen[PREFETCH_MAX_FILES];
+  int n_seen;
+  size_t budget; //bytes left to read
+  unsigned generation;
+};
+
+typedef struct PrefetchStateStruct PrefetchState;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t more = PTHREAD_COND_INITIALIZER;
+static PrefetchWork pending; //handed to the thread under lock
+static unsigned generation = 0; //counts the command lines, a newer one stops the work on an older one
+static int started = 0;
+static pid_t owner_pid = 0; //the shell, 0 if prefetching is off
+
+static void prefetchFile(PrefetchWork *work, PrefetchState *state, char *path, int depth);
+
+//Frees the strings of a piece of work
+static void freeWork(PrefetchWork *work) {
+  for(int i = 0; i < work->n_names; i++) {
+    free(work->names[i]);
+  }
+  free(work->path_env);
+  free(work->lib_path_env);
+  memset(work, 0, sizeof(PrefetchWork));
+}
+
+//Returns 1 if the thread is to stop the work on this command line
+static int superseded(PrefetchState *state) {
+  return __atomic_load_n(&generation, __ATOMIC_RELAXED) != state->generation;
+}
+
+//Stores the full path name of a command found through PATH in path, returns 0 or -1
+static int findCommand(char *path_env, char *name, char path[]) {
+  struct stat buf;
+  char *dir = path_env;
+
+  if(strchr(name, '/') != NULL) {
+    snprintf(path, PATH_MAX, "%s", name);
+    return 0;
+  }
+  while(dir != NULL && *dir != '\0') {
+    size_t len = strcspn(dir, ":");
+    if(len == 0) {
+      snprintf(path, PATH_MAX, "%s", name);
+    }
+    else {
+      snprintf(path, PATH_MAX, "%.*s/%s", (int) len, dir, name);
+    }
+    if(stat(path, &buf) == 0 && S_ISREG(buf.st_mode) && (buf.st_mode & 0111)) {
+      return 0;
+    }
+    dir += len;
+    if(*dir == ':') {
+      dir++;
+    }
+  }
+
+  return -1;
+}
+
+//Returns 1 if a library is found in one of the directories of a ':' list, with $ORIGIN replaced by origin
+static int findInDirs(char *dirs, char *origin, char *name, char path[]) {
+  char dir_name[PATH_MAX];
+
+  while(dirs != NULL && *dirs != '\0') {
+    size_t len = strcspn(dirs, ":");
+    if(len > 0 && len < sizeof(dir_name)) {
+      memcpy(dir_name, dirs, len);
+      dir_name[len] = '\0';
+      if(strncmp(dir_name, "$ORIGIN", 7) == 0) {
+        snprintf(path, PATH_MAX, "%s%s/%s", origin, dir_name + 7, name);
+      }
+      else {
+        snprintf(path, PATH_MAX, "%s/%s", dir_name, name);
+      }
+      if(access(path, R_OK) == 0) {
+        return 1;
+      }
+    }
+    dirs += len;
+    if(*dirs == ':') {
+      dirs++;
+    }
+  }
+
+  return 0;
+}
+
+//Stores the path name of a DT_NEEDED library in path, returns 0 or -1
+static int findLibrary(PrefetchWork *work, char *name, char *run_path, char *origin, char path[]) {
+  if(strchr(name, '/') != NULL) {
+    snprintf(path, PATH_MAX, "%s", name);
+    return 0;
+  }
+  if(findInDirs(run_path, origin, name, path) || findInDirs(work->lib_path_env, origin, name, path)) {
+    return 0;
+  }
+  for(int i = 0; lib_dirs[i] != NULL; i++) {
+    snprintf(path, PATH_MAX, "%s/%s", lib_dirs[i], name);
+    if(access(path, R_OK) == 0) {
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+//Returns the offset in the file of a virtual address of an ELF file, or -1
+static off_t fileOffset(Elf64_Phdr phdr[], int n_phdr, uint64_t addr) {
+  for(int i = 0; i < n_phdr; i++) {
+    if(phdr[i].p_type == PT_LOAD && addr >= phdr[i].p_vaddr && addr < phdr[i].p_vaddr + phdr[i].p_filesz) {
+      return addr - phdr[i].p_vaddr + phdr[i].p_offset;
+    }
+  }
+
+  return -1;
+}
+
+//Prefetches the interpreter and the libraries of an ELF file
+static void followElf(PrefetchWork *work, PrefetchState *state, int fd, char *path, int depth) {
+  Elf64_Ehdr ehdr;
+  char interp[PATH_MAX];
+  char lib[PATH_MAX];
+
+  if(pread(fd, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0
+     || ehdr.e_ident[EI_CLASS] != ELFCLASS64 || ehdr.e_phentsize != sizeof(Elf64_Phdr) || ehdr.e_phnum == 0 || ehdr.e_phnum > 64) {
+    return;
+  }
+  Elf64_Phdr phdr[ehdr.e_phnum];
+  if(pread(fd, phdr, sizeof(phdr), ehdr.e_phoff) != (ssize_t) sizeof(phdr)) {
+    return;
+  }
+
+  Elf64_Dyn *dyn = NULL;
+  int n_dyn = 0;
+  for(int i = 0; i < ehdr.e_phnum; i++) {
+    if(phdr[i].p_type == PT_INTERP && phdr[i].p_filesz < sizeof(interp)) {
+      ssize_t n = pread(fd, interp, phdr[i].p_filesz, phdr[i].p_offset);
+      if(n > 0) {
+        interp[n - 1] = '\0';
+        prefetchFile(work, state, interp, depth + 1);
+      }
+    }
+    else if(phdr[i].p_type == PT_DYNAMIC && dyn == NULL && phdr[i].p_filesz < 64 * 1024) {
+      dyn = (Elf64_Dyn *) malloc(phdr[i].p_filesz);
+      if(dyn != NULL && pread(fd, dyn, phdr[i].p_filesz, phdr[i].p_offset) == (ssize_t) phdr[i].p_filesz) {
+        n_dyn = phdr[i].p_filesz / sizeof(Elf64_Dyn);
+      }
+    }
+  }
+
+  //Read the string table that DT_NEEDED and DT_RUNPATH point into
+  uint64_t strtab = 0, strsz = 0;
+  for(int i = 0; i < n_dyn && dyn[i].d_tag != DT_NULL; i++) {
+    if(dyn[i].d_tag == DT_STRTAB) {
+      strtab = dyn[i].d_un.d_ptr;
+    }
+    else if(dyn[i].d_tag == DT_STRSZ) {
+      strsz = dyn[i].d_un.d_val;
+    }
+  }
+  off_t str_offset = fileOffset(phdr, ehdr.e_phnum, strtab);
+  char *strings = NULL;
+  if(n_dyn > 0 && str_offset >= 0 && strsz > 0 && strsz < 1024 * 1024 && (strings = (char *) malloc(strsz + 1)) != NULL
+     && pread(fd, strings, strsz, str_offset) == (ssize_t) strsz) {
+    strings[strsz] = '\0';
+    char *run_path = NULL;
+    for(int i = 0; i < n_dyn && dyn[i].d_tag != DT_NULL; i++) {
+      if((dyn[i].d_tag == DT_RUNPATH || dyn[i].d_tag == DT_RPATH) && dyn[i].d_un.d_val < strsz) {
+        run_path = strings + dyn[i].d_un.d_val;
+      }
+    }
+    char origin[PATH_MAX];
+    snprintf(origin, sizeof(origin), "%s", path);
+    *(strrchr(origin, '/') != NULL ? strrchr(origin, '/') : origin) = '\0';
+    for(int i = 0; i < n_dyn && dyn[i].d_tag != DT_NULL && !superseded(state); i++) {
+      if(dyn[i].d_tag == DT_NEEDED && dyn[i].d_un.d_val < strsz
+         && findLibrary(work, strings + dyn[i].d_un.d_val, run_path, origin, lib) == 0) {
+        prefetchFile(work, state, lib, depth + 1);
+      }
+    }
+  }
+  free(strings);
+  free(dyn);
+}
+
+//Reads a file into the page cache, then what it needs to run
+static void prefetchFile(PrefetchWork *work, PrefetchState *state, char *path, int depth) {
+  struct stat buf;
+  char line[PATH_MAX];
+
+  if(depth > PREFETCH_MAX_DEPTH || state->n_seen >= PREFETCH_MAX_FILES || state->budget == 0 || superseded(state)) {
+    return;
+  }
+  for(int i = 0; i < state->n_seen; i++) {
+    if(strcmp(state->seen[i], path) == 0) {
+      return;
+    }
+  }
+  state->seen[state->n_seen++] = strdup(path);
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    return;
+  }
+  if(fstat(fd, &buf) == 0 && S_ISREG(buf.st_mode)) {
+    size_t size = (size_t) buf.st_size < state->budget ? (size_t) buf.st_size : state->budget;
+    if(readahead(fd, 0, size) != 0) {
+      posix_fadvise(fd, 0, size, POSIX_FADV_WILLNEED);
+    }
+    state->budget -= size;
+
+    //A script runs its "#!" interpreter, a program its ELF interpreter and libraries
+    ssize_t n = pread(fd, line, sizeof(line) - 1, 0);
+    if(n > 2 && line[0] == '#' && line[1] == '!') {
+      line[n] = '\0';
+      char *interp = line + 2 + strspn(line + 2, " \t");
+      interp[strcspn(interp, " \t\n")] = '\0';
+      if(interp[0] == '/') {
+        prefetchFile(work, state, interp, depth + 1);
+      }
+    }
+    else if(n >= SELFMAG && memcmp(line, ELFMAG, SELFMAG) == 0) {
+      followElf(work, state, fd, path, depth);
+    }
+  }
+  close(fd);
+}
+
+//Waits for command lines and prefetches their files
+static void *prefetchThread(void *arg) {
+  PrefetchWork work;
+  PrefetchState state;
+  char path[PATH_MAX];
+
+  //Read only when nothing else wants the CPU or the disk
+  setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+  syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, (int) syscall(SYS_gettid), IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+
+  while(1) {
+    pthread_mutex_lock(&lock);
+    while(pending.n_names == 0) {
+      pthread_cond_wait(&more, &lock);
+    }
+    work = pending;
+    memset(&pending, 0, sizeof(PrefetchWork));
+    state.generation = generation;
+    pthread_mutex_unlock(&lock);
+
+    state.n_seen = 0;
+    state.budget = PREFETCH_BUDGET;
+    for(int i = 0; i < work.n_names && !superseded(&state); i++) {
+      if(work.kinds[i] == PREFETCH_FILE) {
+        prefetchFile(&work, &state, work.names[i], 0);
+      }
+      else if(findCommand(work.path_env, work.names[i], path) == 0) {
+        prefetchFile(&work, &state, path, 0);
+      }
+    }
+    for(int i = 0; i < state.n_seen; i++) {
+      free(state.seen[i]);
+    }
+    freeWork(&work);
+  }
+
+  return NULL;
+}
+
+//Turns prefetching on for this process
+void startPrefetch() {
+  owner_pid = getpid();
+}
+
+//Hands the commands after the first one of a command line to the thread
+void prefetchCommands(Command command[], int n_commands) {
+  PrefetchWork work;
+  pthread_t thread;
+  sigset_t all, old;
+
+  if(n_commands < 2 || getpid() != owner_pid) {
+    return;
+  }
+  memset(&work, 0, sizeof(PrefetchWork));
+  for(int i = 1; i < n_commands && work.n_names < PREFETCH_MAX_FILES - 1; i++) {
+    char *name = command[i].argv != NULL ? command[i].argv[0] : NULL;
+    //Words still to be expanded are left alone
+    if(name != NULL && strpbrk(name, "$`*?") == NULL && !builtInCommand(i, command)) {
+      work.kinds[work.n_names] = PREFETCH_COMMAND;
+      work.names[work.n_names++] = strdup(name);
+    }
+    if(command[i].stdin_file != NULL && command[i].stdin_doc == NULL && command[i].stdin_op != NULL
+       && strcmp(command[i].stdin_op, inFile) == 0 && strpbrk(command[i].stdin_file, "$`*?") == NULL) {
+      work.kinds[work.n_names] = PREFETCH_FILE;
+      work.names[work.n_names++] = strdup(command[i].stdin_file);
+    }
+  }
+  if(work.n_names == 0) {
+    return;
+  }
+  work.path_env = strdup(getenv("PATH") != NULL ? getenv("PATH") : "");
+  work.lib_path_env = getenv("LD_LIBRARY_PATH") != NULL ? strdup(getenv("LD_LIBRARY_PATH")) : NULL;
+
+  pthread_mutex_lock(&lock);
+  freeWork(&pending); //left from an earlier command line
+  pending = work;
+  __atomic_add_fetch(&generation, 1, __ATOMIC_RELAXED);
+  pthread_cond_signal(&more);
+  pthread_mutex_unlock(&lock);
+
+  if(!started) {
+    started = 1;
+    //The thread must not take the signals of the shell, e.g. SIGCHLD
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    if(pthread_create(&thread, NULL, prefetchThread, NULL) == 0) {
+      pthread_detach(thread);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+  }
+}
@@ -0,0 +1,42 @@
+/*
+ * File:	prefetch.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	While the first command of a command line like "a ; b ; c"
+		runs, read the programs of the later commands, their ELF
+		interpreter and shared libraries, and the files their
+		standard input is redirected from into the page cache, so
+		that they do not wait for the disk when their turn comes.
+
+   Return:	None.
+
+   Note:	1) The reading is done by one background thread, started on
+		   the first command line with more than one command, at
+		   the lowest CPU priority and in the idle I/O class, with
+		   every signal blocked.
+		2) prefetchCommands() only copies the names and hands them
+		   to the thread. A new command line replaces the work left
+		   from the one before, and the thread reads at most
+		   PREFETCH_BUDGET bytes for one command line.
+		3) Commands are found through PATH like execvp() does. A
+		   script is followed to the interpreter of its "#!" line.
+		   For an ELF program, the PT_INTERP interpreter and the
+		   DT_NEEDED libraries are looked up in DT_RPATH or
+		   DT_RUNPATH, LD_LIBRARY_PATH and the usual library
+		   directories, and followed in turn, but /etc/ld.so.cache
+		   is not read.
+		4) Files are read with readahead(), or posix_fadvise() with
+		   POSIX_FADV_WILLNEED where readahead() is not supported.
+		5) Only the shell process itself prefetches, not its
+		   subshells, which must not touch the lock of a thread
+		   they do not have.
+*/
+
+#define PREFETCH_BUDGET (256 * 1024 * 1024) //bytes read for one command line
+#define PREFETCH_MAX_FILES 256 //files looked at for one command line
+#define PREFETCH_MAX_DEPTH 8 //levels of libraries followed
+
+void startPrefetch();
+void prefetchCommands(Command command[], int n_commands);
@@ -0,0 +1,1134 @@
+/*
+ * File:	records.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "job.h"
+#include "metrics.h"
+#include "perfstat.h"
+#include "records.h"
+
+#define HASH_SIZE (2 * RECORD_BATCH_ROWS) //slots of the dictionary hash table of a column
+#define INT_STR_SIZE 24
+
+//Kinds of stages
+#define STAGE_FROM_CSV 0
+#define STAGE_WHERE 1
+#define STAGE_SELECT 2
+#define STAGE_SORT_BY 3
+#define STAGE_TO_CSV 4
+
+//Types of columns
+#define COL_INT 0
+#define COL_STR 1
+
+//Operators of where
+#define OP_EQ 0
+#define OP_NE 1
+#define OP_LT 2
+#define OP_LE 3
+#define OP_GT 4
+#define OP_GE 5
+
+static char *stage_names[] = {"from-csv", "where", "select", "sort-by", "to-csv", NULL};
+
+struct ArenaBlockStruct {
+  struct ArenaBlockStruct *next;
+  size_t size; //bytes in data
+  size_t used; //bytes of data given out
+  char data[];
+};
+
+typedef struct ArenaBlockStruct ArenaBlock;
+
+struct SchemaStruct {
+  int n_cols;
+  char **names; //names of the columns
+};
+
+typedef struct SchemaStruct Schema;
+
+struct ColumnStruct {
+  int type; //COL_INT or COL_STR
+  int64_t *ints; //values of a COL_INT column
+  uint32_t *codes; //values of a COL_STR column, indices into strs
+  char **strs; //dictionary of a COL_STR column, strings ending with '\0'
+  uint32_t *lens; //lengths of the strings of the dictionary
+  int n_strs; //entries in the dictionary
+};
+
+typedef struct ColumnStruct Column;
+
+struct BatchStruct {
+  Schema *schema;
+  Column *cols; //schema->n_cols columns
+  int n_rows; //number of records, or of selected records if rows is not NULL
+  uint32_t *rows; //records selected by where, or NULL for every record
+  ArenaBlock *arena; //memory of the columns, freed with the batch
+};
+
+typedef struct BatchStruct Batch;
+
+struct StageStruct {
+  int kind;
+  char **argv;
+  int argc;
+  Schema *schema; //schema of the batches coming in, NULL before the first
+  int col; //column of where and sort-by
+  int op; //operator of where
+  char *value; //value of where
+  int value_is_int; //1 if value is an integer, kept in value_int
+  int64_t value_int;
+  int value_is_num; //1 if value is a number, kept in value_num
+  double value_num;
+  int *map; //columns picked by select
+  Schema *out_schema; //schema of the batches going out of select
+  int reverse; //1 for sort-by -r
+  Batch **held; //batches held by sort-by
+  int n_held;
+  int held_size;
+  int header_done; //1 once to-csv has written the header
+};
+
+typedef struct StageStruct Stage;
+
+struct FieldStruct {
+  char *s;
+  uint32_t len;
+};
+
+typedef struct FieldStruct Field;
+
+struct BuilderStruct {
+  int all_int; //1 while every value of the column in the batch is an integer
+  uint32_t table[HASH_SIZE]; //codes + 1 of the dictionary, 0 for a free slot
+};
+
+typedef struct BuilderStruct Builder;
+
+struct SortKeyStruct {
+  Batch *batch;
+  uint32_t row;
+  uint32_t seq; //position in the input, keeps equal keys in order
+  int kind; //0 for an integer, 1 for another number, 2 for a string
+  int64_t i;
+  double d;
+  char *s;
+  uint32_t len;
+};
+
+typedef struct SortKeyStruct SortKey;
+
+static char out_buf[RECORD_IO_SIZE]; //CSV written by to-csv
+static size_t out_len = 0;
+static int sort_reverse = 0; //order of compareKeys()
+
+//Returns memory from the arena of the batch
+static void *batchAlloc(Batch *b, size_t size) {
+  size = (size + 7) & ~((size_t) 7);
+  if(b->arena == NULL || b->arena->used + size > b->arena->size) {
+    size_t block_size = size > RECORD_ARENA_BLOCK ? size : RECORD_ARENA_BLOCK;
+    ArenaBlock *a = (ArenaBlock *) malloc(sizeof(ArenaBlock) + block_size);
+    if(a == NULL) {
+      perror("malloc");
+      exit(1);
+    }
+    a->next = b->arena;
+    a->size = block_size;
+    a->used = 0;
+    b->arena = a;
+  }
+  void *p = b->arena->data + b->arena->used;
+  b->arena->used += size;
+
+  return p;
+}
+
+//Returns an empty batch with the columns of schema
+static Batch *newBatch(Schema *schema) {
+  Batch *b = (Batch *) calloc(1, sizeof(Batch));
+
+  if(b == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  b->schema = schema;
+  b->cols = (Column *) batchAlloc(b, sizeof(Column) * schema->n_cols);
+  memset(b->cols, 0, sizeof(Column) * schema->n_cols);
+
+  return b;
+}
+
+static void freeBatch(Batch *b) {
+  while(b->arena != NULL) {
+    ArenaBlock *next = b->arena->next;
+    free(b->arena);
+    b->arena = next;
+  }
+  free(b);
+}
+
+//Returns 1 if name is a record stage
+int isRecordStage(char *name) {
+  for(int i = 0; stage_names[i] != NULL; i++) {
+    if(strcmp(name, stage_names[i]) == 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Parses s as an integer written the way intToStr() writes it, so that the
+//text can be given back exactly
+//Returns 1 if it is one
+static int parseInt(char *s, uint32_t len, int64_t *v) {
+  int neg = len > 0 && s[0] == '-';
+  int64_t x = 0;
+
+  if(len - neg == 0 || len - neg > 18 || (s[neg] == '0' && len - neg > 1) || (neg && s[1] == '0')) {
+    return 0;
+  }
+  for(uint32_t i = neg; i < len; i++) {
+    if(s[i] < '0' || s[i] > '9') {
+      return 0;
+    }
+    x = x * 10 + (s[i] - '0');
+  }
+  *v = neg ? -x : x;
+
+  return 1;
+}
+
+//Parses the string s, which ends with '\0', as a number
+//Returns 1 if it is one
+static int parseNumber(char *s, double *d) {
+  char *end;
+
+  if(*s == '\0') {
+    return 0;
+  }
+  errno = 0;
+  *d = strtod(s, &end);
+
+  return *end == '\0' && errno == 0;
+}
+
+//Writes v into buf, which holds at least INT_STR_SIZE bytes
+//Returns the length of the text
+static int intToStr(int64_t v, char *buf) {
+  char tmp[INT_STR_SIZE];
+  uint64_t u = v < 0 ? -(uint64_t) v : (uint64_t) v;
+  int n = 0, len = 0;
+
+  do {
+    tmp[n++] = '0' + u % 10;
+    u /= 10;
+  } while(u > 0);
+  if(v < 0) {
+    buf[len++] = '-';
+  }
+  while(n > 0) {
+    buf[len++] = tmp[--n];
+  }
+  buf[len] = '\0';
+
+  return len;
+}
+
+static uint32_t hashString(char *s, uint32_t len) {
+  uint32_t h = 2166136261u;
+
+  for(uint32_t i = 0; i < len; i++) {
+    h = (h ^ (unsigned char) s[i]) * 16777619u;
+  }
+
+  return h;
+}
+
+//Returns the code of s in the dictionary of the column, adding it if it is new
+static uint32_t internString(Batch *b, Column *c, Builder *bld, char *s, uint32_t len) {
+  uint32_t h = hashString(s, len) & (HASH_SIZE - 1);
+
+  while(bld->table[h] != 0) {
+    uint32_t code = bld->table[h] - 1;
+    if(c->lens[code] == len && memcmp(c->strs[code], s, len) == 0) {
+      return code;
+    }
+    h = (h + 1) & (HASH_SIZE - 1);
+  }
+  char *copy = (char *) batchAlloc(b, len + 1);
+  memcpy(copy, s, len);
+  copy[len] = '\0';
+  uint32_t code = c->n_strs++;
+  c->strs[code] = copy;
+  c->lens[code] = len;
+  bld->table[h] = code + 1;
+
+  return code;
+}
+
+//Turns the integers of the first n records of a column being built into strings
+static void columnToStrings(Batch *b, Column *c, Builder *bld, int n) {
+  char buf[INT_STR_SIZE];
+
+  bld->all_int = 0;
+  memset(bld->table, 0, sizeof(bld->table));
+  c->type = COL_STR;
+  c->codes = (uint32_t *) batchAlloc(b, sizeof(uint32_t) * RECORD_BATCH_ROWS);
+  c->strs = (char **) batchAlloc(b, sizeof(char *) * RECORD_BATCH_ROWS);
+  c->lens = (uint32_t *) batchAlloc(b, sizeof(uint32_t) * RECORD_BATCH_ROWS);
+  c->n_strs = 0;
+  for(int i = 0; i < n; i++) {
+    int len = intToStr(c->ints[i], buf);
+    c->codes[i] = internString(b, c, bld, buf, len);
+  }
+  c->ints = NULL;
+}
+
+//Returns a new batch for from-csv, with every column taken to be of integers
+static Batch *startBatch(Schema *schema, Builder bld[]) {
+  Batch *b = newBatch(schema);
+
+  for(int i = 0; i < schema->n_cols; i++) {
+    b->cols[i].type = COL_INT;
+    b->cols[i].ints = (int64_t *) batchAlloc(b, sizeof(int64_t) * RECORD_BATCH_ROWS);
+    bld[i].all_int = 1;
+  }
+
+  return b;
+}
+
+//Adds a record to the batch being built by from-csv
+static void addRecord(Batch *b, Builder bld[], Field fields[], int n_fields) {
+  int row = b->n_rows++;
+
+  for(int i = 0; i < b->schema->n_cols; i++) {
+    Column *c = &(b->cols[i]);
+    char *s = i < n_fields ? fields[i].s : "";
+    uint32_t len = i < n_fields ? fields[i].len : 0;
+    if(bld[i].all_int && parseInt(s, len, &(c->ints[row]))) {
+      continue;
+    }
+    if(bld[i].all_int) {
+      columnToStrings(b, c, &(bld[i]), row);
+    }
+    c->codes[row] = internString(b, c, &(bld[i]), s, len);
+  }
+}
+
+//Finds the end of the CSV record at p, which may hold quoted newlines
+//Returns the end, i.e. the newline or end, or NULL if the record is not complete
+static char *recordEnd(char *p, char *end, int eof) {
+  char *nl = (char *) memchr(p, '\n', end - p);
+
+  if(nl != NULL && memchr(p, '"', nl - p) == NULL) {
+    return nl;
+  }
+  int quoted = 0;
+  for(char *q = p; q < end; q++) {
+    if(*q == '"') {
+      quoted = !quoted; //"" inside quotes toggles twice
+    }
+    else if(*q == '\n' && !quoted) {
+      return q;
+    }
+  }
+
+  return eof ? end : NULL;
+}
+
+//Splits the CSV record p..end into fields, undoing the quoting in place
+//Returns the number of fields
+static int splitRecord(char *p, char *end, Field fields[]) {
+  int n = 0;
+
+  if(end > p && end[-1] == '\r') {
+    end--;
+  }
+  while(n < MAX_RECORD_COLUMNS) {
+    if(p < end && *p == '"') {
+      char *w = ++p;
+      fields[n].s = w;
+      while(p < end) {
+        if(*p == '"' && p + 1 < end && p[1] == '"') {
+          *w++ = '"';
+          p += 2;
+        }
+        else if(*p == '"') {
+          p++;
+          break;
+        }
+        else {
+          *w++ = *p++;
+        }
+      }
+      fields[n].len = w - fields[n].s;
+      char *comma = (char *) memchr(p, ',', end - p);
+      p = comma == NULL ? end : comma;
+    }
+    else {
+      char *comma = (char *) memchr(p, ',', end - p);
+      fields[n].s = p;
+      fields[n].len = (comma == NULL ? end : comma) - p;
+      p = comma == NULL ? end : comma;
+    }
+    n++;
+    if(p == end) {
+      break;
+    }
+    p++; //the comma
+  }
+
+  return n;
+}
+
+//Writes len bytes of buf to stdout
+static void writeOut(char *buf, size_t len) {
+  while(len > 0) {
+    ssize_t n = write(STDOUT_FILENO, buf, len);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n < 0) {
+      exit(1); //the next command has gone
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+//Writes the CSV buffered by to-csv
+static void flushOut() {
+  writeOut(out_buf, out_len);
+  out_len = 0;
+}
+
+static void putOut(char *s, size_t len) {
+  if(out_len + len > sizeof(out_buf)) {
+    flushOut();
+  }
+  if(len > sizeof(out_buf)) {
+    writeOut(s, len);
+    return;
+  }
+  memcpy(out_buf + out_len, s, len);
+  out_len += len;
+}
+
+//Writes a CSV field, quoting it if needed
+static void putField(char *s, uint32_t len) {
+  int quote = 0;
+
+  for(uint32_t i = 0; i < len && !quote; i++) {
+    quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+  }
+  if(!quote) {
+    putOut(s, len);
+    return;
+  }
+  putOut("\"", 1);
+  for(uint32_t i = 0; i < len; i++) {
+    putOut(s + i, 1);
+    if(s[i] == '"') {
+      putOut("\"", 1);
+    }
+  }
+  putOut("\"", 1);
+}
+
+//Writes the records of the batch as CSV
+static void writeCsv(Stage *st, Batch *b) {
+  int n_cols = b->schema->n_cols;
+
+  if(!st->header_done) {
+    for(int i = 0; i < n_cols; i++) {
+      if(i > 0) {
+        putOut(",", 1);
+      }
+      putField(b->schema->names[i], strlen(b->schema->names[i]));
+    }
+    putOut("\n", 1);
+    st->header_done = 1;
+  }
+  for(int k = 0; k < b->n_rows; k++) {
+    uint32_t row = b->rows == NULL ? k : b->rows[k];
+    if(out_len + n_cols * INT_STR_SIZE + 1 > sizeof(out_buf)) {
+      flushOut();
+    }
+    for(int i = 0; i < n_cols; i++) {
+      Column *c = &(b->cols[i]);
+      if(i > 0) {
+        out_buf[out_len++] = ',';
+      }
+      if(c->type == COL_INT) {
+        out_len += intToStr(c->ints[row], out_buf + out_len);
+      }
+      else {
+        putField(c->strs[c->codes[row]], c->lens[c->codes[row]]);
+        if(out_len + (n_cols - i) * INT_STR_SIZE + 1 > sizeof(out_buf)) {
+          flushOut();
+        }
+      }
+    }
+    out_buf[out_len++] = '\n';
+  }
+}
+
+//Returns the index of the column with the given name, or exits
+static int findColumn(Stage *st, Schema *schema, char *name) {
+  for(int i = 0; i < schema->n_cols; i++) {
+    if(strcmp(schema->names[i], name) == 0) {
+      return i;
+    }
+  }
+  fprintf(stderr, "bash: %s: %s: no such column\n", st->argv[0], name);
+  exit(1);
+}
+
+//Returns 1 if cmp, the comparison of a value with the one of where, satisfies its operator
+static int opHolds(int op, int cmp) {
+  switch(op) {
+  case OP_EQ: return cmp == 0;
+  case OP_NE: return cmp != 0;
+  case OP_LT: return cmp < 0;
+  case OP_LE: return cmp <= 0;
+  case OP_GT: return cmp > 0;
+  default: return cmp >= 0;
+  }
+}
+
+//Compares the string s with the value of where, as numbers if both are
+static int compareWithValue(Stage *st, char *s, uint32_t len) {
+  double d;
+
+  if(st->value_is_num && parseNumber(s, &d)) {
+    return (d > st->value_num) - (d < st->value_num);
+  }
+  size_t value_len = strlen(st->value);
+  int cmp = memcmp(s, st->value, len < value_len ? len : value_len);
+
+  return cmp != 0 ? cmp : (len > value_len) - (len < value_len);
+}
+
+//Selects the records of the batch satisfying where
+static void filterBatch(Stage *st, Batch *b) {
+  Column *c = &(b->cols[st->col]);
+  uint32_t *rows = (uint32_t *) batchAlloc(b, sizeof(uint32_t) * (b->n_rows + 1));
+  int n = 0;
+
+  if(c->type == COL_INT && (st->value_is_int || st->value_is_num)) {
+    for(int k = 0; k < b->n_rows; k++) {
+      uint32_t row = b->rows == NULL ? k : b->rows[k];
+      int64_t v = c->ints[row];
+      int cmp = st->value_is_int ? (v > st->value_int) - (v < st->value_int) : ((double) v > st->value_num) - ((double) v < st->value_num);
+      rows[n] = row;
+      n += opHolds(st->op, cmp);
+    }
+  }
+  else if(c->type == COL_INT) {
+    char buf[INT_STR_SIZE];
+    for(int k = 0; k < b->n_rows; k++) {
+      uint32_t row = b->rows == NULL ? k : b->rows[k];
+      int len = intToStr(c->ints[row], buf);
+      rows[n] = row;
+      n += opHolds(st->op, compareWithValue(st, buf, len));
+    }
+  }
+  else {
+    //Compare each distinct string once
+    char *holds = (char *) batchAlloc(b, c->n_strs + 1);
+    for(int i = 0; i < c->n_strs; i++) {
+      holds[i] = opHolds(st->op, compareWithValue(st, c->strs[i], c->lens[i]));
+    }
+    for(int k = 0; k < b->n_rows; k++) {
+      uint32_t row = b->rows == NULL ? k : b->rows[k];
+      rows[n] = row;
+      n += holds[c->codes[row]];
+    }
+  }
+  b->rows = rows;
+  b->n_rows = n;
+}
+
+//Makes the batch show the columns picked by select
+static void selectColumns(Stage *st, Batch *b) {
+  int n_cols = st->out_schema->n_cols;
+  Column *cols = (Column *) batchAlloc(b, sizeof(Column) * n_cols);
+
+  for(int i = 0; i < n_cols; i++) {
+    cols[i] = b->cols[st->map[i]];
+  }
+  b->cols = cols;
+  b->schema = st->out_schema;
+}
+
+//Orders sort keys by value, then by position in the input
+static int compareKeys(const void *a, const void *b) {
+  const SortKey *x = (const SortKey *) a;
+  const SortKey *y = (const SortKey *) b;
+  int cmp;
+
+  if(x->kind == 0 && y->kind == 0) {
+    cmp = (x->i > y->i) - (x->i < y->i);
+  }
+  else if(x->kind < 2 && y->kind < 2) {
+    double dx = x->kind == 0 ? (double) x->i : x->d;
+    double dy = y->kind == 0 ? (double) y->i : y->d;
+    cmp = (dx > dy) - (dx < dy);
+  }
+  else if(x->kind < 2 || y->kind < 2) {
+    cmp = x->kind < 2 ? -1 : 1; //numbers before strings
+  }
+  else {
+    cmp = memcmp(x->s, y->s, x->len < y->len ? x->len : y->len);
+    cmp = cmp != 0 ? cmp : (x->len > y->len) - (x->len < y->len);
+  }
+  if(sort_reverse) {
+    cmp = -cmp;
+  }
+
+  return cmp != 0 ? cmp : (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+//Sorts idx by the keys k with a stable radix sort, a byte at a time
+static void radixSort(uint64_t k[], uint32_t idx[], size_t n) {
+  uint64_t *k_from = k, *k_to = (uint64_t *) malloc(sizeof(uint64_t) * (n + 1));
+  uint32_t *idx_from = idx, *idx_to = (uint32_t *) malloc(sizeof(uint32_t) * (n + 1));
+
+  if(k_to == NULL || idx_to == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  for(int shift = 0; shift < 64 && n > 0; shift += 8) {
+    size_t count[257] = {0};
+    for(size_t i = 0; i < n; i++) {
+      count[((k_from[i] >> shift) & 0xff) + 1]++;
+    }
+    if(count[((k_from[0] >> shift) & 0xff) + 1] == n) {
+      continue; //every key has the same byte here
+    }
+    for(int d = 0; d < 256; d++) {
+      count[d + 1] += count[d];
+    }
+    for(size_t i = 0; i < n; i++) {
+      size_t j = count[(k_from[i] >> shift) & 0xff]++;
+      k_to[j] = k_from[i];
+      idx_to[j] = idx_from[i];
+    }
+    uint64_t *k_tmp = k_from;
+    uint32_t *idx_tmp = idx_from;
+    k_from = k_to;
+    idx_from = idx_to;
+    k_to = k_tmp;
+    idx_to = idx_tmp;
+  }
+  if(idx_from != idx) {
+    memcpy(idx, idx_from, sizeof(uint32_t) * n);
+    free(k_from);
+    free(idx_from);
+  }
+  else {
+    free(k_to);
+    free(idx_to);
+  }
+}
+
+//Sorts the keys, by a radix sort if every key is a number
+static void sortKeys(SortKey keys[], size_t n, int reverse) {
+  int max_kind = 0;
+
+  for(size_t i = 0; i < n; i++) {
+    max_kind = keys[i].kind > max_kind ? keys[i].kind : max_kind;
+  }
+  if(max_kind == 2) {
+    sort_reverse = reverse;
+    qsort(keys, n, sizeof(SortKey), compareKeys);
+    return;
+  }
+
+  //Turn the numbers into unsigned keys in the same order
+  uint64_t *k = (uint64_t *) malloc(sizeof(uint64_t) * (n + 1));
+  uint32_t *idx = (uint32_t *) malloc(sizeof(uint32_t) * (n + 1));
+  SortKey *sorted = (SortKey *) malloc(sizeof(SortKey) * (n + 1));
+  if(k == NULL || idx == NULL || sorted == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  for(size_t i = 0; i < n; i++) {
+    if(max_kind == 0) {
+      k[i] = (uint64_t) keys[i].i ^ (1ULL << 63);
+    }
+    else {
+      double d = keys[i].kind == 0 ? (double) keys[i].i : keys[i].d;
+      d = d == 0 ? 0.0 : d; //-0.0 is equal to 0 for compareKeys(), keep them in input order
+      memcpy(&(k[i]), &d, sizeof(d));
+      k[i] = (k[i] >> 63) ? ~k[i] : k[i] | (1ULL << 63);
+    }
+    k[i] = reverse ? ~k[i] : k[i];
+    idx[i] = i;
+  }
+  radixSort(k, idx, n);
+  for(size_t i = 0; i < n; i++) {
+    sorted[i] = keys[idx[i]];
+  }
+  memcpy(keys, sorted, sizeof(SortKey) * n);
+  free(sorted);
+  free(idx);
+  free(k);
+}
+
+static void pushBatch(Stage stages[], int i, int n, Batch *b);
+static void finishStages(Stage stages[], int i, int n);
+
+//Builds a batch of the records of keys, whose strings stay in their batches
+static Batch *gatherBatch(Schema *schema, SortKey keys[], int n) {
+  Batch *b = newBatch(schema);
+
+  b->n_rows = n;
+  for(int i = 0; i < schema->n_cols; i++) {
+    Column *c = &(b->cols[i]);
+    int all_int = 1;
+    for(int k = 0; k < n && all_int; k++) {
+      all_int = keys[k].batch->cols[i].type == COL_INT;
+    }
+    if(all_int) {
+      c->type = COL_INT;
+      c->ints = (int64_t *) batchAlloc(b, sizeof(int64_t) * n);
+      for(int k = 0; k < n; k++) {
+        c->ints[k] = keys[k].batch->cols[i].ints[keys[k].row];
+      }
+      continue;
+    }
+
+    //One dictionary entry per record, pointing into the batch it came from
+    c->type = COL_STR;
+    c->codes = (uint32_t *) batchAlloc(b, sizeof(uint32_t) * n);
+    c->strs = (char **) batchAlloc(b, sizeof(char *) * n);
+    c->lens = (uint32_t *) batchAlloc(b, sizeof(uint32_t) * n);
+    c->n_strs = n;
+    for(int k = 0; k < n; k++) {
+      Column *from = &(keys[k].batch->cols[i]);
+      c->codes[k] = k;
+      if(from->type == COL_INT) {
+        c->strs[k] = (char *) batchAlloc(b, INT_STR_SIZE);
+        c->lens[k] = intToStr(from->ints[keys[k].row], c->strs[k]);
+      }
+      else {
+        c->strs[k] = from->strs[from->codes[keys[k].row]];
+        c->lens[k] = from->lens[from->codes[keys[k].row]];
+      }
+    }
+  }
+
+  return b;
+}
+
+//Sorts the batches held by sort-by and passes them on
+static void sortHeld(Stage stages[], int i, int n) {
+  Stage *st = &(stages[i]);
+  size_t n_keys = 0;
+
+  if(st->schema == NULL) {
+    return; //no input
+  }
+  for(int h = 0; h < st->n_held; h++) {
+    n_keys += st->held[h]->n_rows;
+  }
+  SortKey *keys = (SortKey *) malloc(sizeof(SortKey) * (n_keys + 1));
+  if(keys == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  n_keys = 0;
+  for(int h = 0; h < st->n_held; h++) {
+    Batch *b = st->held[h];
+    Column *c = &(b->cols[st->col]);
+    for(int k = 0; k < b->n_rows; k++) {
+      SortKey *key = &(keys[n_keys]);
+      key->batch = b;
+      key->row = b->rows == NULL ? k : b->rows[k];
+      key->seq = n_keys++;
+      if(c->type == COL_INT) {
+        key->kind = 0;
+        key->i = c->ints[key->row];
+        continue;
+      }
+      key->s = c->strs[c->codes[key->row]];
+      key->len = c->lens[c->codes[key->row]];
+      key->kind = parseNumber(key->s, &(key->d)) ? 1 : 2;
+    }
+  }
+  sortKeys(keys, n_keys, st->reverse);
+
+  size_t k = 0;
+  do {
+    int part = n_keys - k > RECORD_BATCH_ROWS ? RECORD_BATCH_ROWS : n_keys - k;
+    pushBatch(stages, i + 1, n, gatherBatch(st->schema, keys + k, part));
+    k += part;
+  } while(k < n_keys);
+
+  free(keys);
+  for(int h = 0; h < st->n_held; h++) {
+    freeBatch(st->held[h]);
+  }
+  st->n_held = 0;
+}
+
+//Prepares a stage for the schema of its first batch
+static void setSchema(Stage *st, Schema *schema) {
+  st->schema = schema;
+  if(st->kind == STAGE_WHERE || st->kind == STAGE_SORT_BY) {
+    st->col = findColumn(st, schema, st->argv[1]);
+  }
+  if(st->kind != STAGE_SELECT) {
+    return;
+  }
+  st->out_schema = (Schema *) malloc(sizeof(Schema));
+  st->map = (int *) malloc(sizeof(int) * st->argc);
+  st->out_schema->names = (char **) malloc(sizeof(char *) * st->argc);
+  if(st->out_schema == NULL || st->map == NULL || st->out_schema->names == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  st->out_schema->n_cols = st->argc - 1;
+  for(int i = 1; i < st->argc; i++) {
+    st->map[i - 1] = findColumn(st, schema, st->argv[i]);
+    st->out_schema->names[i - 1] = schema->names[st->map[i - 1]];
+  }
+}
+
+//Passes the batch to stage i, which takes it over
+static void pushBatch(Stage stages[], int i, int n, Batch *b) {
+  Stage *st = &(stages[i]);
+
+  if(st->schema == NULL) {
+    setSchema(st, b->schema);
+  }
+  switch(st->kind) {
+  case STAGE_WHERE:
+    filterBatch(st, b);
+    pushBatch(stages, i + 1, n, b);
+    break;
+  case STAGE_SELECT:
+    selectColumns(st, b);
+    pushBatch(stages, i + 1, n, b);
+    break;
+  case STAGE_SORT_BY:
+    if(st->n_held == st->held_size) {
+      st->held_size = st->held_size == 0 ? 64 : st->held_size * 2;
+      st->held = (Batch **) realloc(st->held, sizeof(Batch *) * st->held_size);
+      if(st->held == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    st->held[st->n_held++] = b;
+    break;
+  default:
+    writeCsv(st, b);
+    freeBatch(b);
+  }
+}
+
+//Tells the stages from i on that the input has ended
+static void finishStages(Stage stages[], int i, int n) {
+  for(; i < n; i++) {
+    if(stages[i].kind == STAGE_SORT_BY) {
+      sortHeld(stages, i, n);
+    }
+  }
+  flushOut();
+}
+
+//Reads CSV from stdin and passes it to the stages in batches
+static void readCsv(Stage stages[], int n) {
+  size_t size = RECORD_IO_SIZE;
+  size_t start = 0, len = 0;
+  char *buf = (char *) malloc(size);
+  Builder *bld = NULL;
+  Schema *schema = NULL;
+  Batch *b = NULL;
+  Field fields[MAX_RECORD_COLUMNS];
+  int eof = 0, n_batches = 0;
+
+  if(buf == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  while(!eof) {
+    //Keep the incomplete record at the start of the buffer and read more
+    if(start > 0) {
+      memmove(buf, buf + start, len - start);
+      len -= start;
+      start = 0;
+    }
+    if(len == size) {
+      size *= 2;
+      buf = (char *) realloc(buf, size);
+      if(buf == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    ssize_t n_read = read(STDIN_FILENO, buf + len, size - len);
+    if(n_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n_read <= 0) {
+      eof = 1;
+    }
+    else {
+      len += n_read;
+    }
+
+    char *end;
+    while(start < len && (end = recordEnd(buf + start, buf + len, eof)) != NULL) {
+      char *p = buf + start;
+      start = end - buf + (end < buf + len); //past the newline
+      if(end == p || (end == p + 1 && *p == '\r')) {
+        continue; //an empty line
+      }
+      int n_fields = splitRecord(p, end, fields);
+      if(schema != NULL) {
+        if(b == NULL) {
+          b = startBatch(schema, bld);
+        }
+        addRecord(b, bld, fields, n_fields);
+        if(b->n_rows == RECORD_BATCH_ROWS) {
+          pushBatch(stages, 0, n, b);
+          n_batches++;
+          b = NULL;
+        }
+        continue;
+      }
+
+      //The first record names the columns
+      schema = (Schema *) malloc(sizeof(Schema));
+      if(schema == NULL || (schema->names = (char **) malloc(sizeof(char *) * n_fields)) == NULL || (bld = (Builder *) malloc(sizeof(Builder) * n_fields)) == NULL) {
+        perror("malloc");
+        exit(1);
+      }
+      schema->n_cols = n_fields;
+      for(int i = 0; i < n_fields; i++) {
+        schema->names[i] = strndup(fields[i].s, fields[i].len);
+      }
+    }
+  }
+  if(b == NULL && schema != NULL && n_batches == 0) {
+    b = newBatch(schema); //no records, the header is still written
+  }
+  if(b != NULL) {
+    pushBatch(stages, 0, n, b);
+  }
+  finishStages(stages, 0, n);
+  free(buf);
+}
+
+//Checks the arguments of the stage and sets it up
+//Returns -1 if they are wrong
+static int setStage(Stage *st, char *argv[], int argc, int first, int last) {
+  memset(st, 0, sizeof(Stage));
+  st->argv = argv;
+  st->argc = argc;
+  for(st->kind = 0; strcmp(argv[0], stage_names[st->kind]) != 0; st->kind++) {
+  }
+  switch(st->kind) {
+  case STAGE_FROM_CSV:
+    if(argc != 1 || !first) {
+      fprintf(stderr, "bash: from-csv: usage: from-csv, as the first record stage\n");
+      return -1;
+    }
+    break;
+  case STAGE_TO_CSV:
+    if(argc != 1 || !last) {
+      fprintf(stderr, "bash: to-csv: usage: to-csv, as the last record stage\n");
+      return -1;
+    }
+    break;
+  case STAGE_WHERE: {
+    char *ops[] = {"=", "!=", "lt", "le", "gt", "ge"};
+    st->op = -1;
+    for(int i = 0; argc == 4 && i < 6; i++) {
+      if(strcmp(argv[2], ops[i]) == 0 || (i == OP_EQ && strcmp(argv[2], "==") == 0)) {
+        st->op = i;
+      }
+    }
+    if(st->op < 0) {
+      fprintf(stderr, "bash: where: usage: where column =|!=|lt|le|gt|ge value\n");
+      return -1;
+    }
+    st->value = argv[3];
+    st->value_is_int = parseInt(argv[3], strlen(argv[3]), &(st->value_int));
+    st->value_is_num = parseNumber(argv[3], &(st->value_num));
+    break;
+  }
+  case STAGE_SELECT:
+    if(argc < 2) {
+      fprintf(stderr, "bash: select: usage: select columns...\n");
+      return -1;
+    }
+    break;
+  default:
+    st->reverse = argc == 3 && strcmp(argv[2], "-r") == 0;
+    if(argc != 2 + st->reverse) {
+      fprintf(stderr, "bash: sort-by: usage: sort-by column [-r]\n");
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+//Runs the record stages command[first] to command[last] in this process
+//Returns the exit status
+static int runRecordStages(Command command[], int first, int last) {
+  int n = last - first + 1;
+  Stage stages[n + 1];
+  int n_stages = 0;
+
+  for(int i = first; i <= last; i++) {
+    int argc = command[i].last - command[i].first + 1;
+    if(command[i].stdin_file != NULL || command[i].stdout_file != NULL) {
+      argc = argc - 2; //the redirection is at the end
+    }
+    if(setStage(&(stages[n_stages]), command[i].argv, argc, i == first, i == last) < 0) {
+      return 1;
+    }
+    n_stages++;
+  }
+
+  //Text comes in and goes out as CSV unless the stages say so
+  Stage *run = stages;
+  if(run[0].kind == STAGE_FROM_CSV) {
+    run++; //readCsv() is the source of the batches
+    n_stages--;
+  }
+  if(n_stages == 0 || run[n_stages - 1].kind != STAGE_TO_CSV) {
+    static char *to_csv[] = {"to-csv", NULL};
+    setStage(&(run[n_stages++]), to_csv, 1, 0, 1);
+  }
+  readCsv(run, n_stages);
+
+  return 0;
+}
+
+//Replaces the child by the command, which is not a record stage
+static void execStage(int index, Command command[]) {
+  int redirected = command[index].stdin_file != NULL || command[index].stdout_file != NULL;
+  int wildcard = redirected ? isWildCardForStdinStdout(index, command) : isWildCard(index, command);
+  int n_wildcard_tokens = wildcard == -1 ? 0 : numOfWildCardFiles(command[index].argv[wildcard]);
+  char **argv = allocArgv(command[index].last - command[index].first + 2 + n_wildcard_tokens);
+
+  if(redirected && wildcard != -1) {
+    getArgvForWildCardStdinStdout(index, command, argv);
+  }
+  else if(redirected) {
+    getArgvForStdinStdout(index, command, argv);
+  }
+  else if(wildcard != -1) {
+    getArgvForWildCard(index, command, argv);
+  }
+  else {
+    getArgvForExecuteCommand(index, command, argv);
+  }
+  execArgv(index, command, argv);
+  perror("execvp");
+  exit(1);
+}
+
+//Processes the pipeline starting at index if it has a record stage
+int processRecords(int index, Command command[]) {
+  int last = index;
+  int found = isRecordStage(command[index].argv[0]);
+
+  while(strcmp(command[last].sep, pipeSep) == 0) {
+    last++;
+    found |= command[last].argv[0] != NULL && isRecordStage(command[last].argv[0]);
+  }
+  if(!found) {
+    return 0;
+  }
+
+  pid_t pids[last - index + 1];
+  int n_pids = 0;
+  int in = -1; //read end of the pipe from the previous part
+  for(int i = index; i <= last; ) {
+    //A run of record stages is one part of the pipeline, any other command another
+    int end = i;
+    int records = isRecordStage(command[i].argv[0]);
+    while(records && end < last && isRecordStage(command[end + 1].argv[0])) {
+      end++;
+    }
+    int p[2] = {-1, -1};
+    if(end < last && pipe(p) < 0) {
+      perror("pipe");
+      exit(1);
+    }
+
+    pid_t pid;
+    if((pid = pids[n_pids++] = forkCommand(command[i].argv[0])) < 0) {
+      perror("fork");
+      exit(1);
+    }
+    if(pid == 0) {
+      if(in >= 0) {
+        dup2(in, STDIN_FILENO);
+        close(in);
+      }
+      else if(command[i].stdin_file != NULL) {
+        int stdin_fd = openStdinFile(&(command[i]));
+        dup2(stdin_fd, STDIN_FILENO);
+        close(stdin_fd);
+      }
+      if(p[1] >= 0) {
+        dup2(p[1], STDOUT_FILENO);
+        close(p[0]);
+        close(p[1]);
+      }
+      else if(command[end].stdout_file != NULL) {
+        int stdout_fd = open(command[end].stdout_file, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+        if(stdout_fd < 0) {
+          perror(command[end].stdout_file);
+          exit(1);
+        }
+        dup2(stdout_fd, STDOUT_FILENO);
+        close(stdout_fd);
+      }
+      if(!records) {
+        execStage(i, command);
+      }
+      recordExec();
+      startStageCounters();
+      exit(runRecordStages(command, i, end));
+    }
+    if(in >= 0) {
+      close(in);
+    }
+    if(p[1] >= 0) {
+      close(p[1]);
+    }
+    in = p[0];
+    i = end + 1;
+  }
+
+  for(int i = 0; i < n_pids; i++) {
+    waitChild(pids[i]);
+  }
+
+  return last - index + 1;
+}
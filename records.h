@@ -0,0 +1,45 @@
+/*
+ * File:	records.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Run a pipeline containing the record stages "from-csv",
+		"where column op value", "select columns...", "sort-by
+		column [-r]" and "to-csv", which pass tables of records to
+		each other instead of text.
+
+   Return:	1) isRecordStage() returns 1 if name is a record stage.
+		2) processRecords() returns the number of commands of the
+		   pipeline starting at "index", or 0 if none of them is a
+		   record stage.
+
+   Note:	1) Consecutive record stages run in one child, and a batch
+		   of up to RECORD_BATCH_ROWS records is handed from one to
+		   the next by pointer. The other commands of the pipeline
+		   run as usual, connected to the record stages by pipes.
+		2) A batch keeps each column as an array of 64-bit integers
+		   if every value of the column in the batch is one, or
+		   else as an array of codes into a dictionary of the
+		   distinct strings of the column. Everything in a batch is
+		   allocated from an arena freed with the batch.
+		3) Records are parsed from CSV with a header line only where
+		   text comes in, and written as CSV only where text goes
+		   out. from-csv and to-csv say so explicitly, but may be
+		   left out next to another command or the terminal.
+		4) where compares numerically when both the value and the
+		   column are numbers, and as strings otherwise. op is one
+		   of =, !=, lt, le, gt and ge, as < and > are redirections.
+		   On a string column the comparison is made once per
+		   dictionary entry rather than once per record.
+		5) select only rearranges the pointers to the columns.
+		   sort-by holds every batch until the input ends.
+*/
+
+#define RECORD_BATCH_ROWS 8192 //records per batch, a power of 2
+#define RECORD_IO_SIZE (1024 * 1024) //size of the reads and writes of CSV
+#define RECORD_ARENA_BLOCK (256 * 1024) //initial size of a block of the arena of a batch
+#define MAX_RECORD_COLUMNS 256
+
+int isRecordStage(char *name);
+int processRecords(int index, Command command[]);
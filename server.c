@@ -0,0 +1,174 @@
+/*
+ * File:	server.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "pathcache.h"
+#include "snapshot.h"
+#include "server.h"
+
+//Reads exactly len bytes, returns -1 on error or end of file
+static int readAll(int fd, void *buf, size_t len) {
+  char *p = (char *) buf;
+
+  while(len > 0) {
+    ssize_t n = read(fd, p, len);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      return -1;
+    }
+    p += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+//Receives a request with its three file descriptors
+//Returns the payload, or NULL if the request is invalid
+static char *receiveRequest(int conn, int fds[3], uint32_t *length) {
+  ServerRequest req;
+  char control[CMSG_SPACE(sizeof(int) * 3)];
+  struct iovec iov = {&req, sizeof(req)};
+  struct msghdr msg;
+  ssize_t n;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  while((n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+  }
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  if(n <= 0 || cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(int) * 3)) {
+    return NULL;
+  }
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * 3);
+  if((size_t) n < sizeof(req) && readAll(conn, (char *) &req + n, sizeof(req) - n) < 0) {
+    return NULL;
+  }
+  if(req.magic != SERVER_MAGIC || req.length == 0 || req.length > SERVER_MAX_REQUEST) {
+    return NULL;
+  }
+
+  char *payload = (char *) malloc(req.length + 1);
+  if(payload == NULL || readAll(conn, payload, req.length) < 0) {
+    free(payload);
+    return NULL;
+  }
+  payload[req.length] = '\0';
+  *length = req.length;
+
+  return payload;
+}
+
+//Runs one request in a child of the server and replies with its exit status
+static void serveRequest(int conn) {
+  int fds[3];
+  uint32_t length;
+  char *payload = receiveRequest(conn, fds, &length);
+  int32_t status = 2;
+
+  if(payload == NULL) {
+    exit(1);
+  }
+
+  //Take over the directory, environment and files of the client
+  char *line = payload;
+  char *cwd = line + strlen(line) + 1;
+  char *env = cwd + strlen(cwd) + 1;
+  if(cwd >= payload + length || chdir(cwd) != 0) {
+    write(conn, &status, sizeof(status));
+    exit(1);
+  }
+  while(env < payload + length) {
+    if(strchr(env, '=') != NULL) {
+      putenv(env);
+    }
+    env += strlen(env) + 1;
+  }
+  for(int i = 0; i < 3; i++) {
+    dup2(fds[i], i);
+    close(fds[i]);
+  }
+
+  status = runLine(line);
+  fflush(stdout);
+  write(conn, &status, sizeof(status));
+  exit(0);
+}
+
+//Accepts clients on a Unix domain socket until the shell is killed
+int runServer(char *socket_path) {
+  struct sockaddr_un addr;
+  int sock;
+
+  if(strlen(socket_path) >= sizeof(addr.sun_path)) {
+    printf("bash: --server: %s: path name too long\n", socket_path);
+    return 1;
+  }
+  if((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+    perror("socket");
+    return 1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+  unlink(socket_path);
+  if(bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(sock, SERVER_BACKLOG) < 0) {
+    perror(socket_path);
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN); //a client may go away before its status is sent
+  warmPathCache();
+  saveSnapshot(); //the next server starts warm
+
+  while(1) {
+    int conn = accept(sock, NULL, NULL);
+    int accept_errno = errno;
+
+    //Claim the children that served earlier requests
+    while(waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+    if(conn < 0) {
+      if(accept_errno == EINTR || accept_errno == ECONNABORTED) {
+        continue;
+      }
+      errno = accept_errno;
+      perror("accept");
+      return 1;
+    }
+    fflush(stdout);
+    pid_t pid;
+    if((pid = fork()) < 0) {
+      perror("fork");
+      close(conn);
+      continue;
+    }
+    if(pid == 0) {
+      close(sock);
+      signal(SIGPIPE, SIG_DFL);
+      serveRequest(conn);
+    }
+    close(conn);
+  }
+}
@@ -0,0 +1,36 @@
+/*
+ * File:	server.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Serve command lines to local clients over a Unix domain
+		socket, so that a client does not pay for starting a new
+		shell.
+
+   Protocol:	1) The client sends a ServerRequest together with its
+		   stdin, stdout and stderr as SCM_RIGHTS ancillary data,
+		   followed by "length" bytes: the command line, the current
+		   directory and the environment of the client, each
+		   terminated by a NUL.
+		2) The server runs the command line in a child process with
+		   the client's files, directory and environment on top of
+		   its own, and replies with the exit status as an int32_t.
+
+   Note:	Every request runs in a child forked from the server, so the
+		caches the server has warmed up are shared by all requests
+		and no request can change them for the next one.
+*/
+
+#define SERVER_MAGIC 0x6873796d //"mysh"
+#define SERVER_MAX_REQUEST (1024 * 1024) //upper limit on "length"
+#define SERVER_BACKLOG 128
+
+struct ServerRequestStruct {
+  uint32_t magic; //SERVER_MAGIC
+  uint32_t length; //number of bytes following the request
+};
+
+typedef struct ServerRequestStruct ServerRequest;
+
+int runServer(char *socket_path);
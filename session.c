@@ -0,0 +1,717 @@
+/*
+ * File:	session.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "token.h"
+#include "command.h"
+#include "myshell.h"
+#include "job.h"
+#include "metrics.h"
+#include "pathcache.h"
+#include "session.h"
+
+#define STR_SIZE 1024
+#define MAX_REPLAY_NAMES 256 //commands compared in the report
+
+//A command of a line, as recorded by recordSessionCommand()
+struct SessionCommandStruct {
+  char name[METRIC_NAME_SIZE];
+  uint64_t wall_ns;
+  int status;
+};
+
+typedef struct SessionCommandStruct SessionCommand;
+
+//The times of a line
+struct LinePhasesStruct {
+  uint64_t parse_ns;
+  uint64_t spawn_ns;
+  uint64_t spawns;
+  uint64_t wait_ns;
+  uint64_t wall_ns;
+  int status;
+};
+
+typedef struct LinePhasesStruct LinePhases;
+
+//A line read back from a recording
+struct SessionLineStruct {
+  uint64_t offset_ns; //since the session started
+  char *cwd; //NULL if the same as for the line before
+  char **env; //"NAME=value" to set and "NAME" to unset, NULL-terminated
+  char *line;
+  LinePhases phases;
+  SessionCommand *commands;
+  int n_commands;
+};
+
+typedef struct SessionLineStruct SessionLine;
+
+//Bytes of a record being written
+struct BufferStruct {
+  unsigned char *data;
+  size_t len;
+  size_t size;
+};
+
+typedef struct BufferStruct Buffer;
+
+//Bytes of a recording being read
+struct ReaderStruct {
+  unsigned char *p;
+  unsigned char *end;
+  int bad; //1 once a field went past the end
+};
+
+typedef struct ReaderStruct Reader;
+
+//Wall times of a command by name, for the report
+struct NameTimesStruct {
+  char name[METRIC_NAME_SIZE];
+  uint64_t recorded_ns;
+  uint64_t recorded;
+  uint64_t failed;
+  uint64_t replayed_ns;
+  uint64_t replayed;
+};
+
+typedef struct NameTimesStruct NameTimes;
+
+extern char **environ;
+
+static FILE *record_fp = NULL;
+static int active = 0; //1 while recording or replaying
+static uint64_t session_start = 0;
+static char *last_cwd = NULL;
+static char **last_env = NULL;
+static char *line_text = NULL; //the line being run
+static Buffer line_state = {NULL, 0, 0}; //cwd and environment changes the line started with
+static uint64_t line_start = 0;
+static MetricsTotals line_totals; //when the line started
+static SessionCommand line_commands[MAX_SESSION_COMMANDS]; //commands of the line
+static int n_line_commands = 0;
+static LinePhases last_phases; //of the line that has just ended
+
+//Appends n bytes to a buffer
+static void putBytes(Buffer *b, void *data, size_t n) {
+  if(b->len + n > b->size) {
+    b->size = (b->len + n) * 2;
+    b->data = (unsigned char *) realloc(b->data, b->size);
+    if(b->data == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  memcpy(b->data + b->len, data, n);
+  b->len += n;
+}
+
+//Appends a number, 7 bits per byte from the lowest, the top bit set on all but the last byte
+static void putNumber(Buffer *b, uint64_t v) {
+  unsigned char bytes[10];
+  int n = 0;
+
+  do {
+    bytes[n] = (v & 0x7f) | (v > 0x7f ? 0x80 : 0);
+    v >>= 7;
+    n++;
+  } while(v != 0);
+  putBytes(b, bytes, n);
+}
+
+//Appends a string as its length and its bytes
+static void putString(Buffer *b, char *s) {
+  size_t len = strlen(s);
+
+  putNumber(b, len);
+  putBytes(b, s, len);
+}
+
+//Reads a number written by putNumber()
+static uint64_t getNumber(Reader *r) {
+  uint64_t v = 0;
+
+  for(int shift = 0; shift < 64; shift += 7) {
+    if(r->p >= r->end) {
+      r->bad = 1;
+      return 0;
+    }
+    unsigned char byte = *(r->p++);
+    v |= (uint64_t) (byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) {
+      return v;
+    }
+  }
+  r->bad = 1;
+
+  return v;
+}
+
+//Reads a string written by putString(), returns a copy to be freed
+static char *getString(Reader *r) {
+  uint64_t len = getNumber(r);
+
+  if(r->bad || len > (uint64_t) (r->end - r->p)) {
+    r->bad = 1;
+    return strdup("");
+  }
+  char *s = strndup((char *) r->p, len);
+  r->p += len;
+
+  return s;
+}
+
+//Returns a copy of a NULL-terminated list of strings
+static char **copyList(char **list) {
+  int n = 0;
+
+  while(list[n] != NULL) {
+    n++;
+  }
+  char **copy = (char **) malloc((n + 1) * sizeof(char *));
+  if(copy == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  for(int i = 0; i < n; i++) {
+    copy[i] = strdup(list[i]);
+  }
+  copy[n] = NULL;
+
+  return copy;
+}
+
+//Frees a list made by copyList()
+static void freeList(char **list) {
+  for(int i = 0; list != NULL && list[i] != NULL; i++) {
+    free(list[i]);
+  }
+  free(list);
+}
+
+//Returns 1 if the list holds a string equal to s, or with the name of s if len is not 0
+static int inList(char **list, char *s, size_t len) {
+  for(int i = 0; list[i] != NULL; i++) {
+    if(len == 0 ? strcmp(list[i], s) == 0 : strncmp(list[i], s, len) == 0 && list[i][len] == '=') {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Appends the changes of the environment since last_env, and makes it the environment now
+static void putEnvChanges(Buffer *b) {
+  char *changes[STR_SIZE];
+  int n = 0;
+
+  for(int i = 0; environ[i] != NULL && n < STR_SIZE; i++) {
+    if(!inList(last_env, environ[i], 0)) {
+      changes[n++] = strdup(environ[i]);
+    }
+  }
+  for(int i = 0; last_env[i] != NULL && n < STR_SIZE; i++) {
+    size_t len = strcspn(last_env[i], "=");
+    if(!inList(environ, last_env[i], len)) {
+      changes[n++] = strndup(last_env[i], len);
+    }
+  }
+  putNumber(b, n);
+  for(int i = 0; i < n; i++) {
+    putString(b, changes[i]);
+    free(changes[i]);
+  }
+  if(n > 0) {
+    freeList(last_env);
+    last_env = copyList(environ);
+  }
+}
+
+//Opens the file and writes the start of the session
+int startRecording(char *path) {
+  Buffer b = {NULL, 0, 0};
+  struct timespec ts;
+
+  if((record_fp = fopen(path, "w")) == NULL) {
+    perror(path);
+    return -1;
+  }
+  clock_gettime(CLOCK_REALTIME, &ts);
+  putBytes(&b, SESSION_MAGIC, sizeof(SESSION_MAGIC)); //with its '\0'
+  putNumber(&b, SESSION_VERSION);
+  putNumber(&b, (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+  last_env = copyList(environ);
+  int n = 0;
+  while(environ[n] != NULL) {
+    n++;
+  }
+  putNumber(&b, n);
+  for(int i = 0; i < n; i++) {
+    putString(&b, environ[i]);
+  }
+  fwrite(b.data, 1, b.len, record_fp);
+  fflush(record_fp);
+  free(b.data);
+  session_start = metricsNow();
+  active = 1;
+
+  return 0;
+}
+
+//Notes the start of a line accepted by getInput()
+void beginLine(char *line) {
+  if(!active) {
+    return;
+  }
+  free(line_text);
+  line_text = strdup(line); //parsing cuts the line into tokens
+  if(record_fp != NULL) {
+    //The state the line runs in, replayed before it
+    char cwd[PATH_MAX];
+    int changed = getcwd(cwd, sizeof(cwd)) != NULL && (last_cwd == NULL || strcmp(cwd, last_cwd) != 0);
+    line_state.len = 0;
+    putNumber(&line_state, changed);
+    if(changed) {
+      putString(&line_state, cwd);
+      free(last_cwd);
+      last_cwd = strdup(cwd);
+    }
+    putEnvChanges(&line_state);
+  }
+  __atomic_store_n(&n_line_commands, 0, __ATOMIC_RELAXED);
+  metricsTotals(&line_totals);
+  line_start = metricsNow();
+}
+
+//Keeps a command of the line that has exited, called from recordExit()
+void recordSessionCommand(char *name, uint64_t wall_ns, int status) {
+  if(!active) {
+    return;
+  }
+  int i = __atomic_fetch_add(&n_line_commands, 1, __ATOMIC_RELAXED);
+  if(i < MAX_SESSION_COMMANDS) {
+    strncpy(line_commands[i].name, name, METRIC_NAME_SIZE - 1);
+    line_commands[i].name[METRIC_NAME_SIZE - 1] = '\0';
+    line_commands[i].wall_ns = wall_ns;
+    line_commands[i].status = status;
+  }
+}
+
+//Works out the times of the line that has ended, and writes its record
+void endLine() {
+  MetricsTotals totals;
+
+  if(!active) {
+    return;
+  }
+  uint64_t end = metricsNow();
+  metricsTotals(&totals);
+  last_phases.parse_ns = totals.parse_ns - line_totals.parse_ns;
+  last_phases.spawn_ns = totals.spawn_ns - line_totals.spawn_ns;
+  last_phases.spawns = totals.spawns - line_totals.spawns;
+  last_phases.wait_ns = totals.wait_ns - line_totals.wait_ns;
+  last_phases.wall_ns = end - line_start;
+  last_phases.status = lastStatus;
+  if(record_fp == NULL) {
+    return;
+  }
+
+  Buffer b = {NULL, 0, 0};
+  putNumber(&b, line_start - session_start);
+  putBytes(&b, line_state.data, line_state.len);
+  putString(&b, line_text);
+  putNumber(&b, last_phases.parse_ns);
+  putNumber(&b, last_phases.spawn_ns);
+  putNumber(&b, last_phases.spawns);
+  putNumber(&b, last_phases.wait_ns);
+  putNumber(&b, last_phases.wall_ns);
+  putNumber(&b, last_phases.status);
+  int n = __atomic_load_n(&n_line_commands, __ATOMIC_RELAXED);
+  n = n < MAX_SESSION_COMMANDS ? n : MAX_SESSION_COMMANDS;
+  putNumber(&b, n);
+  for(int i = 0; i < n; i++) {
+    putString(&b, line_commands[i].name);
+    putNumber(&b, line_commands[i].wall_ns);
+    putNumber(&b, line_commands[i].status);
+  }
+
+  //The type and length of the record, then the record
+  Buffer head = {NULL, 0, 0};
+  putNumber(&head, SESSION_LINE);
+  putNumber(&head, b.len);
+  fwrite(head.data, 1, head.len, record_fp);
+  fwrite(b.data, 1, b.len, record_fp);
+  fflush(record_fp);
+  free(head.data);
+  free(b.data);
+}
+
+//Reads the record of a line
+static void readLine(Reader *r, SessionLine *sl) {
+  memset(sl, 0, sizeof(SessionLine));
+  sl->offset_ns = getNumber(r);
+  if(getNumber(r)) {
+    sl->cwd = getString(r);
+  }
+  uint64_t n_env = getNumber(r);
+  if(n_env > (uint64_t) (r->end - r->p)) {
+    r->bad = 1;
+    return;
+  }
+  sl->env = (char **) calloc(n_env + 1, sizeof(char *));
+  for(uint64_t i = 0; i < n_env; i++) {
+    sl->env[i] = getString(r);
+  }
+  sl->line = getString(r);
+  sl->phases.parse_ns = getNumber(r);
+  sl->phases.spawn_ns = getNumber(r);
+  sl->phases.spawns = getNumber(r);
+  sl->phases.wait_ns = getNumber(r);
+  sl->phases.wall_ns = getNumber(r);
+  sl->phases.status = getNumber(r);
+  uint64_t n = getNumber(r);
+  if(n > MAX_SESSION_COMMANDS) {
+    r->bad = 1;
+    return;
+  }
+  sl->commands = (SessionCommand *) calloc(n + 1, sizeof(SessionCommand));
+  sl->n_commands = n;
+  for(uint64_t i = 0; i < n; i++) {
+    char *name = getString(r);
+    snprintf(sl->commands[i].name, METRIC_NAME_SIZE, "%s", name);
+    free(name);
+    sl->commands[i].wall_ns = getNumber(r);
+    sl->commands[i].status = getNumber(r);
+  }
+}
+
+//Reads a recording, returns its lines and stores their number in n_lines, or returns NULL
+static SessionLine *readSession(char *path, int *n_lines) {
+  FILE *fp = fopen(path, "r");
+  struct stat buf;
+
+  if(fp == NULL || fstat(fileno(fp), &buf) != 0) {
+    perror(path);
+    return NULL;
+  }
+  unsigned char *data = (unsigned char *) malloc(buf.st_size + 1);
+  if(data == NULL || fread(data, 1, buf.st_size, fp) != (size_t) buf.st_size) {
+    perror(path);
+    fclose(fp);
+    free(data);
+    return NULL;
+  }
+  fclose(fp);
+
+  Reader r = {data, data + buf.st_size, 0};
+  if((size_t) buf.st_size < sizeof(SESSION_MAGIC) || memcmp(data, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+    fprintf(stderr, "bash: --replay: %s: not a recording\n", path);
+    free(data);
+    return NULL;
+  }
+  r.p += sizeof(SESSION_MAGIC);
+  if(getNumber(&r) != SESSION_VERSION) {
+    fprintf(stderr, "bash: --replay: %s: recorded by another version\n", path);
+    free(data);
+    return NULL;
+  }
+  getNumber(&r); //time of day of the start
+  uint64_t n_env = getNumber(&r);
+  for(uint64_t i = 0; i < n_env && !r.bad; i++) {
+    free(getString(&r));
+  }
+
+  int size = 64;
+  SessionLine *lines = (SessionLine *) malloc(size * sizeof(SessionLine));
+  *n_lines = 0;
+  while(r.p < r.end && !r.bad && lines != NULL) {
+    uint64_t type = getNumber(&r);
+    uint64_t len = getNumber(&r);
+    if(r.bad || len > (uint64_t) (r.end - r.p)) {
+      break; //cut short, e.g. by a crash while writing
+    }
+    Reader rec = {r.p, r.p + len, 0};
+    r.p += len;
+    if(type != SESSION_LINE) {
+      continue; //written by a later version
+    }
+    if(*n_lines == size) {
+      size *= 2;
+      lines = (SessionLine *) realloc(lines, size * sizeof(SessionLine));
+      if(lines == NULL) {
+        break;
+      }
+    }
+    readLine(&rec, &(lines[*n_lines]));
+    if(!rec.bad) {
+      (*n_lines)++;
+    }
+  }
+  free(data);
+
+  return lines;
+}
+
+//Makes a directory and the ones above it
+static void makeDirs(char *path) {
+  char dir[PATH_MAX];
+
+  snprintf(dir, sizeof(dir), "%s", path);
+  for(char *slash = strchr(dir + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+    *slash = '\0';
+    mkdir(dir, 0755);
+    *slash = '/';
+  }
+  mkdir(dir, 0755);
+}
+
+//Returns the entry of a name in the table of commands, adding it if there is room
+static NameTimes *nameTimes(NameTimes names[], int *n_names, char *name) {
+  for(int i = 0; i < *n_names; i++) {
+    if(strcmp(names[i].name, name) == 0) {
+      return &(names[i]);
+    }
+  }
+  if(*n_names == MAX_REPLAY_NAMES) {
+    return NULL;
+  }
+  NameTimes *nt = &(names[(*n_names)++]);
+  memset(nt, 0, sizeof(NameTimes));
+  snprintf(nt->name, METRIC_NAME_SIZE, "%s", name);
+
+  return nt;
+}
+
+//Makes dir/.stubs with a link to true or false for every command of the recording
+static void makeStubs(char *dir, SessionLine lines[], int n_lines, NameTimes names[], int n_names) {
+  char *command_token[MAX_NUM_TOKENS];
+  Command command[MAX_NUM_COMMANDS];
+  char input[STR_SIZE];
+  char stub[PATH_MAX];
+  char *true_path = lookupPath("true");
+  char *false_path = lookupPath("false");
+
+  if(true_path == NULL || false_path == NULL) {
+    fprintf(stderr, "bash: --stubs: true and false not found\n");
+    return;
+  }
+  true_path = strdup(true_path);
+  false_path = strdup(false_path);
+  snprintf(stub, sizeof(stub), "%s/.stubs", dir);
+  mkdir(stub, 0755);
+  setenv("PATH", stub, 1);
+
+  //The commands the shell waited for, then the first words of the commands of each line
+  for(int i = 0; i < n_names; i++) {
+    snprintf(stub, sizeof(stub), "%s/.stubs/%s", dir, names[i].name);
+    symlink(2 * names[i].failed > names[i].recorded ? false_path : true_path, stub);
+  }
+  for(int i = 0; i < n_lines; i++) {
+    snprintf(input, sizeof(input), "%s", lines[i].line);
+    int n_commands = parseCommand(input, command_token, command);
+    for(int j = 0; j < n_commands; j++) {
+      char *name = command[j].argv != NULL ? command[j].argv[0] : NULL;
+      if(name != NULL && strpbrk(name, "/$`") == NULL && !builtInCommand(j, command)) {
+        snprintf(stub, sizeof(stub), "%s/.stubs/%s", dir, name);
+        symlink(true_path, stub); //fails if it is there already
+      }
+    }
+  }
+  free(true_path);
+  free(false_path);
+}
+
+//Returns the value below which a fraction q of the n sorted values are
+static uint64_t percentile(uint64_t sorted[], int n, double q) {
+  if(n == 0) {
+    return 0;
+  }
+  int i = (int) (q * n);
+
+  return sorted[i < n ? i : n - 1];
+}
+
+static int compareTimes(const void *a, const void *b) {
+  uint64_t x = *(uint64_t *) a, y = *(uint64_t *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+//Prints the percentiles of a phase, recorded and replayed
+static void printPhase(char *name, uint64_t recorded[], int n_recorded, uint64_t replayed[], int n_replayed) {
+  char t[6][32];
+
+  qsort(recorded, n_recorded, sizeof(uint64_t), compareTimes);
+  qsort(replayed, n_replayed, sizeof(uint64_t), compareTimes);
+  fprintf(stderr, "%-8s %9s %9s %9s   %9s %9s %9s", name, formatTime(percentile(recorded, n_recorded, 0.5), t[0], 32),
+          formatTime(percentile(recorded, n_recorded, 0.9), t[1], 32), formatTime(percentile(recorded, n_recorded, 0.99), t[2], 32),
+          formatTime(percentile(replayed, n_replayed, 0.5), t[3], 32), formatTime(percentile(replayed, n_replayed, 0.9), t[4], 32),
+          formatTime(percentile(replayed, n_replayed, 0.99), t[5], 32));
+  if(n_recorded > 0 && n_replayed > 0 && percentile(recorded, n_recorded, 0.5) > 0) {
+    fprintf(stderr, " %+8.1f%%", 100.0 * ((double) percentile(replayed, n_replayed, 0.5) / percentile(recorded, n_recorded, 0.5) - 1));
+  }
+  fprintf(stderr, "\n");
+}
+
+//Runs the lines of a recording again and compares their times
+int replaySession(char *path, double speed, int stubs) {
+  char *command_token[MAX_NUM_TOKENS];
+  Command command[MAX_NUM_COMMANDS];
+  char input[STR_SIZE];
+  char dir[PATH_MAX];
+  char *prompt = "%";
+  char new_prompt[STR_SIZE];
+  char scratch[] = "/tmp/myshell-replay-XXXXXX";
+  NameTimes names[MAX_REPLAY_NAMES];
+  int n_names = 0;
+  int n_lines;
+  int differ = 0; //lines whose status is not the recorded one
+
+  SessionLine *lines = readSession(path, &n_lines);
+  if(lines == NULL) {
+    return 1;
+  }
+  if(mkdtemp(scratch) == NULL) {
+    perror("mkdtemp");
+    return 1;
+  }
+  for(int i = 0; i < n_lines; i++) {
+    for(int j = 0; j < lines[i].n_commands; j++) {
+      NameTimes *nt = nameTimes(names, &n_names, lines[i].commands[j].name);
+      if(nt != NULL) {
+        nt->recorded_ns += lines[i].commands[j].wall_ns;
+        nt->recorded++;
+        nt->failed += lines[i].commands[j].status != 0;
+      }
+    }
+  }
+  //Every recorded directory exists from the start, a line like "cd proj" moves into the one of the next line
+  for(int i = 0; i < n_lines; i++) {
+    if(lines[i].cwd != NULL) {
+      snprintf(dir, sizeof(dir), "%s%s", scratch, lines[i].cwd);
+      makeDirs(dir);
+    }
+  }
+  if(stubs) {
+    makeStubs(scratch, lines, n_lines, names, n_names);
+  }
+  if(chdir(scratch) != 0) {
+    perror(scratch);
+    return 1;
+  }
+
+  LinePhases *replayed = (LinePhases *) calloc(n_lines + 1, sizeof(LinePhases));
+  int n_replayed = 0;
+  active = 1;
+  uint64_t start = metricsNow();
+  for(int i = 0; i < n_lines; i++) {
+    SessionLine *sl = &(lines[i]);
+    //Keep the spacing of the lines in time, divided by the speed
+    if(speed > 0) {
+      uint64_t due = start + (uint64_t) (sl->offset_ns / speed);
+      uint64_t now = metricsNow();
+      if(due > now) {
+        struct timespec ts = {(due - now) / 1000000000, (due - now) % 1000000000};
+        while(nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+        }
+      }
+    }
+    if(sl->cwd != NULL) {
+      snprintf(dir, sizeof(dir), "%s%s", scratch, sl->cwd);
+      if(chdir(dir) != 0) {
+        perror(dir);
+      }
+    }
+    for(int j = 0; sl->env[j] != NULL; j++) {
+      if(stubs && strncmp(sl->env[j], "PATH", 4) == 0 && (sl->env[j][4] == '=' || sl->env[j][4] == '\0')) {
+        continue; //PATH holds the stubs
+      }
+      if(strchr(sl->env[j], '=') != NULL) {
+        putenv(strdup(sl->env[j]));
+      }
+      else {
+        unsetenv(sl->env[j]);
+      }
+    }
+    if(strcmp(sl->line, "exit") == 0) {
+      break;
+    }
+
+    snprintf(input, sizeof(input), "%s", sl->line);
+    beginLine(input);
+    int n_commands = parseCommand(input, command_token, command);
+    runCommands(command_token, command, n_commands, &prompt, new_prompt);
+    endLine();
+    replayed[n_replayed] = last_phases;
+    differ += last_phases.status != sl->phases.status;
+    n_replayed++;
+    int n = __atomic_load_n(&n_line_commands, __ATOMIC_RELAXED);
+    for(int j = 0; j < n && j < MAX_SESSION_COMMANDS; j++) {
+      NameTimes *nt = nameTimes(names, &n_names, line_commands[j].name);
+      if(nt != NULL) {
+        nt->replayed_ns += line_commands[j].wall_ns;
+        nt->replayed++;
+      }
+    }
+  }
+
+  //Percentiles of each phase over the lines, the spawn time per command
+  uint64_t *a = (uint64_t *) calloc(n_lines + 1, sizeof(uint64_t));
+  uint64_t *b = (uint64_t *) calloc(n_lines + 1, sizeof(uint64_t));
+  int na, nb;
+  fprintf(stderr, "replay: %d of %d lines in %s, %s, %d with another status\n", n_replayed, n_lines, scratch, stubs ? "stub commands" : "real commands", differ);
+  fprintf(stderr, "%-8s %9s %9s %9s   %9s %9s %9s\n", "", "recorded", "p90", "p99", "replayed", "p90", "p99");
+  na = nb = 0;
+  for(int i = 0; i < n_replayed; i++) {
+    a[na++] = lines[i].phases.parse_ns;
+    b[nb++] = replayed[i].parse_ns;
+  }
+  printPhase("parse", a, na, b, nb);
+  na = nb = 0;
+  for(int i = 0; i < n_replayed; i++) {
+    if(lines[i].phases.spawns > 0) {
+      a[na++] = lines[i].phases.spawn_ns / lines[i].phases.spawns;
+    }
+    if(replayed[i].spawns > 0) {
+      b[nb++] = replayed[i].spawn_ns / replayed[i].spawns;
+    }
+  }
+  printPhase("spawn", a, na, b, nb);
+  na = nb = 0;
+  for(int i = 0; i < n_replayed; i++) {
+    a[na++] = lines[i].phases.wait_ns;
+    b[nb++] = replayed[i].wait_ns;
+  }
+  printPhase("wait", a, na, b, nb);
+  na = nb = 0;
+  for(int i = 0; i < n_replayed; i++) {
+    a[na++] = lines[i].phases.wall_ns;
+    b[nb++] = replayed[i].wall_ns;
+  }
+  printPhase("line", a, na, b, nb);
+
+  fprintf(stderr, "\n%-20s %8s %13s %13s\n", "command", "count", "recorded mean", "replayed mean");
+  for(int i = 0; i < n_names; i++) {
+    char t[2][32];
+    fprintf(stderr, "%-20s %8lu %13s %13s\n", names[i].name, (unsigned long) names[i].recorded,
+            names[i].recorded > 0 ? formatTime(names[i].recorded_ns / names[i].recorded, t[0], 32) : "-",
+            names[i].replayed > 0 ? formatTime(names[i].replayed_ns / names[i].replayed, t[1], 32) : "-");
+  }
+  free(a);
+  free(b);
+  free(replayed);
+
+  return 0;
+}
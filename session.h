@@ -0,0 +1,56 @@
+/*
+ * File:	session.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Record the command lines of a session of the shell with how
+		long each took, and replay them later to compare the times.
+
+   Return:	1) startRecording() returns 0, or -1 if the file cannot be
+		   written.
+		2) replaySession() returns 0, or 1 if the file cannot be
+		   read.
+
+   Note:	1) With --record file, the shell writes for every line
+		   accepted by getInput() the time it was accepted since the
+		   session started, the current directory and the changes
+		   to the environment when they change, the line, the time
+		   spent parsing it, spawning its commands and waiting for
+		   them, its wall time and status, and the wall time and
+		   status of each command the shell waited for.
+		2) The file starts with SESSION_MAGIC, SESSION_VERSION,
+		   the time of day the session started and its whole
+		   environment. Then comes one record per line: its type,
+		   its length and its fields. Numbers are written as
+		   variable-length integers of 7 bits per byte, and strings
+		   as their length and their bytes. Each record is flushed
+		   as soon as its line is done.
+		3) With --replay file, the shell runs the lines again in a
+		   new scratch directory, in the subdirectory named like the
+		   directory each line was recorded in, with the same
+		   changes to the environment. The lines keep their
+		   recorded spacing in time, divided by --speed N, or run
+		   one after the other with --max. With --stubs, every
+		   command found in the recording is replaced by a link to
+		   true, or to false if it mostly failed, and PATH holds
+		   only those. It then prints to stderr the 50th, 90th and
+		   99th percentiles of each phase of the recorded and the
+		   replayed lines, and the mean wall time of each command.
+		4) The times come from the differences of metricsTotals()
+		   around a line, so they include the subshells of the
+		   line. The commands of a line are the ones recordExit()
+		   sees in the shell itself, which records them with
+		   recordSessionCommand(), also from the SIGCHLD handler.
+*/
+
+#define SESSION_MAGIC "MYSHREC"
+#define SESSION_VERSION 1
+#define SESSION_LINE 1 //type of the record of a line
+#define MAX_SESSION_COMMANDS 256 //commands kept for one line
+
+int startRecording(char *path);
+void beginLine(char *line);
+void endLine();
+void recordSessionCommand(char *name, uint64_t wall_ns, int status);
+int replaySession(char *path, double speed, int stubs);
@@ -0,0 +1,183 @@
+/*
+ * File:	snapshot.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "snapshot.h"
+#include "pathcache.h"
+
+struct SnapshotHeaderStruct {
+  char magic[8];
+  uint32_t version;
+  uint32_t n_sections;
+  uint64_t size; //of the whole file
+  uint64_t checksum; //of everything after the header
+};
+
+typedef struct SnapshotHeaderStruct SnapshotHeader;
+
+struct SnapshotSectionStruct {
+  uint32_t id;
+  uint32_t unused;
+  uint64_t offset; //from the start of the file, a multiple of 8
+  uint64_t size;
+};
+
+typedef struct SnapshotSectionStruct SnapshotSection;
+
+static char *map = NULL; //the snapshot, mapped read-only
+static size_t map_size = 0;
+static int checked = 0; //1 if the checksum is right, -1 if not, 0 if not verified yet
+static char *snapshot_path = NULL;
+static pid_t owner_pid = 0; //the shell, as opposed to its children
+
+//Returns the FNV-1a hash of n bytes
+static uint64_t checksum(char *data, size_t n) {
+  uint64_t h = 14695981039346656037ull;
+
+  for(size_t i = 0; i < n; i++) {
+    h = (h ^ (unsigned char) data[i]) * 1099511628211ull;
+  }
+
+  return h;
+}
+
+//Returns the start of the section id of the snapshot
+void *snapshotSection(uint32_t id, size_t *size) {
+  if(map == NULL) {
+    return NULL;
+  }
+  SnapshotHeader *header = (SnapshotHeader *) map;
+  if(checked == 0) {
+    checked = checksum(map + sizeof(SnapshotHeader), map_size - sizeof(SnapshotHeader)) == header->checksum ? 1 : -1;
+  }
+  if(checked < 0) {
+    return NULL;
+  }
+
+  SnapshotSection *section = (SnapshotSection *) (map + sizeof(SnapshotHeader));
+  for(uint32_t i = 0; i < header->n_sections; i++) {
+    if(section[i].id == id && section[i].offset % 8 == 0 && section[i].offset <= map_size && section[i].size <= map_size - section[i].offset) {
+      *size = section[i].size;
+      return map + section[i].offset;
+    }
+  }
+
+  return NULL;
+}
+
+//Writes the sections to a temporary file and renames it over path
+int writeSnapshot(char *path, SnapshotPart parts[], int n_parts) {
+  char tmp[4096];
+  size_t size = sizeof(SnapshotHeader) + n_parts * sizeof(SnapshotSection);
+
+  //Lay the sections out one after the other, each on a multiple of 8
+  SnapshotSection section[MAX_SNAPSHOT_SECTIONS];
+  for(int i = 0; i < n_parts; i++) {
+    section[i].id = parts[i].id;
+    section[i].unused = 0;
+    section[i].offset = (size + 7) & ~(size_t) 7;
+    section[i].size = parts[i].size;
+    size = section[i].offset + parts[i].size;
+  }
+  size = (size + 7) & ~(size_t) 7;
+
+  char *data = (char *) calloc(1, size);
+  if(data == NULL) {
+    return -1;
+  }
+  SnapshotHeader *header = (SnapshotHeader *) data;
+  memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+  header->version = SNAPSHOT_VERSION;
+  header->n_sections = n_parts;
+  header->size = size;
+  memcpy(data + sizeof(SnapshotHeader), section, n_parts * sizeof(SnapshotSection));
+  for(int i = 0; i < n_parts; i++) {
+    memcpy(data + section[i].offset, parts[i].data, parts[i].size);
+  }
+  header->checksum = checksum(data + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader));
+
+  snprintf(tmp, sizeof(tmp), "%s.%d", path, (int) getpid());
+  int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0) {
+    free(data);
+    return -1;
+  }
+  size_t done = 0;
+  while(done < size) {
+    ssize_t n = write(fd, data + done, size - done);
+    if(n <= 0) {
+      break;
+    }
+    done += n;
+  }
+  free(data);
+  if(close(fd) != 0 || done < size || rename(tmp, path) != 0) {
+    unlink(tmp);
+    return -1;
+  }
+
+  return 0;
+}
+
+//Writes the snapshot again if a section has changed
+void saveSnapshot() {
+  SnapshotPart parts[1];
+  size_t size;
+
+  if(getpid() != owner_pid) {
+    return;
+  }
+  void *index = buildPathSnapshot(&size);
+  if(index == NULL) {
+    return; //nothing new since the snapshot was taken
+  }
+  parts[0].id = SNAPSHOT_PATH_INDEX;
+  parts[0].data = index;
+  parts[0].size = size;
+  writeSnapshot(snapshot_path, parts, 1);
+  free(index);
+}
+
+//Maps the snapshot at path and writes it there when the shell exits
+void openSnapshot(char *path) {
+  struct stat buf;
+
+  snapshot_path = path;
+  owner_pid = getpid();
+  atexit(saveSnapshot);
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    return; //the first run, the snapshot is written at exit
+  }
+  if(fstat(fd, &buf) == 0 && buf.st_size >= (off_t) sizeof(SnapshotHeader)) {
+    map = (char *) mmap(NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED) {
+      map = NULL;
+    }
+    map_size = buf.st_size;
+  }
+  close(fd);
+
+  //Only the header is read now, the checksum is verified on first use
+  if(map != NULL) {
+    SnapshotHeader *header = (SnapshotHeader *) map;
+    if(memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION
+       || header->size != map_size || header->n_sections > MAX_SNAPSHOT_SECTIONS
+       || sizeof(SnapshotHeader) + header->n_sections * sizeof(SnapshotSection) > map_size) {
+      munmap(map, map_size);
+      map = NULL;
+    }
+  }
+}
@@ -0,0 +1,56 @@
+/*
+ * File:	snapshot.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Keep the indexes the shell builds, like the PATH lookup
+		cache, in a snapshot file from one run of the shell to the
+		next, so that a new shell starts with them already built.
+
+   Return:	1) snapshotSection() returns the start of the section "id"
+		   of the snapshot and stores its size in "size", or returns
+		   NULL if there is no such section or the snapshot is not
+		   valid.
+		2) writeSnapshot() returns 0, or -1 if the file cannot be
+		   written.
+
+   Note:	1) The file starts with a header holding SNAPSHOT_MAGIC,
+		   SNAPSHOT_VERSION, the size of the file, a checksum of
+		   the rest of it and a table of sections. A file with
+		   another magic, version or size is ignored.
+		2) openSnapshot() maps the file read-only and only reads
+		   its header, so it costs an open() and an mmap() at
+		   startup. The checksum is verified when a section is
+		   first asked for. The sections are laid out to be used
+		   in place, with offsets instead of pointers, and are
+		   never copied into memory.
+		3) Whoever owns a section checks that it still holds, e.g.
+		   the PATH lookup cache compares the modification times
+		   of the PATH directories, when it first needs it.
+		4) When the shell exits, the snapshot is written again if
+		   a section has changed, to a temporary file renamed over
+		   the old one, so that a shell starting meanwhile sees
+		   either one or the other. The children of the shell do
+		   not write it. The shell server, which does not exit,
+		   calls saveSnapshot() once it has warmed its caches.
+*/
+
+#define SNAPSHOT_MAGIC "MYSHSNAP"
+#define SNAPSHOT_VERSION 1
+#define MAX_SNAPSHOT_SECTIONS 16
+
+#define SNAPSHOT_PATH_INDEX 1 //section of the PATH lookup cache
+
+struct SnapshotPartStruct {
+  uint32_t id;
+  void *data;
+  size_t size;
+};
+
+typedef struct SnapshotPartStruct SnapshotPart; //a section to write
+
+void openSnapshot(char *path);
+void saveSnapshot();
+void *snapshotSection(uint32_t id, size_t *size);
+int writeSnapshot(char *path, SnapshotPart parts[], int n_parts);
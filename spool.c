@@ -0,0 +1,332 @@
+/*
+ * File:	spool.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/types.h>
+#include "command.h"
+#include "job.h"
+#include "spool.h"
+
+//The output of a background job
+//Bytes are numbered from 0 in the order the job wrote them: the memfd holds
+//[0, spilled), the ring holds [ring_start, total), and the bytes in between
+//were dropped
+struct SpoolStruct {
+  int id; //job number, 0 if the slot is unused
+  int fd; //read end of the pipe, -1 once the job has closed its output
+  char *ring; //SPOOL_RING_SIZE bytes, byte n at ring[n % SPOOL_RING_SIZE]
+  uint64_t ring_start;
+  uint64_t total;
+  int memfd; //-1 until the ring first overflows
+  uint64_t spilled;
+};
+
+typedef struct SpoolStruct Spool;
+
+static Spool spools[MAX_NUM_JOBS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int wake_fds[2] = {-1, -1}; //tells the thread about a new pipe
+static int more_fds[2] = {-1, -1}; //tells jobout -f that a job wrote or closed its output
+static int started = 0;
+static pid_t owner_pid = 0; //the shell, 0 if spooling is off
+
+//Copies n bytes from byte number pos of the ring to buf
+static void copyFromRing(Spool *s, uint64_t pos, char *buf, size_t n) {
+  size_t at = pos % SPOOL_RING_SIZE;
+  size_t first = n < SPOOL_RING_SIZE - at ? n : SPOOL_RING_SIZE - at;
+
+  memcpy(buf, s->ring + at, first);
+  memcpy(buf + first, s->ring, n - first);
+}
+
+//Adds n bytes, at most SPOOL_RING_SIZE, to the ring, moving the oldest ones to
+//the memfd or dropping them to make room
+static void appendToSpool(Spool *s, char *data, size_t n) {
+  uint64_t used = s->total - s->ring_start;
+
+  if(used + n > SPOOL_RING_SIZE) {
+    size_t evict = used + n - SPOOL_RING_SIZE;
+    //Spill while nothing has been dropped, so that the memfd has no gaps
+    if(s->spilled == s->ring_start && s->spilled + evict <= SPOOL_SPILL_MAX) {
+      if(s->memfd < 0) {
+        s->memfd = memfd_create("jobout", MFD_CLOEXEC);
+      }
+      size_t at = s->ring_start % SPOOL_RING_SIZE;
+      size_t first = evict < SPOOL_RING_SIZE - at ? evict : SPOOL_RING_SIZE - at;
+      if(s->memfd >= 0 && pwrite(s->memfd, s->ring + at, first, s->spilled) == (ssize_t) first
+         && pwrite(s->memfd, s->ring, evict - first, s->spilled + first) == (ssize_t) (evict - first)) {
+        s->spilled += evict;
+      }
+    }
+    s->ring_start += evict;
+  }
+  size_t at = s->total % SPOOL_RING_SIZE;
+  size_t first = n < SPOOL_RING_SIZE - at ? n : SPOOL_RING_SIZE - at;
+  memcpy(s->ring + at, data, first);
+  memcpy(s->ring, data + first, n - first);
+  s->total += n;
+}
+
+//Reads the pipes of the jobs as soon as they have something
+static void *spoolThread(void *arg) {
+  struct pollfd fds[MAX_NUM_JOBS + 1];
+  int slot[MAX_NUM_JOBS + 1];
+  char *buf = (char *) malloc(SPOOL_RING_SIZE);
+
+  if(buf == NULL) {
+    return NULL;
+  }
+  while(1) {
+    int n = 0;
+    fds[n].fd = wake_fds[0];
+    fds[n].events = POLLIN;
+    n++;
+    pthread_mutex_lock(&lock);
+    for(int i = 0; i < MAX_NUM_JOBS; i++) {
+      if(spools[i].id != 0 && spools[i].fd >= 0) {
+        fds[n].fd = spools[i].fd;
+        fds[n].events = POLLIN;
+        slot[n] = i;
+        n++;
+      }
+    }
+    pthread_mutex_unlock(&lock);
+
+    if(poll(fds, n, -1) < 0) {
+      continue;
+    }
+    if(fds[0].revents != 0) {
+      while(read(wake_fds[0], buf, SPOOL_RING_SIZE) > 0) {
+      }
+    }
+    for(int i = 1; i < n; i++) {
+      if(fds[i].revents == 0) {
+        continue;
+      }
+      //Only this thread closes the pipes, so the slot is still the same job
+      ssize_t len = read(fds[i].fd, buf, SPOOL_RING_SIZE);
+      if(len < 0 && (errno == EAGAIN || errno == EINTR)) {
+        continue;
+      }
+      pthread_mutex_lock(&lock);
+      Spool *s = &(spools[slot[i]]);
+      if(len > 0) {
+        appendToSpool(s, buf, len);
+      }
+      else {
+        close(s->fd);
+        s->fd = -1;
+      }
+      pthread_mutex_unlock(&lock);
+      write(more_fds[1], "", 1); //a full pipe already wakes it
+    }
+  }
+
+  return NULL;
+}
+
+//Turns spooling on for the background jobs of this process
+void startSpool() {
+  owner_pid = getpid();
+}
+
+//Makes the pipe for the output of a background job about to be forked
+int spoolPipe(int fds[2]) {
+  sigset_t all;
+  sigset_t old;
+  pthread_t thread;
+
+  if(owner_pid == 0 || getpid() != owner_pid) {
+    return -1;
+  }
+  if(!started) {
+    if(pipe2(wake_fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+      return -1;
+    }
+    if(pipe2(more_fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+      close(wake_fds[0]);
+      close(wake_fds[1]);
+      return -1;
+    }
+    for(int i = 0; i < MAX_NUM_JOBS; i++) {
+      spools[i].fd = -1;
+      spools[i].memfd = -1;
+    }
+    //The thread takes no signal, they are for the shell
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    if(pthread_create(&thread, NULL, spoolThread, NULL) == 0) {
+      pthread_detach(thread);
+      started = 1;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if(!started) {
+      close(wake_fds[0]);
+      close(wake_fds[1]);
+      close(more_fds[0]);
+      close(more_fds[1]);
+      return -1;
+    }
+  }
+  if(pipe2(fds, O_CLOEXEC) < 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+//Points the standard output and standard error of the child at the pipe
+void spoolChild(int fds[2]) {
+  dup2(fds[1], STDOUT_FILENO);
+  dup2(fds[1], STDERR_FILENO);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+//Hands the read end of the pipe of job id to the thread
+void spoolJob(int id, int fds[2]) {
+  Spool *s = NULL;
+
+  close(fds[1]);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  pthread_mutex_lock(&lock);
+  for(int i = 0; i < MAX_NUM_JOBS && s == NULL; i++) {
+    if(spools[i].id == 0) {
+      s = &(spools[i]);
+    }
+  }
+  //Else reuse the oldest job that has closed its output
+  for(int i = 0; i < MAX_NUM_JOBS && (s == NULL || s->id != 0); i++) {
+    if(spools[i].fd < 0 && (s == NULL || spools[i].id < s->id)) {
+      s = &(spools[i]);
+    }
+  }
+  if(id < 0 || s == NULL) {
+    pthread_mutex_unlock(&lock);
+    close(fds[0]); //the job gets EPIPE
+    return;
+  }
+  if(s->memfd >= 0) {
+    close(s->memfd);
+  }
+  if(s->ring == NULL) {
+    s->ring = (char *) malloc(SPOOL_RING_SIZE);
+  }
+  s->id = id;
+  s->fd = fds[0];
+  s->ring_start = 0;
+  s->total = 0;
+  s->memfd = -1;
+  s->spilled = 0;
+  pthread_mutex_unlock(&lock);
+  write(wake_fds[1], "", 1);
+}
+
+//Prints what job id has written so far, and with follow what it writes until it closes its output
+int printJobOutput(int id, int follow) {
+  Spool *s = NULL;
+  char buf[8192];
+  uint64_t pos = 0;
+  sigset_t sigint;
+  struct signalfd_siginfo si;
+  int sfd = -1;
+
+  if(!started || id <= 0) {
+    return -1;
+  }
+  pthread_mutex_lock(&lock);
+  for(int i = 0; i < MAX_NUM_JOBS && s == NULL; i++) {
+    if(spools[i].id == id) {
+      s = &(spools[i]);
+    }
+  }
+  if(s == NULL) {
+    pthread_mutex_unlock(&lock);
+    return -1;
+  }
+  //SIGINT is blocked in the shell, so Ctrl-C ends -f through a signalfd
+  //Ctrl-C pressed before jobout started is thrown away first
+  if(follow) {
+    sigemptyset(&sigint);
+    sigaddset(&sigint, SIGINT);
+    if((sfd = signalfd(-1, &sigint, SFD_NONBLOCK | SFD_CLOEXEC)) < 0) {
+      perror("signalfd");
+      follow = 0;
+    }
+    while(sfd >= 0 && read(sfd, &si, sizeof(si)) > 0) {
+    }
+  }
+  //Slots are only reused by spoolJob(), which the shell runs like this
+  //function, so s stays this job while unlocked
+  while(1) {
+    while(follow && pos == s->total && s->fd >= 0) {
+      pthread_mutex_unlock(&lock);
+      struct pollfd fds[2] = {{sfd, POLLIN, 0}, {more_fds[0], POLLIN, 0}};
+      int n = poll(fds, 2, -1);
+      if(n > 0 && (fds[0].revents & POLLIN)) {
+        read(sfd, &si, sizeof(si));
+        close(sfd);
+        fflush(stdout);
+        lastStatus = 128 + SIGINT; //ended by Ctrl-C like a foreground command
+        return 0;
+      }
+      if(n > 0) {
+        while(read(more_fds[0], buf, sizeof(buf)) > 0) {
+        }
+      }
+      pthread_mutex_lock(&lock);
+    }
+    if(pos == s->total) {
+      break;
+    }
+    if(pos < s->spilled) {
+      //The memfd only grows, it can be read unlocked
+      size_t len = s->spilled - pos < sizeof(buf) ? s->spilled - pos : sizeof(buf);
+      int memfd = s->memfd;
+      pthread_mutex_unlock(&lock);
+      ssize_t n = pread(memfd, buf, len, pos);
+      if(n > 0) {
+        fwrite(buf, 1, n, stdout);
+      }
+      pos += n > 0 ? (uint64_t) n : len;
+    }
+    else if(pos < s->ring_start) {
+      uint64_t dropped = s->ring_start - pos;
+      pos = s->ring_start;
+      pthread_mutex_unlock(&lock);
+      fflush(stdout);
+      printf("[jobout: %lu bytes dropped]\n", (unsigned long) dropped);
+    }
+    else {
+      size_t len = s->total - pos < sizeof(buf) ? s->total - pos : sizeof(buf);
+      copyFromRing(s, pos, buf, len);
+      pthread_mutex_unlock(&lock);
+      fwrite(buf, 1, len, stdout);
+      pos += len;
+    }
+    fflush(stdout);
+    pthread_mutex_lock(&lock);
+  }
+  pthread_mutex_unlock(&lock);
+  fflush(stdout);
+  if(sfd >= 0) {
+    close(sfd);
+  }
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * File:	spool.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	With --spool-jobs, give each background job a pipe for its
+		standard output and standard error instead of the terminal,
+		keep what it writes in memory, and show it with the built-in
+		command "jobout %n [-f]".
+
+   Return:	1) spoolPipe() returns 0 with the pipe in fds, or -1 if the
+		   job writes to the terminal as before.
+		2) printJobOutput() returns 0, or -1 if the job has no
+		   spooled output.
+
+   Note:	1) The pipes are read by one background thread of the
+		   shell, whatever the shell is doing, so a job that writes
+		   a lot never waits for a slow terminal or for the prompt.
+		2) The last SPOOL_RING_SIZE bytes of a job are kept in a
+		   ring buffer. Older bytes are moved to a memfd, until it
+		   holds SPOOL_SPILL_MAX bytes, after which the oldest bytes
+		   of the ring are dropped, and jobout says how many.
+		3) "jobout %n -f" prints what job n has written so far,
+		   then what it writes until it closes its output or
+		   SIGINT arrives, read from a signalfd like onchange does.
+		   The thread writes to a pipe polled by jobout whenever a
+		   job writes or closes its output.
+		4) Only the shell process itself spools, not its subshells,
+		   which must not touch the lock of a thread they do not
+		   have. The output of up to MAX_NUM_JOBS jobs is kept; the
+		   oldest job that has closed its output makes room.
+*/
+
+#define SPOOL_RING_SIZE (64 * 1024) //bytes of a job kept in memory
+#define SPOOL_SPILL_MAX (16 * 1024 * 1024) //bytes of a job kept in its memfd
+
+void startSpool();
+int spoolPipe(int fds[2]);
+void spoolChild(int fds[2]);
+void spoolJob(int id, int fds[2]);
+int printJobOutput(int id, int follow);
@@ -0,0 +1,1000 @@
+/*
+ * File:	textfilter.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "textfilter.h"
+
+//Kinds of filters
+#define FILTER_GREP 0
+#define FILTER_HEAD 1
+#define FILTER_WC 2
+#define FILTER_CUT 3
+
+//A filter and its options, as parsed from its argv
+struct FilterStruct {
+  int kind; //FILTER_GREP, FILTER_HEAD, FILTER_WC or FILTER_CUT
+  int invert; //grep -v
+  int count; //grep -c
+  int number; //grep -n
+  char *pattern; //grep
+  size_t pattern_len;
+  int lines; //head: 1 for -n, 0 for -c
+  uint64_t n; //head: lines or bytes to print
+  int print_lines; //wc -l
+  int print_bytes; //wc -c
+  char delim; //cut -d
+  int only_delimited; //cut -s
+  char *field_list; //cut -f
+  unsigned char *fields; //cut: fields[i] is 1 if field i + 1 is selected
+  int n_fields;
+  int from; //cut: every field from this one on is selected, 0 if none
+  char **files; //operands, NULL-terminated
+  int n_files;
+};
+
+typedef struct FilterStruct Filter;
+
+//An input of a filter
+struct InputStruct {
+  int fd;
+  char *name; //as shown in messages
+  char *buf;
+  size_t size;
+  size_t len; //bytes in buf
+  size_t used; //bytes of buf already handed out
+  int eof;
+  int error; //errno of a failed read, 0 if none
+};
+
+typedef struct InputStruct Input;
+
+static char out_buf[FILTER_OUT_SIZE];
+static size_t out_len = 0;
+
+//Scanning functions, chosen for the CPU by initScanning()
+static char *(*findByte)(char *p, char *end, int c); //first c in [p, end), or NULL
+static uint64_t (*countByte)(char *p, char *end, int c); //number of c in [p, end)
+static char *(*findEither)(char *p, char *end, int a, int b); //first a or b in [p, end), or NULL
+static char *(*findString)(char *p, char *end, char *s, size_t n); //first s of length n > 1 in [p, end), or NULL
+
+//Plain C versions, also used for the bytes after the last whole block
+
+static char *findByteScalar(char *p, char *end, int c) {
+  for(; p < end; p++) {
+    if(*p == (char) c) {
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+static uint64_t countByteScalar(char *p, char *end, int c) {
+  uint64_t count = 0;
+
+  for(; p < end; p++) {
+    count += *p == (char) c;
+  }
+
+  return count;
+}
+
+static char *findEitherScalar(char *p, char *end, int a, int b) {
+  for(; p < end; p++) {
+    if(*p == (char) a || *p == (char) b) {
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+static char *findStringScalar(char *p, char *end, char *s, size_t n) {
+  return p < end ? (char *) memmem(p, end - p, s, n) : NULL;
+}
+
+#if defined(__x86_64__)
+//SSE2 versions, every x86-64 processor has it
+
+static char *findByteSse2(char *p, char *end, int c) {
+  __m128i v = _mm_set1_epi8((char) c);
+
+  for(; end - p >= 16; p += 16) {
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) p), v));
+    if(mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findByteScalar(p, end, c);
+}
+
+//A matching byte is -1, subtracting it adds 1 to its lane, summed every 255 blocks before a lane can overflow
+static uint64_t countByteSse2(char *p, char *end, int c) {
+  __m128i v = _mm_set1_epi8((char) c);
+  uint64_t count = 0;
+
+  while(end - p >= 16) {
+    __m128i acc = _mm_setzero_si128();
+    for(int i = 0; i < 255 && end - p >= 16; i++, p += 16) {
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) p), v));
+    }
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    count += _mm_cvtsi128_si64(sums) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+  }
+
+  return count + countByteScalar(p, end, c);
+}
+
+static char *findEitherSse2(char *p, char *end, int a, int b) {
+  __m128i va = _mm_set1_epi8((char) a);
+  __m128i vb = _mm_set1_epi8((char) b);
+
+  for(; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((__m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb)));
+    if(mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findEitherScalar(p, end, a, b);
+}
+
+//Positions where both the first and the last byte of s match are checked with memcmp()
+static char *findStringSse2(char *p, char *end, char *s, size_t n) {
+  __m128i first = _mm_set1_epi8(s[0]);
+  __m128i last = _mm_set1_epi8(s[n - 1]);
+
+  for(; end - p >= (ptrdiff_t) (n - 1 + 16); p += 16) {
+    __m128i eq_first = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) p), first);
+    __m128i eq_last = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) (p + n - 1)), last);
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+    while(mask != 0) {
+      int i = __builtin_ctz(mask);
+      if(memcmp(p + i + 1, s + 1, n - 2) == 0) {
+        return p + i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return findStringScalar(p, end, s, n);
+}
+
+//AVX2 versions, the same 32 bytes at a time
+
+__attribute__((target("avx2")))
+static char *findByteAvx2(char *p, char *end, int c) {
+  __m256i v = _mm256_set1_epi8((char) c);
+
+  for(; end - p >= 32; p += 32) {
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) p), v));
+    if(mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findByteSse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+static uint64_t countByteAvx2(char *p, char *end, int c) {
+  __m256i v = _mm256_set1_epi8((char) c);
+  uint64_t count = 0;
+
+  while(end - p >= 32) {
+    __m256i acc = _mm256_setzero_si256();
+    for(int i = 0; i < 255 && end - p >= 32; i++, p += 32) {
+      acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) p), v));
+    }
+    __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+    count += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+  }
+
+  return count + countByteSse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+static char *findEitherAvx2(char *p, char *end, int a, int b) {
+  __m256i va = _mm256_set1_epi8((char) a);
+  __m256i vb = _mm256_set1_epi8((char) b);
+
+  for(; end - p >= 32; p += 32) {
+    __m256i block = _mm256_loadu_si256((__m256i *) p);
+    unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, va), _mm256_cmpeq_epi8(block, vb)));
+    if(mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findEitherSse2(p, end, a, b);
+}
+
+__attribute__((target("avx2")))
+static char *findStringAvx2(char *p, char *end, char *s, size_t n) {
+  __m256i first = _mm256_set1_epi8(s[0]);
+  __m256i last = _mm256_set1_epi8(s[n - 1]);
+
+  for(; end - p >= (ptrdiff_t) (n - 1 + 32); p += 32) {
+    __m256i eq_first = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) p), first);
+    __m256i eq_last = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) (p + n - 1)), last);
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+    while(mask != 0) {
+      int i = __builtin_ctz(mask);
+      if(memcmp(p + i + 1, s + 1, n - 2) == 0) {
+        return p + i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return findStringSse2(p, end, s, n);
+}
+#endif
+
+//Chooses the scanning functions for the CPU
+static void initScanning() {
+  findByte = findByteScalar;
+  countByte = countByteScalar;
+  findEither = findEitherScalar;
+  findString = findStringScalar;
+#if defined(__x86_64__)
+  findByte = findByteSse2;
+  countByte = countByteSse2;
+  findEither = findEitherSse2;
+  findString = findStringSse2;
+  if(__builtin_cpu_supports("avx2")) {
+    findByte = findByteAvx2;
+    countByte = countByteAvx2;
+    findEither = findEitherAvx2;
+    findString = findStringAvx2;
+  }
+#endif
+}
+
+//Writes the buffered output
+static void flushOutput() {
+  size_t done = 0;
+
+  while(done < out_len) {
+    ssize_t n = write(STDOUT_FILENO, out_buf + done, out_len - done);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n < 0) {
+      exit(1); //the reader has gone
+    }
+    done += n;
+  }
+  out_len = 0;
+}
+
+//Adds n bytes to the output
+static void putOutput(char *p, size_t n) {
+  if(out_len + n > FILTER_OUT_SIZE) {
+    flushOutput();
+  }
+  if(n > FILTER_OUT_SIZE) {
+    memcpy(out_buf, p, FILTER_OUT_SIZE); //written in pieces of the buffer size
+    out_len = FILTER_OUT_SIZE;
+    flushOutput();
+    putOutput(p + FILTER_OUT_SIZE, n - FILTER_OUT_SIZE);
+    return;
+  }
+  memcpy(out_buf + out_len, p, n);
+  out_len += n;
+}
+
+//Adds a string to the output
+static void putString(char *s) {
+  putOutput(s, strlen(s));
+}
+
+//Adds a number to the output
+static void putNumber(uint64_t n) {
+  char buf[32];
+
+  putOutput(buf, snprintf(buf, sizeof(buf), "%lu", (unsigned long) n));
+}
+
+//Opens an operand, "-" or NULL for the standard input, returns -1 if it cannot be opened
+static int openInput(Input *in, char *file, char *stdin_name) {
+  in->len = 0;
+  in->used = 0;
+  in->eof = 0;
+  in->error = 0;
+  if(file == NULL || strcmp(file, "-") == 0) {
+    in->fd = STDIN_FILENO;
+    in->name = stdin_name;
+    return 0;
+  }
+  in->name = file;
+  in->fd = open(file, O_RDONLY);
+
+  return in->fd;
+}
+
+//Closes an input unless it is the standard input
+static void closeInput(Input *in) {
+  if(in->fd != STDIN_FILENO) {
+    close(in->fd);
+  }
+}
+
+//Reads the next block of the input into in->buf, returns its length, 0 at the end
+static size_t readBlock(Input *in) {
+  ssize_t n;
+
+  if(in->eof) {
+    return 0;
+  }
+  while((n = read(in->fd, in->buf, in->size)) < 0 && errno == EINTR) {
+  }
+  if(n <= 0) {
+    in->error = n < 0 ? errno : 0;
+    in->eof = 1;
+    return 0;
+  }
+
+  return n;
+}
+
+//Reads whole lines into in->buf, returns their length, 0 at the end
+//At the end, a last line without a newline is given one
+static size_t readLines(Input *in) {
+  memmove(in->buf, in->buf + in->used, in->len - in->used);
+  in->len -= in->used;
+  in->used = 0;
+  while(1) {
+    if(in->eof) {
+      if(in->len > 0 && in->buf[in->len - 1] != '\n') {
+        in->buf[in->len++] = '\n'; //there is room, see below
+      }
+      in->used = in->len;
+      return in->len;
+    }
+    //Keep room for the newline of a last line
+    if(in->len + 1 >= in->size) {
+      char *buf = (char *) realloc(in->buf, in->size * 2);
+      if(buf == NULL) {
+        in->error = ENOMEM;
+        in->eof = 1;
+        continue;
+      }
+      in->buf = buf;
+      in->size *= 2;
+    }
+    ssize_t n = read(in->fd, in->buf + in->len, in->size - in->len - 1);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      in->error = n < 0 ? errno : 0;
+      in->eof = 1;
+      continue;
+    }
+    char *nl = (char *) memrchr(in->buf + in->len, '\n', n); //the lines before had none
+    in->len += n;
+    if(nl != NULL) {
+      in->used = nl + 1 - in->buf;
+      return in->used;
+    }
+  }
+}
+
+//Reads a number of lines or bytes, returns -1 if it is not only digits
+static int parseCount(char *s, uint64_t *n) {
+  char *end;
+
+  if(s[0] < '0' || s[0] > '9') {
+    return -1;
+  }
+  errno = 0;
+  *n = strtoull(s, &end, 10);
+
+  return *end != '\0' || errno != 0 ? -1 : 0;
+}
+
+//Reads a list of fields of cut like "1-3,5,7-", returns -1 if it is not one
+static int parseFieldList(Filter *f, char *list) {
+  int max = 0;
+  char *p = list;
+
+  //First the highest field not in an open range, for the size of f->fields
+  while(*p != '\0') {
+    char *item = p;
+    char *end;
+    long lo = 1, hi;
+    if(*p != '-') {
+      lo = strtol(p, &end, 10);
+      if(end == p || lo < 1 || lo > 1000000) {
+        return -1;
+      }
+      p = end;
+    }
+    hi = lo;
+    if(*p == '-') {
+      p++;
+      hi = 0; //open
+      if(*p >= '0' && *p <= '9') {
+        hi = strtol(p, &end, 10);
+        p = end;
+        if(hi < lo || hi > 1000000) {
+          return -1;
+        }
+      }
+      else if(p == item + 1) {
+        return -1; //"-" alone
+      }
+    }
+    if(*p == ',' && p[1] != '\0') {
+      p++;
+    }
+    else if(*p != '\0') {
+      return -1;
+    }
+    if(hi == 0) {
+      f->from = f->from == 0 || lo < f->from ? lo : f->from;
+    }
+    max = hi > max ? hi : max;
+  }
+  if(max == 0 && f->from == 0) {
+    return -1;
+  }
+  f->fields = (unsigned char *) calloc(max + 1, 1);
+  if(f->fields == NULL) {
+    return -1;
+  }
+  f->n_fields = max;
+
+  //Then the fields themselves
+  for(p = list; *p != '\0'; ) {
+    char *end;
+    long lo = 1, hi;
+    if(*p != '-') {
+      lo = strtol(p, &end, 10);
+      p = end;
+    }
+    hi = lo;
+    if(*p == '-') {
+      p++;
+      hi = max;
+      if(*p >= '0' && *p <= '9') {
+        hi = strtol(p, &end, 10);
+        p = end;
+      }
+    }
+    for(long i = lo; i <= hi && i <= max; i++) {
+      f->fields[i - 1] = 1;
+    }
+    if(*p == ',') {
+      p++;
+    }
+  }
+
+  return 0;
+}
+
+//Parses the options of argv into f, returns -1 if one is not supported
+//An option taking a value takes the rest of its argument, or the next argument
+static int parseFilter(char *argv[], Filter *f) {
+  int argc = 0;
+  int dash_dash = 0; //1 after "--"
+  int grep_f = 0; //grep -F
+  char *value;
+
+  memset(f, 0, sizeof(Filter));
+  while(argv[argc] != NULL) {
+    argc++;
+  }
+  if(strcmp(argv[0], "grep") == 0) {
+    f->kind = FILTER_GREP;
+  }
+  else if(strcmp(argv[0], "head") == 0) {
+    f->kind = FILTER_HEAD;
+    f->lines = 1;
+    f->n = 10;
+  }
+  else if(strcmp(argv[0], "wc") == 0) {
+    f->kind = FILTER_WC;
+  }
+  else if(strcmp(argv[0], "cut") == 0) {
+    f->kind = FILTER_CUT;
+  }
+  else {
+    return -1;
+  }
+  f->files = (char **) calloc(argc + 1, sizeof(char *));
+  if(f->files == NULL) {
+    return -1;
+  }
+
+  for(int i = 1; i < argc; i++) {
+    char *arg = argv[i];
+    if(dash_dash || arg[0] != '-' || arg[1] == '\0') {
+      if(f->kind == FILTER_GREP && f->pattern == NULL) {
+        f->pattern = arg;
+      }
+      else {
+        f->files[f->n_files++] = arg;
+      }
+      continue;
+    }
+    if(strcmp(arg, "--") == 0) {
+      dash_dash = 1;
+      continue;
+    }
+    //The old "head -N", only as the first argument
+    if(f->kind == FILTER_HEAD && i == 1 && arg[1] >= '0' && arg[1] <= '9') {
+      if(parseCount(arg + 1, &(f->n)) < 0) {
+        return -1;
+      }
+      continue;
+    }
+    for(int j = 1; arg[j] != '\0'; j++) {
+      char c = arg[j];
+      if(f->kind == FILTER_GREP && c == 'F') {
+        grep_f = 1;
+      }
+      else if(f->kind == FILTER_GREP && c == 'v') {
+        f->invert = 1;
+      }
+      else if(f->kind == FILTER_GREP && c == 'c') {
+        f->count = 1;
+      }
+      else if(f->kind == FILTER_GREP && c == 'n') {
+        f->number = 1;
+      }
+      else if(f->kind == FILTER_WC && c == 'l') {
+        f->print_lines = 1;
+      }
+      else if(f->kind == FILTER_WC && c == 'c') {
+        f->print_bytes = 1;
+      }
+      else if(f->kind == FILTER_CUT && c == 's') {
+        f->only_delimited = 1;
+      }
+      else if((f->kind == FILTER_HEAD && (c == 'n' || c == 'c')) || (f->kind == FILTER_CUT && (c == 'd' || c == 'f'))) {
+        value = arg[j + 1] != '\0' ? arg + j + 1 : argv[++i];
+        if(value == NULL) {
+          return -1;
+        }
+        if(f->kind == FILTER_HEAD) {
+          f->lines = c == 'n';
+          if(parseCount(value, &(f->n)) < 0) {
+            return -1;
+          }
+        }
+        else if(c == 'd') {
+          if(strlen(value) != 1) {
+            return -1;
+          }
+          f->delim = value[0];
+        }
+        else {
+          f->field_list = value;
+        }
+        break;
+      }
+      else {
+        return -1;
+      }
+    }
+  }
+
+  if(f->kind == FILTER_GREP) {
+    if(!grep_f || f->pattern == NULL || strchr(f->pattern, '\n') != NULL) {
+      return -1;
+    }
+    f->pattern_len = strlen(f->pattern);
+  }
+  if(f->kind == FILTER_WC && !f->print_lines && !f->print_bytes) {
+    return -1; //words are not counted here
+  }
+  if(f->kind == FILTER_CUT && (f->delim == '\0' || f->field_list == NULL || f->delim == '\n' || parseFieldList(f, f->field_list) < 0)) {
+    return -1;
+  }
+
+  return 0;
+}
+
+//Frees what parseFilter() allocated
+static void freeFilter(Filter *f) {
+  free(f->files);
+  free(f->fields);
+}
+
+//Returns 1 if argv is a filter run by runTextFilter()
+int isTextFilter(char *argv[]) {
+  Filter f;
+
+  if(argv[0] == NULL || (strcmp(argv[0], "grep") != 0 && strcmp(argv[0], "head") != 0 && strcmp(argv[0], "wc") != 0 && strcmp(argv[0], "cut") != 0)) {
+    return 0;
+  }
+  int supported = parseFilter(argv, &f) == 0;
+  freeFilter(&f);
+
+  return supported;
+}
+
+//Prints the lines of an input selected by grep, returns how many there are
+static uint64_t grepInput(Filter *f, Input *in, int prefix) {
+  uint64_t selected = 0;
+  uint64_t line_no = 0; //lines before counted, with -n
+  int binary = 0; //1 once a NUL byte has been read
+  size_t n;
+
+  while((n = readLines(in)) > 0) {
+    char *p = in->buf;
+    char *end = p + n;
+    char *counted = p;
+    binary |= findByte(p, end, '\0') != NULL;
+    while(p < end) {
+      //[p, start) are lines without the pattern, [start, stop) the line with it
+      char *m = f->pattern_len == 0 ? p : f->pattern_len == 1 ? findByte(p, end, f->pattern[0]) : findString(p, end, f->pattern, f->pattern_len);
+      char *start = end;
+      char *stop = end;
+      if(m != NULL) {
+        start = (char *) memrchr(p, '\n', m - p);
+        start = start == NULL ? p : start + 1;
+        stop = findByte(m, end, '\n') + 1;
+      }
+      char *from = f->invert ? p : start;
+      char *to = f->invert ? start : stop;
+      p = stop;
+      if(from == to) {
+        continue;
+      }
+      if(f->count) {
+        selected += f->invert ? countByte(from, to, '\n') : 1;
+        continue;
+      }
+      selected++;
+      if(binary) {
+        //Like GNU grep, the lines of a binary file are not printed, a notice goes to stderr
+        flushOutput();
+        fprintf(stderr, "grep: %s: binary file matches\n", in->name);
+        return selected;
+      }
+      if(!prefix && !f->number) {
+        putOutput(from, to - from);
+        continue;
+      }
+      while(from < to) {
+        char *eol = findByte(from, to, '\n') + 1;
+        if(prefix) {
+          putString(in->name);
+          putOutput(":", 1);
+        }
+        if(f->number) {
+          line_no += countByte(counted, from, '\n');
+          counted = from;
+          putNumber(line_no + 1);
+          putOutput(":", 1);
+        }
+        putOutput(from, eol - from);
+        from = eol;
+      }
+    }
+    if(f->number) {
+      line_no += countByte(counted, end, '\n');
+    }
+    flushOutput(); //a line read is printed before waiting for more
+  }
+
+  return selected;
+}
+
+//grep -F: returns 0 if a line was selected, 1 if none, 2 on an error
+static int runGrep(Filter *f, Input *in) {
+  int status = 1;
+  int error = 0;
+  int prefix = f->n_files > 1;
+
+  for(int i = 0; i == 0 || i < f->n_files; i++) {
+    if(openInput(in, f->files[i], "(standard input)") < 0) {
+      flushOutput();
+      fprintf(stderr, "grep: %s: %s\n", f->files[i], strerror(errno));
+      error = 1;
+      continue;
+    }
+    uint64_t selected = grepInput(f, in, prefix);
+    if(in->error != 0) {
+      flushOutput();
+      fprintf(stderr, "grep: %s: %s\n", in->name, strerror(in->error));
+      error = 1;
+    }
+    if(f->count) {
+      if(prefix) {
+        putString(in->name);
+        putOutput(":", 1);
+      }
+      putNumber(selected);
+      putOutput("\n", 1);
+    }
+    status = selected > 0 ? 0 : status;
+    closeInput(in);
+  }
+  flushOutput();
+
+  return error ? 2 : status;
+}
+
+//head: returns 0, or 1 if an input could not be read
+static int runHead(Filter *f, Input *in) {
+  int status = 0;
+  int headers = 0; //headers printed
+
+  for(int i = 0; i == 0 || i < f->n_files; i++) {
+    if(openInput(in, f->files[i], "standard input") < 0) {
+      flushOutput();
+      fprintf(stderr, "head: cannot open '%s' for reading: %s\n", f->files[i], strerror(errno));
+      status = 1;
+      continue;
+    }
+    if(f->n_files > 1) {
+      putString(headers++ > 0 ? "\n==> " : "==> ");
+      putString(in->name);
+      putString(" <==\n");
+    }
+    uint64_t left = f->n;
+    size_t n;
+    while(left > 0 && (n = readBlock(in)) > 0) {
+      char *p = in->buf;
+      char *end = p + n;
+      char *stop = end;
+      if(f->lines) {
+        uint64_t lines = countByte(p, end, '\n');
+        if(lines < left) {
+          left -= lines;
+        }
+        else {
+          for(stop = p; left > 0; left--) {
+            stop = findByte(stop, end, '\n') + 1;
+          }
+        }
+      }
+      else {
+        stop = left < n ? p + left : end;
+        left -= stop - p;
+      }
+      putOutput(p, stop - p);
+      if(stop < end) {
+        lseek(in->fd, -(off_t) (end - stop), SEEK_CUR); //fails on a pipe, which is fine
+      }
+    }
+    if(in->error != 0) {
+      flushOutput();
+      fprintf(stderr, "head: error reading '%s': %s\n", in->name, strerror(in->error));
+      status = 1;
+    }
+    closeInput(in);
+    flushOutput();
+  }
+
+  return status;
+}
+
+//Prints the counts of wc in columns of the given width
+static void putCounts(Filter *f, uint64_t lines, uint64_t bytes, char *name, int width) {
+  char buf[64];
+
+  if(f->print_lines) {
+    putOutput(buf, snprintf(buf, sizeof(buf), "%*lu", width, (unsigned long) lines));
+  }
+  if(f->print_bytes) {
+    putOutput(buf, snprintf(buf, sizeof(buf), f->print_lines ? " %*lu" : "%*lu", width, (unsigned long) bytes));
+  }
+  if(name != NULL) {
+    putOutput(" ", 1);
+    putString(name);
+  }
+  putOutput("\n", 1);
+}
+
+//Returns the width of the columns of wc, like GNU wc: 1 for a single count of a
+//single input, else the digits of the total size of the regular files, at least 7
+//if an input is not a regular file
+static int countWidth(Filter *f) {
+  int n_inputs = f->n_files > 0 ? f->n_files : 1;
+  struct stat buf;
+  uint64_t total = 0;
+  int width = 1;
+  int min_width = 1;
+
+  if(n_inputs == 1 && f->print_lines + f->print_bytes == 1) {
+    return 1;
+  }
+  for(int i = 0; i < n_inputs; i++) {
+    char *file = f->files[i];
+    if((file == NULL || strcmp(file, "-") == 0 ? fstat(STDIN_FILENO, &buf) : stat(file, &buf)) != 0) {
+      continue;
+    }
+    if(S_ISREG(buf.st_mode)) {
+      total += buf.st_size;
+    }
+    else {
+      min_width = 7;
+    }
+  }
+  for(; total >= 10; total /= 10) {
+    width++;
+  }
+
+  return width < min_width ? min_width : width;
+}
+
+//wc -l, -c: returns 0, or 1 if an input could not be read
+static int runWc(Filter *f, Input *in) {
+  int status = 0;
+  int width = countWidth(f);
+  uint64_t total_lines = 0;
+  uint64_t total_bytes = 0;
+  struct stat buf;
+
+  for(int i = 0; i == 0 || i < f->n_files; i++) {
+    if(openInput(in, f->files[i], "-") < 0) {
+      flushOutput();
+      fprintf(stderr, "wc: %s: %s\n", f->files[i], strerror(errno));
+      status = 1;
+      continue;
+    }
+    uint64_t lines = 0;
+    uint64_t bytes = 0;
+    off_t pos;
+    //The size of a regular file is its number of bytes, from where it is read
+    if(!f->print_lines && fstat(in->fd, &buf) == 0 && S_ISREG(buf.st_mode) && (pos = lseek(in->fd, 0, SEEK_CUR)) >= 0) {
+      bytes = buf.st_size > pos ? buf.st_size - pos : 0;
+    }
+    else {
+      size_t n;
+      while((n = readBlock(in)) > 0) {
+        lines += f->print_lines ? countByte(in->buf, in->buf + n, '\n') : 0;
+        bytes += n;
+      }
+    }
+    if(in->error != 0) {
+      flushOutput();
+      fprintf(stderr, "wc: %s: %s\n", in->name, strerror(in->error));
+      status = 1;
+    }
+    putCounts(f, lines, bytes, f->files[i], width);
+    total_lines += lines;
+    total_bytes += bytes;
+    closeInput(in);
+  }
+  if(f->n_files > 1) {
+    putCounts(f, total_lines, total_bytes, "total", width);
+  }
+  flushOutput();
+
+  return status;
+}
+
+//Returns 1 if cut prints the field, numbered from 1
+static int isSelected(Filter *f, int field) {
+  return (field <= f->n_fields && f->fields[field - 1]) || (f->from > 0 && field >= f->from);
+}
+
+//cut -d -f: returns 0, or 1 if an input could not be read
+static int runCut(Filter *f, Input *in) {
+  int status = 0;
+
+  for(int i = 0; i == 0 || i < f->n_files; i++) {
+    if(openInput(in, f->files[i], "-") < 0) {
+      flushOutput();
+      fprintf(stderr, "cut: %s: %s\n", f->files[i], strerror(errno));
+      status = 1;
+      continue;
+    }
+    size_t n;
+    while((n = readLines(in)) > 0) {
+      char *p = in->buf;
+      char *end = p + n; //every line ends with a newline
+      while(p < end) {
+        char *sep = findEither(p, end, f->delim, '\n');
+        if(*sep == '\n') {
+          //A line without the delimiter is printed whole, unless -s
+          if(!f->only_delimited) {
+            putOutput(p, sep + 1 - p);
+          }
+          p = sep + 1;
+          continue;
+        }
+        int printed = 0;
+        for(int field = 1; ; field++) {
+          if(f->from > 0 && field >= f->from && field > f->n_fields) {
+            //Every field from here on is printed, with the delimiters between them
+            char *eol = *sep == '\n' ? sep : findByte(sep, end, '\n');
+            if(printed) {
+              putOutput(&(f->delim), 1);
+            }
+            putOutput(p, eol - p);
+            p = eol + 1;
+            break;
+          }
+          if(isSelected(f, field)) {
+            if(printed) {
+              putOutput(&(f->delim), 1);
+            }
+            putOutput(p, sep - p);
+            printed = 1;
+          }
+          if(*sep == '\n') {
+            p = sep + 1;
+            break;
+          }
+          if(f->from == 0 && field >= f->n_fields) {
+            p = findByte(sep, end, '\n') + 1; //no more fields to print
+            break;
+          }
+          p = sep + 1;
+          sep = findEither(p, end, f->delim, '\n');
+        }
+        putOutput("\n", 1);
+      }
+      flushOutput();
+    }
+    if(in->error != 0) {
+      flushOutput();
+      fprintf(stderr, "cut: %s: %s\n", in->name, strerror(in->error));
+      status = 1;
+    }
+    closeInput(in);
+  }
+  flushOutput();
+
+  return status;
+}
+
+//Runs the filter of argv in this process and returns its exit status
+int runTextFilter(char *argv[]) {
+  Filter f;
+  Input in;
+  int status;
+
+  if(parseFilter(argv, &f) < 0) {
+    freeFilter(&f);
+    return 2;
+  }
+  initScanning();
+  in.size = FILTER_BLOCK_SIZE;
+  in.buf = (char *) malloc(in.size);
+  if(in.buf == NULL) {
+    perror("malloc");
+    return 2;
+  }
+  if(f.kind == FILTER_GREP) {
+    status = runGrep(&f, &in);
+  }
+  else if(f.kind == FILTER_HEAD) {
+    status = runHead(&f, &in);
+  }
+  else if(f.kind == FILTER_WC) {
+    status = runWc(&f, &in);
+  }
+  else {
+    status = runCut(&f, &in);
+  }
+  free(in.buf);
+  freeFilter(&f);
+
+  return status;
+}
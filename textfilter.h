@@ -0,0 +1,49 @@
+/*
+ * File:	textfilter.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Run the text filters most used in pipelines, "grep -F",
+		"head", "wc -l" and "cut -d", in the child the shell forked
+		for them instead of executing the programs, and scan their
+		input with SIMD instructions.
+
+   Return:	1) isTextFilter() returns 1 if argv is one of the filters
+		   with only options supported here, or 0 if the program
+		   must be executed.
+		2) runTextFilter() returns the exit status the program
+		   would.
+
+   Note:	1) The filters and options run without exec are
+			grep -F [-v] [-c] [-n] pattern [file ...]
+			head [-n N | -c N | -N] [file ...]
+			wc -l | -c | -lc [file ...]
+			cut -d c -f list [-s] [file ...]
+		   Options may be grouped like "-Fvn" and may come after
+		   the operands, like with GNU getopt. Any other option, a
+		   pattern with a newline or a path like /usr/bin/grep
+		   runs the program itself.
+		2) The output is the one of GNU grep and coreutils for
+		   those options: the file name prefixes of grep, its
+		   "binary file matches" on stderr when the input has a
+		   NUL byte,
+		   the "==> file <==" headers of head, the column widths
+		   and total of wc, and the error messages.
+		3) Newlines and delimiters are found, newlines counted and
+		   the pattern searched for 32 bytes at a time with AVX2
+		   if the CPU has it, else 16 at a time with SSE2, else one
+		   at a time on other processors than x86-64. The pattern
+		   search compares its first and last bytes at every
+		   position of a block at once, and checks only those
+		   candidates with memcmp().
+		4) Input is read in blocks of FILTER_BLOCK_SIZE bytes,
+		   grown for longer lines. Like GNU head, head puts a
+		   seekable input back just after the last byte it printed.
+*/
+
+#define FILTER_BLOCK_SIZE (128 * 1024) //bytes of input read at once
+#define FILTER_OUT_SIZE (256 * 1024) //bytes of output written at once
+
+int isTextFilter(char *argv[]);
+int runTextFilter(char *argv[]);
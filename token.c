@@ -15,17 +15,87 @@ void initialiseToken(char *token[]) {
   }
 }
 
+//Returns 1 if c separates tokens
+static int isTokenDelimiter(char c) {
+  return c == ' ' || c == ',' || c == '\t';
+}
+
+//Returns a pointer past the ")" matching the "(" at p
+//A command or process substitution is kept in one token even if it contains
+//white space
+static char *skipGroup(char *p) {
+  int depth = 0;
+
+  do {
+    if(*p == '(') {
+      depth++;
+    }
+    else if(*p == ')') {
+      depth--;
+    }
+    p++;
+  } while(*p != '\0' && depth > 0);
+
+  return p;
+}
+
+//Returns a pointer past the "`" matching the "`" at p
+static char *skipBackQuote(char *p) {
+  char *end = strchr(p + 1, '`');
+
+  return end == NULL ? p + strlen(p) : end + 1;
+}
+
 //Splits a string by whitespace " " and "\t"
 int tokeniseWhiteSpace(char *input, char *token[]) {
-  char *tok = strtok(input, " ,\t");
+  return tokeniseLine(input, token, MAX_NUM_TOKENS);
+}
+
+//Splits a string by whitespace into token[], which has size elements
+//Returns -1 if it needs more than size - 2, the rest is for separateCommands()
+int tokeniseLine(char *input, char *token[], int size) {
+  char *p = input;
   int n_tokens = 0;
-  while(tok != NULL) {
-    token[n_tokens] = tok;
-    tok = strtok(NULL, " ,\t");
+
+  while(*p != '\0') {
+    while(isTokenDelimiter(*p)) {
+      p++;
+    }
+    if(*p == '\0') {
+      break;
+    }
+    char *start = p;
+    while(*p != '\0' && !isTokenDelimiter(*p)) {
+      if((p[0] == '$' || p[0] == '<' || p[0] == '>') && p[1] == '(') {
+        p = skipGroup(p + 1);
+      }
+      else if(*p == '`') {
+        p = skipBackQuote(p);
+      }
+      else {
+        p++;
+      }
+    }
+    if(*p != '\0') {
+      *p++ = '\0';
+    }
+    //Split "<<EOF" and "<<<word" into the operator and its operand
+    if(start[0] == '<' && start[1] == '<' && start[2] != '\0' && strcmp(start, "<<<") != 0) {
+      char *op = start[2] == '<' ? "<<<" : "<<";
+      if(n_tokens < size - 2) {
+        token[n_tokens] = op;
+      }
+      n_tokens++;
+      start += strlen(op);
+    }
+    //Keep room for the ";" and NULL added by separateCommands()
+    if(n_tokens < size - 2) {
+      token[n_tokens] = start;
+    }
     n_tokens++;
   }
 
-  if(n_tokens > MAX_NUM_TOKENS) {
+  if(n_tokens > size - 2) {
     return -1;
   }
 
@@ -8,4 +8,5 @@
 
 void initialiseToken(char *token[]);
 int tokeniseWhiteSpace(char *input, char *token[]);
+int tokeniseLine(char *input, char *token[], int size);
 void printTokens(int n_tokens, char *token[]);
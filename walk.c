@@ -0,0 +1,466 @@
+/*
+ * File:	walk.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <fnmatch.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "walk.h"
+
+//Directory entry as returned by the getdents64 system call
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+//A directory waiting to be read
+struct WalkDirStruct {
+  char *path; //path name of the directory, "" for the current directory
+  uint64_t states; //bit s is set if the directory matched the first s components
+};
+
+typedef struct WalkDirStruct WalkDir;
+
+//Double-ended queue of directories owned by one thread
+//The owner pushes and pops at the tail, other threads steal from the head
+struct WalkQueueStruct {
+  pthread_mutex_t lock;
+  WalkDir *dirs;
+  int head;
+  int tail;
+  int size;
+};
+
+typedef struct WalkQueueStruct WalkQueue;
+
+//Matching path names found by one thread
+struct WalkResultStruct {
+  char **paths;
+  int n_paths;
+  int size;
+};
+
+typedef struct WalkResultStruct WalkResult;
+
+struct WalkStruct {
+  char *seg[MAX_WALK_SEGMENTS]; //pattern components after the literal prefix
+  int n_segs;
+  int n_threads;
+  WalkQueue queue[MAX_WALK_THREADS];
+  WalkResult result[MAX_WALK_THREADS];
+  long pending; //directories queued or being read
+  int n_idle; //threads waiting for work
+  pthread_mutex_t idle_lock;
+  pthread_cond_t idle_cond;
+};
+
+typedef struct WalkStruct Walk;
+
+struct WalkThreadStruct {
+  Walk *walk;
+  int id;
+};
+
+typedef struct WalkThreadStruct WalkThread;
+
+//Result of the last call to walkGlob(), until it is released
+static char *cached_pattern = NULL;
+static char **cached_paths = NULL;
+static int cached_n_paths = 0;
+
+//Returns 1 if input contains the recursive wildcard "**"
+int isRecursiveWildCard(char *input) {
+  return strstr(input, "**") != NULL;
+}
+
+//Returns 1 if the component contains a wildcard character
+static int hasWildCard(char *seg) {
+  return strpbrk(seg, "*?[") != NULL;
+}
+
+//Returns 1 if the component is "**"
+static int isGlobStar(char *seg) {
+  return strcmp(seg, "**") == 0;
+}
+
+//Adds the states reachable by letting "**" match zero directories
+static uint64_t closeStates(Walk *walk, uint64_t states) {
+  for(int s = 0; s < walk->n_segs; s++) {
+    if((states & ((uint64_t) 1 << s)) && isGlobStar(walk->seg[s])) {
+      states |= (uint64_t) 1 << (s + 1);
+    }
+  }
+
+  return states;
+}
+
+//Returns the states reached after matching one more path component
+static uint64_t stepStates(Walk *walk, uint64_t states, char *name) {
+  uint64_t next = 0;
+
+  for(int s = 0; s < walk->n_segs; s++) {
+    if((states & ((uint64_t) 1 << s)) == 0) {
+      continue;
+    }
+    if(isGlobStar(walk->seg[s])) {
+      if(name[0] != '.') {
+        next |= (uint64_t) 1 << s; //"**" absorbs the directory
+      }
+    }
+    else if(fnmatch(walk->seg[s], name, FNM_PERIOD) == 0) {
+      next |= (uint64_t) 1 << (s + 1);
+    }
+  }
+
+  return closeStates(walk, next);
+}
+
+//Joins a directory path name and an entry name into a new string
+static char *joinPath(char *dir, char *name) {
+  size_t dir_len = strlen(dir);
+  size_t name_len = strlen(name);
+  char *path = (char *) malloc(dir_len + name_len + 2);
+
+  if(path == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  memcpy(path, dir, dir_len);
+  if(dir_len > 0 && dir[dir_len - 1] != '/') {
+    path[dir_len++] = '/';
+  }
+  memcpy(path + dir_len, name, name_len + 1);
+
+  return path;
+}
+
+//Pushes a directory at the tail of a queue
+static void pushDir(Walk *walk, int id, char *path, uint64_t states) {
+  WalkQueue *q = &(walk->queue[id]);
+
+  __atomic_add_fetch(&(walk->pending), 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_lock(&(q->lock));
+  if(q->tail == q->size) {
+    //Reclaim the space left by stolen directories before growing
+    if(q->head > 0) {
+      memmove(q->dirs, q->dirs + q->head, sizeof(WalkDir) * (q->tail - q->head));
+      q->tail -= q->head;
+      q->head = 0;
+    }
+    if(q->tail == q->size) {
+      q->size = q->size == 0 ? 64 : q->size * 2;
+      q->dirs = (WalkDir *) realloc(q->dirs, sizeof(WalkDir) * q->size);
+      if(q->dirs == NULL) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+  }
+  q->dirs[q->tail].path = path;
+  q->dirs[q->tail].states = states;
+  q->tail++;
+  pthread_mutex_unlock(&(q->lock));
+
+  if(__atomic_load_n(&(walk->n_idle), __ATOMIC_SEQ_CST) > 0) {
+    pthread_cond_signal(&(walk->idle_cond));
+  }
+}
+
+//Takes a directory from the tail of the own queue or the head of another one
+//Returns 0 if all queues are empty
+static int takeDir(Walk *walk, int id, WalkDir *dir) {
+  for(int i = 0; i < walk->n_threads; i++) {
+    WalkQueue *q = &(walk->queue[(id + i) % walk->n_threads]);
+    int found = 0;
+
+    pthread_mutex_lock(&(q->lock));
+    if(q->head < q->tail) {
+      if(i == 0) {
+        *dir = q->dirs[--q->tail];
+      }
+      else {
+        *dir = q->dirs[q->head++];
+      }
+      if(q->head == q->tail) {
+        q->head = 0;
+        q->tail = 0;
+      }
+      found = 1;
+    }
+    pthread_mutex_unlock(&(q->lock));
+    if(found) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Adds a matching path name to the result of a thread
+static void addResult(WalkResult *r, char *path) {
+  if(r->n_paths == r->size) {
+    r->size = r->size == 0 ? 256 : r->size * 2;
+    r->paths = (char **) realloc(r->paths, sizeof(char *) * r->size);
+    if(r->paths == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  r->paths[r->n_paths++] = path;
+}
+
+//Reads one directory, records matching entries and queues subdirectories
+static void readDir(Walk *walk, int id, WalkDir *dir, char *buf) {
+  uint64_t match = (uint64_t) 1 << walk->n_segs;
+  int fd = open(dir->path[0] != '\0' ? dir->path : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  long n_read;
+
+  if(fd < 0) {
+    return; //unreadable directories are skipped, like glob() does
+  }
+  while((n_read = syscall(SYS_getdents64, fd, buf, WALK_BUF_SIZE)) > 0) {
+    for(long pos = 0; pos < n_read;) {
+      struct LinuxDirent64 *de = (struct LinuxDirent64 *) (buf + pos);
+      char *name = de->d_name;
+      pos += de->d_reclen;
+
+      if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      uint64_t states = stepStates(walk, dir->states, name);
+      if(states == 0) {
+        continue;
+      }
+
+      //Only call stat when the file system does not fill in d_type
+      int is_dir = de->d_type == DT_DIR;
+      if(de->d_type == DT_UNKNOWN) {
+        struct stat st;
+        is_dir = fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+      }
+
+      char *path = joinPath(dir->path, name);
+      if(states & match) {
+        addResult(&(walk->result[id]), path);
+      }
+      if(is_dir && (states & (match - 1))) {
+        pushDir(walk, id, (states & match) ? strdup(path) : path, states);
+      }
+      else if(!(states & match)) {
+        free(path);
+      }
+    }
+  }
+  close(fd);
+}
+
+//Walker thread: reads directories until no directory is left anywhere
+static void *walkThread(void *arg) {
+  WalkThread *t = (WalkThread *) arg;
+  Walk *walk = t->walk;
+  char *buf = (char *) malloc(WALK_BUF_SIZE);
+  WalkDir dir;
+
+  if(buf == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  while(1) {
+    if(takeDir(walk, t->id, &dir)) {
+      readDir(walk, t->id, &dir, buf);
+      free(dir.path);
+      if(__atomic_sub_fetch(&(walk->pending), 1, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&(walk->idle_lock));
+        pthread_cond_broadcast(&(walk->idle_cond));
+        pthread_mutex_unlock(&(walk->idle_lock));
+      }
+      continue;
+    }
+
+    //Nothing to steal, wait until a directory is queued or the walk is over
+    pthread_mutex_lock(&(walk->idle_lock));
+    if(__atomic_load_n(&(walk->pending), __ATOMIC_SEQ_CST) == 0) {
+      pthread_mutex_unlock(&(walk->idle_lock));
+      break;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 1000000; //1 ms, in case a wakeup is missed
+    if(ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+    __atomic_add_fetch(&(walk->n_idle), 1, __ATOMIC_SEQ_CST);
+    pthread_cond_timedwait(&(walk->idle_cond), &(walk->idle_lock), &ts);
+    __atomic_sub_fetch(&(walk->n_idle), 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&(walk->idle_lock));
+  }
+  free(buf);
+
+  return NULL;
+}
+
+//Compares two path names for qsort()
+static int comparePath(const void *a, const void *b) {
+  return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+//Frees the cached result of the last walk
+static void freeCache() {
+  if(cached_paths != NULL) {
+    for(int i = 0; i < cached_n_paths; i++) {
+      free(cached_paths[i]);
+    }
+    free(cached_paths);
+  }
+  free(cached_pattern);
+  cached_pattern = NULL;
+  cached_paths = NULL;
+  cached_n_paths = 0;
+}
+
+//Forgets the cached result, whose path names now belong to the caller
+void releaseWalkGlob() {
+  free(cached_paths);
+  free(cached_pattern);
+  cached_pattern = NULL;
+  cached_paths = NULL;
+  cached_n_paths = 0;
+}
+
+//Expands a pattern containing "**" into a sorted list of path names
+int walkGlob(char *pattern, char ***paths) {
+  if(cached_pattern != NULL && strcmp(cached_pattern, pattern) == 0) {
+    *paths = cached_paths;
+    return cached_n_paths;
+  }
+  freeCache();
+
+  Walk *walk = (Walk *) calloc(1, sizeof(Walk));
+  char *copy = strdup(pattern);
+  if(walk == NULL || copy == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+
+  //Split the pattern into its literal prefix and the components to match
+  char *base = (char *) calloc(strlen(pattern) + 2, 1);
+  char *p = copy;
+  int literal = 1;
+  if(base == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  if(*p == '/') {
+    strcpy(base, "/");
+  }
+  while(*p != '\0') {
+    while(*p == '/') {
+      p++;
+    }
+    if(*p == '\0') {
+      break;
+    }
+    char *seg = p;
+    while(*p != '\0' && *p != '/') {
+      p++;
+    }
+    if(*p == '/') {
+      *p++ = '\0';
+    }
+    if(literal && !hasWildCard(seg)) {
+      if(base[0] != '\0' && base[strlen(base) - 1] != '/') {
+        strcat(base, "/");
+      }
+      strcat(base, seg);
+      continue;
+    }
+    literal = 0;
+    if(walk->n_segs > 0 && isGlobStar(seg) && isGlobStar(walk->seg[walk->n_segs - 1])) {
+      continue; //"**/**" is the same as "**"
+    }
+    if(walk->n_segs == MAX_WALK_SEGMENTS) {
+      free(copy);
+      free(base);
+      free(walk);
+      return -1;
+    }
+    walk->seg[walk->n_segs++] = seg;
+  }
+
+  //Start the walker threads, the calling thread is thread 0
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  walk->n_threads = n_cpus < 1 ? 1 : (n_cpus > MAX_WALK_THREADS ? MAX_WALK_THREADS : n_cpus);
+  pthread_mutex_init(&(walk->idle_lock), NULL);
+  pthread_cond_init(&(walk->idle_cond), NULL);
+  for(int i = 0; i < walk->n_threads; i++) {
+    pthread_mutex_init(&(walk->queue[i].lock), NULL);
+  }
+  pushDir(walk, 0, base, closeStates(walk, 1));
+
+  pthread_t tid[MAX_WALK_THREADS];
+  WalkThread thread[MAX_WALK_THREADS];
+  for(int i = 0; i < walk->n_threads; i++) {
+    thread[i].walk = walk;
+    thread[i].id = i;
+  }
+  int n_started = 1;
+  for(int i = 1; i < walk->n_threads; i++) {
+    if(pthread_create(&tid[i], NULL, walkThread, &thread[i]) != 0) {
+      break; //carry on with the threads already running
+    }
+    n_started++;
+  }
+  walkThread(&thread[0]);
+  for(int i = 1; i < n_started; i++) {
+    pthread_join(tid[i], NULL);
+  }
+
+  //Merge the results of all threads and sort them
+  int n_paths = 0;
+  for(int i = 0; i < walk->n_threads; i++) {
+    n_paths += walk->result[i].n_paths;
+  }
+  char **all = (char **) malloc(sizeof(char *) * (n_paths + 1));
+  if(all == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  n_paths = 0;
+  for(int i = 0; i < walk->n_threads; i++) {
+    memcpy(all + n_paths, walk->result[i].paths, sizeof(char *) * walk->result[i].n_paths);
+    n_paths += walk->result[i].n_paths;
+    free(walk->result[i].paths);
+    free(walk->queue[i].dirs);
+    pthread_mutex_destroy(&(walk->queue[i].lock));
+  }
+  qsort(all, n_paths, sizeof(char *), comparePath);
+  all[n_paths] = NULL;
+
+  pthread_mutex_destroy(&(walk->idle_lock));
+  pthread_cond_destroy(&(walk->idle_cond));
+  free(walk);
+  free(copy);
+
+  cached_pattern = strdup(pattern);
+  cached_paths = all;
+  cached_n_paths = n_paths;
+  *paths = all;
+
+  return n_paths;
+}
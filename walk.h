@@ -0,0 +1,32 @@
+/*
+ * File:	walk.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	Expand a wildcard pattern containing "**" by walking the
+		directory tree below its literal prefix in parallel.
+
+   Return:	1) The number of matching path names, which are stored in
+		   sorted order in a NULL-terminated array assigned to
+		   "paths", or
+		2) -1, if the pattern is too long or has too many components.
+
+   Note:	1) "**" matches zero or more directories. Like the other
+		   wildcard characters it does not match names starting with
+		   ".", and symbolic links are never followed.
+		2) The result of the last call is cached until
+		   releaseWalkGlob(), so counting the matches and then
+		   storing them walks the tree once. The array must not be
+		   freed by the caller, the path names are the caller's once
+		   the result is released. Release it after every expansion,
+		   a later one may see other files or another directory.
+*/
+
+#define MAX_WALK_THREADS 16 //upper limit on the number of walker threads
+#define MAX_WALK_SEGMENTS 63 //maximum number of "/" separated components
+#define WALK_BUF_SIZE (256 * 1024) //getdents64 buffer size per thread
+
+int isRecursiveWildCard(char *input);
+int walkGlob(char *pattern, char ***paths);
+void releaseWalkGlob();
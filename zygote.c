@@ -0,0 +1,462 @@
+/*
+ * File:	zygote.c
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/resource.h>
+#include "zygote.h"
+
+#define ZYGOTE_N_FDS 4 //stdin, stdout, stderr and the current directory
+
+#define ZYGOTE_STARTED 1
+#define ZYGOTE_EXITED 2
+
+struct ZygoteRequestStruct {
+  uint32_t n_argv;
+  uint32_t n_env;
+  //followed by the path name, argv and the environment changes, each ending with '\0'
+};
+
+typedef struct ZygoteRequestStruct ZygoteRequest;
+
+struct ZygoteReplyStruct {
+  int type; //ZYGOTE_STARTED or ZYGOTE_EXITED
+  pid_t pid; //-1 if the command could not be started
+  int error; //errno of fork() if pid is -1
+  int status; //from wait4()
+  struct rusage ru;
+};
+
+typedef struct ZygoteReplyStruct ZygoteReply;
+
+//A command started by the zygote, in the shell
+struct ZygoteChildStruct {
+  pid_t pid; //0 if the slot is free
+  int exited;
+  int status;
+  struct rusage ru;
+};
+
+typedef struct ZygoteChildStruct ZygoteChild;
+
+extern char **environ;
+
+static int zygote_sock = -1; //end of the socketpair of the shell, -1 if there is no zygote
+static pid_t owner_pid = 0; //the shell, as opposed to its subshells
+static char **base_env = NULL; //the environment the zygote started with
+static ZygoteChild children[ZYGOTE_MAX_CHILDREN];
+static char message[ZYGOTE_MSG_SIZE];
+
+//Sends a reply to the shell, which may have gone already
+static void sendReply(int sock, int type, pid_t pid, int error, int status, struct rusage *ru) {
+  ZygoteReply reply;
+
+  memset(&reply, 0, sizeof(reply));
+  reply.type = type;
+  reply.pid = pid;
+  reply.error = error;
+  reply.status = status;
+  if(ru != NULL) {
+    reply.ru = *ru;
+  }
+  send(sock, &reply, sizeof(reply), MSG_NOSIGNAL);
+}
+
+//Replaces the child of the zygote by the program of a request
+static void execRequest(char *data, size_t size, int fds[], sigset_t *chld) {
+  ZygoteRequest *request = (ZygoteRequest *) data;
+  char *argv[request->n_argv + 1];
+  char *s = data + sizeof(ZygoteRequest);
+  char *end = data + size;
+
+  //The path name, then argv, then the environment changes
+  char *path = s;
+  s += strlen(s) + 1;
+  for(uint32_t i = 0; i < request->n_argv; i++) {
+    argv[i] = s;
+    s += strlen(s) + 1;
+  }
+  argv[request->n_argv] = NULL;
+  for(uint32_t i = 0; i < request->n_env && s < end; i++) {
+    if(strchr(s, '=') != NULL) {
+      putenv(s);
+    }
+    else {
+      unsetenv(s);
+    }
+    s += strlen(s) + 1;
+  }
+
+  for(int i = 0; i < 3; i++) {
+    dup2(fds[i], i);
+  }
+  if(fchdir(fds[3]) != 0) {
+    perror("fchdir");
+  }
+  for(int i = 0; i < ZYGOTE_N_FDS; i++) {
+    close(fds[i]);
+  }
+  sigprocmask(SIG_UNBLOCK, chld, NULL); //left with the signals the shell blocks
+  execv(path, argv);
+  execvp(argv[0], argv);
+  perror("execvp");
+  exit(1);
+}
+
+//Returns 1 if a request of size bytes holds every string it says it has
+static int checkRequest(char *data, size_t size) {
+  if(size < sizeof(ZygoteRequest)) {
+    return 0;
+  }
+  ZygoteRequest *request = (ZygoteRequest *) data;
+  size_t n_strings = 1 + (size_t) request->n_argv + request->n_env;
+  char *s = data + sizeof(ZygoteRequest);
+  char *end = data + size;
+
+  for(size_t i = 0; i < n_strings; i++) {
+    char *nul = (char *) memchr(s, '\0', end - s);
+    if(nul == NULL) {
+      return 0;
+    }
+    s = nul + 1;
+  }
+
+  return request->n_argv > 0;
+}
+
+//Serves the requests of the shell until it closes its end of the socketpair
+static void runZygote(int sock) {
+  sigset_t blocked, chld;
+  struct pollfd pfd[2];
+  struct msghdr msg;
+  struct iovec iov;
+  union {
+    char buf[CMSG_SPACE(ZYGOTE_N_FDS * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+
+  //Block what the shell blocks, and take SIGCHLD through a signalfd
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGINT);
+  sigaddset(&blocked, SIGQUIT);
+  sigaddset(&blocked, SIGTSTP);
+  sigaddset(&blocked, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &blocked, NULL);
+  sigemptyset(&chld);
+  sigaddset(&chld, SIGCHLD);
+  pfd[0].fd = sock;
+  pfd[0].events = POLLIN;
+  pfd[1].fd = signalfd(-1, &chld, SFD_NONBLOCK | SFD_CLOEXEC);
+  pfd[1].events = POLLIN;
+  if(pfd[1].fd < 0) {
+    perror("signalfd");
+    exit(1);
+  }
+
+  while(1) {
+    if(poll(pfd, 2, -1) < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      exit(1);
+    }
+
+    //Report the commands that have exited
+    if(pfd[1].revents & POLLIN) {
+      struct signalfd_siginfo si;
+      struct rusage ru;
+      int status;
+      pid_t pid;
+      while(read(pfd[1].fd, &si, sizeof(si)) > 0) {
+      }
+      while((pid = wait4(-1, &status, WNOHANG, &ru)) > 0) {
+        sendReply(sock, ZYGOTE_EXITED, pid, 0, status, &ru);
+      }
+    }
+
+    if(pfd[0].revents == 0) {
+      continue;
+    }
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = message;
+    iov.iov_len = sizeof(message);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      exit(0); //the shell has exited
+    }
+
+    int fds[ZYGOTE_N_FDS];
+    int n_fds = 0;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if(cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      memcpy(fds, CMSG_DATA(cmsg), (n_fds < ZYGOTE_N_FDS ? n_fds : ZYGOTE_N_FDS) * sizeof(int));
+    }
+    if(n_fds != ZYGOTE_N_FDS || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || !checkRequest(message, n)) {
+      for(int i = 0; i < n_fds && i < ZYGOTE_N_FDS; i++) {
+        close(fds[i]);
+      }
+      sendReply(sock, ZYGOTE_STARTED, -1, EINVAL, 0, NULL);
+      continue;
+    }
+
+    pid_t pid = fork();
+    if(pid == 0) {
+      close(sock);
+      close(pfd[1].fd);
+      execRequest(message, n, fds, &chld);
+    }
+    for(int i = 0; i < ZYGOTE_N_FDS; i++) {
+      close(fds[i]);
+    }
+    sendReply(sock, ZYGOTE_STARTED, pid, pid < 0 ? errno : 0, 0, NULL);
+  }
+}
+
+//Forks the zygote
+void startZygote() {
+  int sv[2];
+
+  if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) != 0) {
+    perror("socketpair");
+    return;
+  }
+  pid_t pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    close(sv[0]);
+    close(sv[1]);
+    return;
+  }
+  if(pid == 0) {
+    close(sv[0]);
+    runZygote(sv[1]);
+  }
+  close(sv[1]);
+  zygote_sock = sv[0];
+  owner_pid = getpid();
+
+  //Keep the environment the zygote has, to send only what changes
+  int n = 0;
+  while(environ[n] != NULL) {
+    n++;
+  }
+  base_env = (char **) malloc((n + 1) * sizeof(char *));
+  if(base_env == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  for(int i = 0; i < n; i++) {
+    base_env[i] = strdup(environ[i]);
+  }
+  base_env[n] = NULL;
+}
+
+//Returns 1 if the shell may start commands through the zygote
+int zygoteRunning() {
+  return zygote_sock >= 0 && getpid() == owner_pid;
+}
+
+//Returns 1 if the list holds a string equal to s, or with the name of s if len is not 0
+static int inEnv(char **list, char *s, size_t len) {
+  for(int i = 0; list[i] != NULL; i++) {
+    if(len == 0 ? strcmp(list[i], s) == 0 : strncmp(list[i], s, len) == 0 && list[i][len] == '=') {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Appends a string to the message, returns -1 if it does not fit
+static int addString(size_t *used, char *s) {
+  size_t len = strlen(s) + 1;
+
+  if(*used + len > sizeof(message)) {
+    return -1;
+  }
+  memcpy(message + *used, s, len);
+  *used += len;
+
+  return 0;
+}
+
+//Reads a reply of the zygote and keeps the status of a command that has exited
+//Returns the reply, or -1 if the zygote has gone
+static int readReply(ZygoteReply *reply) {
+  ssize_t n;
+
+  while((n = recv(zygote_sock, reply, sizeof(ZygoteReply), 0)) < 0 && errno == EINTR) {
+  }
+  if(n != sizeof(ZygoteReply)) {
+    close(zygote_sock);
+    zygote_sock = -1;
+    return -1;
+  }
+  if(reply->type == ZYGOTE_EXITED) {
+    for(int i = 0; i < ZYGOTE_MAX_CHILDREN; i++) {
+      if(children[i].pid == reply->pid) {
+        children[i].exited = 1;
+        children[i].status = reply->status;
+        children[i].ru = reply->ru;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//Starts path with argv through the zygote, with stdin and stdout replaced if they are not -1
+pid_t zygoteSpawn(char *path, char *argv[], int stdin_fd, int stdout_fd) {
+  ZygoteRequest *request = (ZygoteRequest *) message;
+  ZygoteReply reply;
+  int slot = -1;
+  size_t used = sizeof(ZygoteRequest);
+
+  if(!zygoteRunning()) {
+    return -1;
+  }
+  for(int i = 0; i < ZYGOTE_MAX_CHILDREN && slot < 0; i++) {
+    if(children[i].pid == 0) {
+      slot = i;
+    }
+  }
+  if(slot < 0) {
+    return -1;
+  }
+
+  //The path name, argv, then the variables set and unset since the zygote started
+  request->n_argv = 0;
+  request->n_env = 0;
+  if(addString(&used, path) < 0) {
+    return -1;
+  }
+  for(int i = 0; argv[i] != NULL; i++, request->n_argv++) {
+    if(addString(&used, argv[i]) < 0) {
+      return -1;
+    }
+  }
+  for(int i = 0; environ[i] != NULL; i++) {
+    if(!inEnv(base_env, environ[i], 0)) {
+      if(addString(&used, environ[i]) < 0) {
+        return -1;
+      }
+      request->n_env++;
+    }
+  }
+  for(int i = 0; base_env[i] != NULL; i++) {
+    size_t len = strcspn(base_env[i], "=");
+    if(!inEnv(environ, base_env[i], len)) {
+      if(used + len + 1 > sizeof(message)) {
+        return -1;
+      }
+      memcpy(message + used, base_env[i], len);
+      message[used + len] = '\0';
+      used += len + 1;
+      request->n_env++;
+    }
+  }
+
+  int cwd_fd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+  if(cwd_fd < 0) {
+    return -1;
+  }
+  int fds[ZYGOTE_N_FDS] = {stdin_fd >= 0 ? stdin_fd : STDIN_FILENO, stdout_fd >= 0 ? stdout_fd : STDOUT_FILENO, STDERR_FILENO, cwd_fd};
+  union {
+    char buf[CMSG_SPACE(sizeof(fds))];
+    struct cmsghdr align;
+  } control;
+  struct iovec iov = {message, used};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  fflush(stdout); //what the shell printed goes before the output of the command
+  ssize_t n;
+  while((n = sendmsg(zygote_sock, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+  }
+  close(cwd_fd);
+  if(n < 0) {
+    close(zygote_sock);
+    zygote_sock = -1;
+    return -1;
+  }
+
+  //Replies about earlier commands may come first
+  do {
+    if(readReply(&reply) < 0) {
+      return -1;
+    }
+  } while(reply.type != ZYGOTE_STARTED);
+  if(reply.pid < 0) {
+    return -1;
+  }
+  children[slot].pid = reply.pid;
+  children[slot].exited = 0;
+
+  return reply.pid;
+}
+
+//Returns 1 if pid was started by the zygote and not waited for yet
+int isZygoteChild(pid_t pid) {
+  for(int i = 0; i < ZYGOTE_MAX_CHILDREN; i++) {
+    if(children[i].pid == pid && pid > 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//Waits for a command started by the zygote to exit
+int waitZygoteChild(pid_t pid, int *status, struct rusage *ru) {
+  ZygoteReply reply;
+
+  for(int i = 0; i < ZYGOTE_MAX_CHILDREN; i++) {
+    if(children[i].pid == pid) {
+      while(!children[i].exited) {
+        if(readReply(&reply) < 0) {
+          children[i].pid = 0;
+          return -1;
+        }
+      }
+      *status = children[i].status;
+      *ru = children[i].ru;
+      children[i].pid = 0;
+      return 0;
+    }
+  }
+
+  return -1;
+}
@@ -0,0 +1,47 @@
+/*
+ * File:	zygote.h
+ * Author:	Melvin Sim
+ * Date:	19 Oct 2026
+ */
+
+/* Purpose:	A small helper process, the zygote, forked when the shell
+		starts with --zygote, before the shell has grown, which
+		forks and execs commands for the shell, so that starting a
+		command does not copy the page tables of the whole shell.
+
+   Return:	1) zygoteSpawn() returns the pid of the command, or -1 if
+		   the zygote cannot start it and the shell must fork it.
+		2) isZygoteChild() returns 1 if pid was started by
+		   zygoteSpawn() and not waited for yet.
+		3) waitZygoteChild() returns 0 and stores the status and
+		   rusage of the command once it has exited, or -1 if the
+		   zygote has gone.
+
+   Note:	1) The shell and the zygote talk over a SOCK_SEQPACKET
+		   socketpair, one message per request or reply. A request
+		   holds the full path name of the program, argv, and the
+		   environment variables that differ from the ones the
+		   zygote started with, "NAME=value" to set and "NAME" to
+		   unset. Standard input, output and error and the current
+		   directory of the shell are passed as file descriptors
+		   with SCM_RIGHTS.
+		2) The zygote replies with the pid, and again with the
+		   status and rusage from wait4() when the command exits.
+		   waitChild() waits for these instead of calling wait4().
+		3) The zygote blocks the signals the shell blocks, and its
+		   commands start with the same signal mask as the
+		   commands the shell forks.
+		4) Only the shell process itself uses the zygote, not its
+		   subshells, and only for foreground commands. A request
+		   that does not fit in ZYGOTE_MSG_SIZE is forked by the
+		   shell.
+*/
+
+#define ZYGOTE_MSG_SIZE (64 * 1024)
+#define ZYGOTE_MAX_CHILDREN 64 //commands started and not waited for
+
+void startZygote();
+int zygoteRunning();
+pid_t zygoteSpawn(char *path, char *argv[], int stdin_fd, int stdout_fd);
+int isZygoteChild(pid_t pid);
+int waitZygoteChild(pid_t pid, int *status, struct rusage *ru);